@@ -8,25 +8,75 @@
 //        ├─ Middle Content (flex-grow, column direction)
 //        │    ├─ Top Section (flex-grow)
 //        │    ├─ Middle Divider (horizontal resize handle)
-//        │    └─ Bottom Section (flex-grow)
+//        │    └─ Bottom Section (flex-grow, virtualized log list)
 //        ├─ Right Divider (vertical resize handle)
 //        └─ Right Sidebar (320px default, resizable, properties)
 //   └─ Debug Overlay (mouse/input state display)
 //
 // This demonstrates:
-// - Helper functions (UI_BeginPanel, UI_Panel_Resizable, UI_Divider)
+// - A compile-time static layout (UI_Static_Panel table) with dynamic content slots
 // - Resizable dividers with persistent sizing
 // - Nested layouts (row within column)
 // - Buttons and labels
+// - Retained blocks for static content (UI_Begin_Cached)
+// - Offscreen bitmap caching of a static panel (UI_Panel_Set_Cache_Bitmap)
+// - Virtualized scrolling list (UI_Begin_List / UI_List_Row)
 //
 #include "app_ui.h"
 
-// Forward declarations
+// Dynamic content positions in g_app_layout
+enum App_Slot {
+	APP_SLOT_LEFT,
+	APP_SLOT_MID_TITLE,
+	APP_SLOT_MID_TOP,
+	APP_SLOT_MID_BOTTOM,
+	APP_SLOT_RIGHT,
+	APP_SLOT_OVERLAYS
+};
+
+// Static panel tree: IDs, styles and topology resolved by the compiler
+static constexpr UI_Static_Panel g_app_layout[] = {
+	UI_Static_Box(0, "root", UI_DIRECTION_COLUMN, -1, -1, 8, 0, 0xFF111115),
+		UI_Static_Box(1, "main", UI_DIRECTION_ROW, -1, -1, 0, 0, 0, 1.0f),
+			UI_Static_Resizable(2, "left", UI_DIRECTION_COLUMN, 240, -1, 12, 8, 0xFF22222A),
+				UI_Static_Slot(3, APP_SLOT_LEFT),
+			UI_Static_Divider(2, "left_div", UI_DIVIDER_VERTICAL),
+			UI_Static_Resizable(2, "mid", UI_DIRECTION_COLUMN, -2, -1, 8, 8, 0xFF1A1A20),
+				UI_Static_Slot(3, APP_SLOT_MID_TITLE),
+				UI_Static_Resizable(3, "mid_top", UI_DIRECTION_COLUMN, -2, -2, 12, 8, 0x44FFFFFF),
+					UI_Static_Slot(4, APP_SLOT_MID_TOP),
+				UI_Static_Divider(3, "mid_div", UI_DIVIDER_HORIZONTAL),
+				UI_Static_Resizable(3, "mid_bottom", UI_DIRECTION_COLUMN, -2, -2, 12, 4, 0x44FFFFFF),
+					UI_Static_Slot(4, APP_SLOT_MID_BOTTOM),
+			UI_Static_Divider(2, "right_div", UI_DIVIDER_VERTICAL),
+			UI_Static_Resizable(2, "right", UI_DIRECTION_COLUMN, 320, -1, 12, 4, 0xFF22222A),
+				UI_Static_Slot(3, APP_SLOT_RIGHT),
+		UI_Static_Slot(1, APP_SLOT_OVERLAYS),
+};
+static_assert(UI_Static_Layout_Valid(g_app_layout), "g_app_layout: bad depths or repeated panel names");
+static_assert(UI_STATIC_ID("left") == g_app_layout[2].id, "UI_Hash_Const is not compile-time");
+
+// Slot contents
 static void App_Sidebar_Left(UI_Context *ui);
-static void App_Content_Area(UI_Context *ui);
-static void App_Sidebar_Right(UI_Context *ui);
 static void App_Content_Top(UI_Context *ui);
 static void App_Content_Bottom(UI_Context *ui);
+static void App_Sidebar_Right(UI_Context *ui);
+static void App_Overlays(UI_Context *ui);
+
+
+// .............................................................................................
+static void
+App_Fill_Slot(UI_Context *ui, int slot, void * /*user*/)
+{
+	switch (slot) {
+		case APP_SLOT_LEFT:       App_Sidebar_Left(ui); break;
+		case APP_SLOT_MID_TITLE:  UI_Label(ui, "Main Content Area", 0xFFFFFFFF); break;
+		case APP_SLOT_MID_TOP:    App_Content_Top(ui); break;
+		case APP_SLOT_MID_BOTTOM: App_Content_Bottom(ui); break;
+		case APP_SLOT_RIGHT:      App_Sidebar_Right(ui); break;
+		case APP_SLOT_OVERLAYS:   App_Overlays(ui); break;
+	}
+}
 
 
 // .............................................................................................
@@ -34,70 +84,47 @@ static void App_Content_Bottom(UI_Context *ui);
 void
 App_UI_Build(UI_Context *ui)
 {
-	// Root panel
-	UI_BeginPanel(ui, "root", UI_DIRECTION_COLUMN, -1, -1, 8, 0, 0xFF111115);
-	{
-		// Main content area (3-column layout)
-		UI_BeginPanel(ui, "main", UI_DIRECTION_ROW, -1, -1, 0, 0, 0);
-		UI_Panel_Set_Grow(ui, 1.0f);
-		{
-			App_Sidebar_Left(ui);
-			UI_Divider(ui, "left_div", UI_DIVIDER_VERTICAL);
-			App_Content_Area(ui);
-			UI_Divider(ui, "right_div", UI_DIVIDER_VERTICAL);
-			App_Sidebar_Right(ui);
-		}
-		UI_End_Panel(ui);
-		
-		// Debug overlay
-		UI_Debug_Mouse_Overlay(ui);
-	}
-	UI_End_Panel(ui);
+	UI_Build_Static(ui, g_app_layout, App_Fill_Slot, NULL);
 }
 
 
 // .............................................................................................
 static void
-App_Sidebar_Left(UI_Context *ui)
+App_Overlays(UI_Context *ui)
 {
-	UI_Panel_Resizable(ui, "left", UI_DIRECTION_COLUMN, 240, -1, 12, 8, 0xFF22222A);
-	{
-		UI_Label(ui, "Actions", 0xFFFFFFFF);
-		
-		if (UI_Button(ui, "Save")) {
-			// Save button clicked
-		}
-		
-		if (UI_Button(ui, "Load")) {
-			// Load button clicked
-		}
-		
-		if (UI_Button(ui, "Reset")) {
-			// Reset button clicked
-		}
-		
-		UI_Label(ui, "", 0xFF000000);  // Spacer
-		UI_Label(ui, "Settings", 0xFFFFFFFF);
-		UI_Label(ui, "Graphics", 0xFFAAAAAA);
-		UI_Label(ui, "Audio", 0xFFAAAAAA);
+	// Debug overlay
+	UI_Debug_Mouse_Overlay(ui);
+	
+	// Frame statistics overlay (F2 toggles)
+	if (UI_Is_Key_Pressed(ui, 0x71)) {  // VK_F2
+		ui->frame_stats.overlay_visible = !ui->frame_stats.overlay_visible;
 	}
-	UI_End_Panel(ui);
+	if (ui->frame_stats.overlay_visible) UI_Frame_Stats_Overlay(ui);
 }
 
 
 // .............................................................................................
 static void
-App_Content_Area(UI_Context *ui)
+App_Sidebar_Left(UI_Context *ui)
 {
-	UI_Panel_Resizable(ui, "mid", UI_DIRECTION_COLUMN, -2, -1, 8, 8, 0xFF1A1A20);
-	{
-		UI_Label(ui, "Main Content Area", 0xFFFFFFFF);
-		
-		App_Content_Top(ui);
-		UI_Divider(ui, "mid_div", UI_DIVIDER_HORIZONTAL);
-		App_Content_Bottom(ui);
+	UI_Label(ui, "Actions", 0xFFFFFFFF);
+	
+	if (UI_Button(ui, "Save")) {
+		// Save button clicked
+	}
+	
+	if (UI_Button(ui, "Load")) {
+		// Load button clicked
+	}
+	
+	if (UI_Button(ui, "Reset")) {
+		// Reset button clicked
 	}
-	UI_End_Panel(ui);
+	
+	UI_Label(ui, "", 0xFF000000);  // Spacer
+	UI_Label(ui, "Settings", 0xFFFFFFFF);
+	UI_Label(ui, "Graphics", 0xFFAAAAAA);
+	UI_Label(ui, "Audio", 0xFFAAAAAA);
 }
 
 
@@ -105,17 +132,13 @@ App_Content_Area(UI_Context *ui)
 static void
 App_Content_Top(UI_Context *ui)
 {
-	UI_Panel_Resizable(ui, "mid_top", UI_DIRECTION_COLUMN, -2, -2, 12, 8, 0x44FFFFFF);
-	{
-		UI_Label(ui, "Top Section", 0xFFFFFFFF);
-		
-		if (UI_Button(ui, "Click Me!")) {
-			// Button clicked
-		}
-		
-		UI_Label(ui, "Hover over buttons to see effects", 0xFFAAAAAA);
+	UI_Label(ui, "Top Section", 0xFFFFFFFF);
+	
+	if (UI_Button(ui, "Click Me!")) {
+		// Button clicked
 	}
-	UI_End_Panel(ui);
+	
+	UI_Label(ui, "Hover over buttons to see effects", 0xFFAAAAAA);
 }
 
 
@@ -123,12 +146,18 @@ App_Content_Top(UI_Context *ui)
 static void
 App_Content_Bottom(UI_Context *ui)
 {
-	UI_Panel_Resizable(ui, "mid_bottom", UI_DIRECTION_COLUMN, -2, -2, 12, 4, 0x44FFFFFF);
-	{
-		UI_Label(ui, "Bottom Section", 0xFFFFFFFF);
-		UI_Label(ui, "Press mouse buttons and watch the debug overlay", 0xFFAAAAAA);
+	UI_Label(ui, "Bottom Section", 0xFFFFFFFF);
+	UI_Label(ui, "Press mouse buttons and watch the debug overlay", 0xFFAAAAAA);
+	
+	// Virtualized log: only the visible rows are built (scroll with the mouse wheel)
+	UI_Begin_List(ui, "log", 100000, 18);
+	int row;
+	while (UI_List_Row(ui, &row)) {
+		char line[64];
+		snprintf(line, sizeof(line), "Log line %d", row);
+		UI_Label(ui, line, (row & 1) ? 0xFF888888 : 0xFFAAAAAA);
 	}
-	UI_End_Panel(ui);
+	UI_End_List(ui);
 }
 
 
@@ -136,12 +165,14 @@ App_Content_Bottom(UI_Context *ui)
 static void
 App_Sidebar_Right(UI_Context *ui)
 {
-	UI_Panel_Resizable(ui, "right", UI_DIRECTION_COLUMN, 320, -1, 12, 4, 0xFF22222A);
-	{
+	UI_Panel_Set_Cache_Bitmap(ui, 1);  // Static content: drawn from one cached bitmap
+	
+	// Static labels: built once and replayed until the version changes
+	if (UI_Begin_Cached(ui, "props", 0)) {
 		UI_Label(ui, "Properties", 0xFFFFFFFF);
 		UI_Label(ui, "Width: 1920", 0xFFAAAAAA);
 		UI_Label(ui, "Height: 1080", 0xFFAAAAAA);
 		UI_Label(ui, "DPI: 300", 0xFFAAAAAA);
 	}
-	UI_End_Panel(ui);
+	UI_End_Cached(ui);
 }
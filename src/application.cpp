@@ -5,23 +5,33 @@
 // ARCHITECTURE:
 // - Continuous rendering loop at 120 FPS with precise frame pacing
 // - Full mouse and keyboard input forwarded to UI system
-// - Direct2D for hardware-accelerated 2D rendering
+// - Direct2D for hardware-accelerated 2D rendering: an HWND render target, or with
+//   --present=flip a device context over a flip-model DXGI swap chain
 // - DirectWrite for text rendering with UTF-8 support
-// - Text format caching for performance (16 font sizes max)
+// - Text format caching for performance (hashed by size, style and alignment)
 //
 // FRAME LOOP:
 // 1. Process Windows messages (non-blocking)
 // 2. Render UI (build → layout → interaction → emit → draw)
-// 3. Wait for target frame time (busy-wait for precision)
+//    Draw is skipped when the render list hash matches the previous frame, and limited
+//    to the changed region with --render=dirty (see Draw_Render_List)
+// 3. Wait for next frame (pacing policy: busy-wait, waitable timer, DWM vsync or idle)
 //
 #include <windows.h>
 #include <windowsx.h>
 #include <d2d1.h>
+#include <d2d1_1.h>
+#include <d3d11.h>
+#include <dxgi1_3.h>
 #include <dwrite.h>
+#include <dwmapi.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
 #include "profiling.h"
 #include "ui.cpp"
+#include "task_pool.cpp"
 #include "app_ui.h"
 
 bool g_is_running;
@@ -34,7 +44,8 @@ HCURSOR g_cursor_size_ns = NULL;  // Vertical resize ↕
 HCURSOR g_current_cursor = NULL;
 
 ID2D1Factory *p_d2d_factory;
-ID2D1HwndRenderTarget *p_render_target;
+ID2D1RenderTarget *p_render_target;      // p_hwnd_target or g_swap_chain.context
+ID2D1HwndRenderTarget *p_hwnd_target;    // NULL while the swap chain backend is active
 ID2D1SolidColorBrush *p_brush;
 
 // DirectWrite resources
@@ -42,19 +53,260 @@ IDWriteFactory *p_dwrite_factory;
 IDWriteTextFormat *p_text_format_default;
 IDWriteTextFormat *p_text_format_monospace;  // 14pt Consolas/Courier New
 
-// Text format cache (for performance)
+// Text format cache: open-addressing table keyed by (size, style bits, alignment)
+// Alignment is part of the key and set once at creation, so a cached format is never
+// mutated after it is handed out. The table doubles at 50% load and has no cap.
+struct Text_Format_Entry {
+	IDWriteTextFormat *format;   // NULL = empty slot
+	int font_size;
+	int font_style;              // UI_FONT_* bits (family, weight, italic)
+	int align_h;
+	int align_v;
+};
+
 struct Text_Format_Cache {
-	IDWriteTextFormat *formats[APP_MAX_TEXT_FORMATS];
-	int sizes[APP_MAX_TEXT_FORMATS];
-	int styles[APP_MAX_TEXT_FORMATS];  // 0=Segoe UI, 1=monospace
+	Text_Format_Entry *entries;
+	int capacity;                // Power of two, 0 until the first format
 	int count;
+	int failures;                // Creations that failed (lookup returned a default format)
 };
 Text_Format_Cache g_text_format_cache;
 
+// Text measurement cache (LRU, keyed by string + font size + style)
+// Labels are measured every frame but their text rarely changes, so the DirectWrite
+// layout is only created on a miss. Buckets chain entries by key, the LRU list orders
+// entries by last use so the tail is evicted when the cache is full. Entries own a copy
+// of their text and compare it on a hit, so colliding hashes never share a size.
+struct Text_Measure_Entry {
+	UI_Id hash;          // UI_HashString of the text
+	int length;
+	char *text;          // Owned copy (length bytes + NUL)
+	int font_size;
+	int font_style;      // 0=Segoe UI, 1=monospace
+	UI_RectI size;
+	int bucket_next;     // Next entry in same bucket (-1 = end of chain)
+	int lru_prev;        // Toward most recently used (-1 = head)
+	int lru_next;        // Toward least recently used (-1 = tail)
+};
+
+struct Text_Measure_Cache {
+	Text_Measure_Entry entries[APP_TEXT_MEASURE_CACHE_CAPACITY];
+	int buckets[APP_TEXT_MEASURE_CACHE_BUCKETS];
+	int count;
+	int lru_head;
+	int lru_tail;
+	
+	// Statistics
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+};
+Text_Measure_Cache g_text_measure_cache;
+
+// Retained text layout cache (keyed by string + format + box size + alignment)
+// Render_UI_Text draws cached IDWriteTextLayouts with DrawTextLayout so unchanged labels
+// skip the UTF-16 conversion and DirectWrite layout work. Entries that are not drawn for
+// APP_TEXT_LAYOUT_EVICT_FRAMES frames are released. Like the measurement cache, entries
+// own a copy of their text and compare it on a hit.
+struct Text_Layout_Entry {
+	IDWriteTextLayout *layout;
+	IDWriteTextFormat *format;
+	UI_Id hash;
+	int length;
+	char *text;          // Owned copy (length bytes + NUL)
+	int w, h;
+	int align_h, align_v;
+	int last_used_frame;
+	int bucket_next;     // Next entry in same bucket, or next free slot (-1 = end)
+};
+
+struct Text_Layout_Cache {
+	Text_Layout_Entry entries[APP_TEXT_LAYOUT_CACHE_CAPACITY];
+	int buckets[APP_TEXT_LAYOUT_CACHE_BUCKETS];
+	int free_list;
+	int count;           // Slots ever used (high-water mark)
+	int live_count;
+	int frame;
+	
+	// Statistics
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t uncached_draws;  // Drawn with DrawText because the cache was full
+};
+Text_Layout_Cache g_text_layout_cache;
+
+// Glyph atlas text backend (--text=atlas)
+// The printable ASCII glyphs of each text format are rasterized once with DrawGlyphRun
+// into an A8 bitmap, one cell per glyph with the baseline on a whole DIP. A text is then
+// drawn as one FillOpacityMask quad per glyph from that bitmap (Direct2D batches them
+// while the bitmap and brush stay the same) instead of a DirectWrite layout. Texts with
+// other characters, or wider than their box (a layout would wrap them), take the layout
+// path. Pen positions are snapped to whole DIPs and there is no kerning, so atlas text
+// can differ from layout text by a pixel here and there.
+struct Glyph_Atlas {
+	IDWriteTextFormat *format;    // Key only (formats outlive the atlases)
+	ID2D1BitmapRenderTarget *target;
+	ID2D1Bitmap *bitmap;          // NULL if the atlas could not be built (always falls back)
+	float advances[APP_GLYPH_ATLAS_GLYPHS];
+	int cell_w, cell_h;
+	int columns;
+	int pad;                      // Blank DIPs left of each glyph origin (overhangs)
+	int baseline;                 // Baseline offset from the cell top
+	float ascent;
+	float line_height;
+};
+
+struct Glyph_Atlas_Cache {
+	int enabled;
+	Glyph_Atlas atlases[APP_MAX_GLYPH_ATLASES];
+	int count;
+	
+	// Statistics
+	uint64_t texts;               // Texts drawn from an atlas
+	uint64_t glyphs;
+	uint64_t fallbacks;           // Texts the atlas could not draw (layout path)
+};
+Glyph_Atlas_Cache g_glyph_atlas_cache;
+
+// Solid color brush cache (one brush per ARGB color, so batched fills never call SetColor)
+struct Color_Brush_Cache {
+	ID2D1SolidColorBrush *brushes[APP_MAX_COLOR_BRUSHES];
+	uint32_t colors[APP_MAX_COLOR_BRUSHES];
+	int last_used_frame[APP_MAX_COLOR_BRUSHES];
+	int count;
+	int frame;
+};
+Color_Brush_Cache g_color_brush_cache;
+
+// Rectangle batching scratch (rebuilt every frame)
+// Rects are grouped by color; a rect may only join an earlier batch if it does not
+// overlap anything drawn in between, so overdraw order is preserved.
+struct Rect_Batch {
+	uint32_t color;
+	int first_rect;       // Index into render list rectangles
+	int last_rect;
+	int left, top, right, bottom;  // Bounds of all rects in the batch
+};
+
+struct Rect_Batcher {
+	Rect_Batch *batches;     // Grown to match the render list's rectangle capacity
+	int *rect_next;          // Next rect in same batch (-1 = end)
+	int capacity;
+	int batch_count;
+	
+	// Statistics (last frame)
+	int rects_drawn;
+	int batches_drawn;
+};
+Rect_Batcher g_rect_batcher;
+
+// Offscreen bitmap cache (panels flagged with UI_Panel_Set_Cache_Bitmap)
+// Each UI_Cache_Group of the render list is drawn once into a compatible bitmap render
+// target and then blitted with a single DrawBitmap while its id, size and content hash are
+// unchanged. Bitmaps are evicted least recently used to stay within budget_bytes. A group
+// is drawn directly when later primitives overlap it (the blit happens after all rects, so
+// it would otherwise cover them).
+struct Bitmap_Cache_Entry {
+	ID2D1BitmapRenderTarget *target;
+	ID2D1Bitmap *bitmap;
+	UI_Id id;
+	uint32_t content_hash;
+	int w, h;
+	int bytes;
+	int last_used_frame;
+};
+
+struct Bitmap_Cache {
+	Bitmap_Cache_Entry entries[APP_MAX_CACHED_BITMAPS];
+	int count;
+	int bytes_used;
+	int budget_bytes;
+	int frame;
+	
+	// Per-group state for the current frame (index into entries, -1 = draw directly)
+	int *group_entry;
+	int group_capacity;
+	int group_count;
+	
+	// Statistics
+	uint64_t hits;
+	uint64_t renders;
+	uint64_t evictions;
+	uint64_t overlapped;     // Groups drawn directly because later primitives overlap them
+	int blits;               // Groups drawn from a bitmap last frame
+};
+Bitmap_Cache g_bitmap_cache;
+
+// Frame render list (storage persists across frames, reset by UI_Begin_Frame)
+UI_Render_List g_render_list_storage;
+
+// Build/render pipeline (--pipeline)
+// A worker thread runs the UI frame (build, layout, interaction, emit) for frame N+1 into
+// the back render list while the main thread submits frame N to Direct2D. Input is only
+// touched while the worker is idle (messages are pumped between frames), so the worker
+// sees a consistent snapshot. The main thread waits for every build before the next
+// kick, which bounds the added latency to exactly one frame. Direct2D stays on the main
+// thread, so the single-threaded factory is kept.
+struct App_Pipeline {
+	int enabled;
+	HANDLE thread;
+	HANDLE kick_event;             // Main -> worker: build lists[back]
+	HANDLE done_event;             // Worker -> main: build finished
+	volatile LONG quit;
+	
+	UI_Render_List lists[2];
+	int built_w[2], built_h[2];    // Client size each list was built for
+	LARGE_INTEGER snapshot_time[2];  // Input snapshot (kick) time of each list
+	UI_Frame_Sample samples[2];    // Phase timings of each list (draw added when drawn)
+	int front;                     // List drawn this frame
+	int has_front;                 // 0 until the first build finished
+	
+	// Job for the worker (written before kick_event)
+	int job_list;
+	float job_delta_time_ms;
+	float job_input_latency_ms;    // g_latency.avg_ms at the kick (the main thread updates it while drawing)
+	HCURSOR job_cursor;            // Result: cursor chosen by the frame's interaction
+};
+App_Pipeline g_pipeline;
+
+// Input-to-present latency (both modes; the pipeline adds one frame)
+struct App_Latency_Stats {
+	double last_ms;
+	double sum_ms;
+	double max_ms;
+	int samples;
+	
+	// Published every APP_LATENCY_WINDOW_FRAMES frames
+	double avg_ms;
+	double window_max_ms;
+};
+App_Latency_Stats g_latency;
+
+// Worker pool for parallel layout of large trees (--layout-threads=N, N > 1)
+Task_Pool g_layout_pool;
+
+// Guards g_text_format_cache and every CreateTextLayout from a cached format (measure runs
+// on the pipeline worker while the main thread draws)
+CRITICAL_SECTION g_text_format_lock;
+
 // Global UI context (for window message handler access)
 UI_Context g_ui_context;
 
 // Frame timing system
+// Pacing policies (select with --pacing=busy|timer|vsync|idle):
+// - BUSY_WAIT: QueryPerformanceCounter spin with Sleep(0), most precise, pins a core
+// - WAITABLE_TIMER: high-resolution waitable timer, sleeps until the target frame time
+// - DWM_VSYNC: DwmFlush blocks until the next desktop composition (monitor refresh rate)
+// - IDLE: capped like WAITABLE_TIMER, then blocks in MsgWaitForMultipleObjectsEx until
+//   input or invalidation arrives once the UI has settled
+enum Frame_Pacing_Mode {
+	FRAME_PACING_BUSY_WAIT = 0,
+	FRAME_PACING_WAITABLE_TIMER = 1,
+	FRAME_PACING_DWM_VSYNC = 2,
+	FRAME_PACING_IDLE = 3
+};
+
 struct Frame_Timer {
 	LARGE_INTEGER frequency;
 	LARGE_INTEGER frame_start;
@@ -65,435 +317,2615 @@ struct Frame_Timer {
 	int actual_fps;
 	double fps_update_timer;
 	int frame_count_for_fps;
+	
+	// Pacing policy
+	int pacing_mode;
+	HANDLE waitable_timer;
+	int timer_high_resolution;   // 0 if CREATE_WAITABLE_TIMER_HIGH_RESOLUTION is unsupported
+	int quiet_frames;            // Consecutive frames without window messages (idle mode)
+	int slept_for_input;         // Last wait blocked on input (excluded from jitter stats)
+	
+	// Jitter accumulators (current one-second window)
+	double jitter_sum_ms;        // Sum of (frame time - target)
+	double jitter_abs_sum_ms;
+	double frame_time_sum_ms;
+	double frame_time_sq_sum_ms;
+	double frame_time_max_ms;
+	int jitter_samples;
+	
+	// Jitter statistics (published once per second, alongside actual_fps)
+	double jitter_mean_ms;       // Mean lateness vs target (negative = early)
+	double jitter_abs_mean_ms;   // Mean absolute deviation from target
+	double jitter_stddev_ms;     // Standard deviation of frame time
+	double jitter_max_ms;        // Longest frame in the window
 };
 
 Frame_Timer g_frame_timer;
 
+// Frame skipping / dirty-region rendering
+// The render list is hashed after emit. When it matches the previous frame the whole
+// BeginDraw/EndDraw (and present) is skipped. In dirty-rect mode a changed frame with the
+// same primitive counts only redraws the union of changed primitives; this relies on
+// D2D1_PRESENT_OPTIONS_RETAIN_CONTENTS keeping the previous frame in the back buffer
+// (the swap chain backend keeps it in its canvas bitmap instead).
+enum App_Render_Mode {
+	APP_RENDER_ALWAYS = 0,           // Redraw every frame (original behavior)
+	APP_RENDER_SKIP_UNCHANGED = 1,   // Skip drawing when the render list hash is unchanged
+	APP_RENDER_DIRTY_RECTS = 2       // Skip unchanged frames and redraw only changed regions
+};
+
+struct Render_Skip_State {
+	int mode;
+	int force_full_redraw;     // Set on resize/paint; next frame redraws everything
+	uint32_t prev_hash;
+	int prev_w, prev_h;
+	UI_Render_List prev_list;  // Last drawn list, deep copy (dirty-rect mode only)
+	UI_RectI last_dirty;
+	
+	// Statistics
+	uint64_t frames_skipped;
+	uint64_t frames_partial;
+	uint64_t frames_full;
+};
+Render_Skip_State g_render_skip;
+
+// Coalesced resizing (WM_SIZE during a drag)
+// WM_SIZE only records the new client size; the render target is resized once, right
+// before the next render, however many WM_SIZE messages arrived since the last one.
+// While the modal size loop runs (g_is_resizing), WM_PAINT renders at most once per DWM
+// composition tick; a paint inside a tick that already rendered arms APP_RESIZE_TIMER_ID
+// for the tick's trailing render instead. Swap chain buffers are reused when the window
+// shrinks and grow in APP_RESIZE_BUFFER_STEP steps (DXGI_SCALING_NONE crops the slack),
+// then fit exactly when the drag ends. With --resize=stretch the swap chain uses
+// DXGI_SCALING_STRETCH and exact buffers, so DWM stretches the last frame until the next
+// render catches up.
+struct App_Resize_State {
+	int pending;                  // Client size changed since the target was last sized
+	int pending_w, pending_h;
+	int stretch;                  // --resize=stretch
+	int timer_armed;
+	LARGE_INTEGER last_render;    // QPC time of the last render in the size loop
+	int last_render_w, last_render_h;
+	
+	// Statistics (since startup)
+	uint64_t size_messages;       // WM_SIZE received
+	uint64_t target_resizes;      // Render target / ResizeBuffers calls
+	uint64_t buffer_reuses;       // Size changes served by the current swap chain buffers
+	uint64_t paints;              // WM_PAINT (and trailing timer) during the size loop
+	uint64_t renders;             // Renders done for those
+	uint64_t coalesced;           // Paints folded into a tick that already rendered
+	uint64_t redundant_renders;   // Renders at the size the previous one already showed
+};
+App_Resize_State g_resize;
+
+// Warm-start snapshot (UI_Snapshot_*): saved to APP_SNAPSHOT_FILE next to the executable
+// on exit and mapped on the next startup. It restores divider sizes, the panels of the last
+// frame as the layout cache's previous frame, and the text measurements (only when the
+// fonts still measure the same, see App_Snapshot_Key), so the first frame neither lays out
+// unchanged subtrees nor creates DirectWrite layouts to measure labels.
+struct App_Snapshot_State {
+	int enabled;                  // Off with --snapshot=off
+	wchar_t path[MAX_PATH];
+	int loaded_bytes;             // Snapshot mapped at startup (0 = none or rejected)
+	int loaded_measures;
+	int saved_bytes;
+};
+App_Snapshot_State g_snapshot;
+
+// Flip-model presentation (--present=flip)
+// An ID2D1DeviceContext on a D3D11 device draws into a canvas bitmap that is copied to the
+// back buffer of a DXGI_SWAP_EFFECT_FLIP_DISCARD swap chain and shown with Present1.
+// Flip-discard buffers do not keep the previous frame, so the canvas stands in for
+// D2D1_PRESENT_OPTIONS_RETAIN_CONTENTS during dirty-rect redraws; the dirty rect also goes
+// to Present1 so DWM only recomposes that region. Render waits on the frame latency
+// waitable object (APP_SWAP_CHAIN_MAX_LATENCY queued frames) before sampling input, so
+// frames are built as late as the display allows. Any failure (no D3D11 or flip model,
+// lost device) falls back to the HWND render target.
+struct App_Swap_Chain {
+	int enabled;
+	HWND window;
+	ID3D11Device *d3d_device;
+	ID3D11DeviceContext *d3d_context;  // Flushed before ResizeBuffers (deferred releases)
+	IDXGISwapChain1 *swap_chain;
+	ID2D1Device *d2d_device;
+	ID2D1DeviceContext *context;
+	ID2D1Bitmap1 *back_buffer;         // Target bitmap over swap chain buffer 0
+	ID2D1Bitmap1 *canvas;              // Drawing target, keeps the last frame
+	HANDLE latency_waitable;           // NULL without IDXGISwapChain2 (no waiting)
+	int wait_pending;                  // Presented since the last wait
+	int flip_discard;                  // 0 = FLIP_SEQUENTIAL (before Windows 10)
+	int w, h;                          // Buffer size in pixels
+	float dpi_scale;                   // Pixels per DIP
+	
+	// Statistics
+	uint64_t presents_full;
+	uint64_t presents_partial;
+	double last_wait_ms;               // Time blocked on the latency waitable last frame
+};
+App_Swap_Chain g_swap_chain;
+
 
 // .............................................................................................
-IDWriteTextFormat*
-Get_Text_Format(int font_size, int font_style)
+static uint32_t
+Text_Format_Hash(int font_size, int font_style, int align_h, int align_v)
 {
-	// Check cache (must match BOTH size and style)
-	for (int i = 0; i < g_text_format_cache.count; i++) {
-		if (g_text_format_cache.sizes[i] == font_size && 
-		    g_text_format_cache.styles[i] == font_style) {
-			return g_text_format_cache.formats[i];
-		}
+	uint32_t key = (uint32_t)font_size * 0x9E3779B1u;
+	key ^= (uint32_t)font_style * 0x85EBCA77u;
+	key ^= (uint32_t)(align_h * 3 + align_v) * 0xC2B2AE3Du;
+	return key ^ (key >> 15);
+}
+
+
+// .............................................................................................
+// Insert without lookup (the key is known to be absent and a slot to be free)
+static void
+Text_Format_Cache_Insert(Text_Format_Cache *cache, const Text_Format_Entry *entry)
+{
+	uint32_t mask = (uint32_t)cache->capacity - 1;
+	uint32_t slot = Text_Format_Hash(entry->font_size, entry->font_style, entry->align_h, entry->align_v) & mask;
+	while (cache->entries[slot].format) slot = (slot + 1) & mask;
+	cache->entries[slot] = *entry;
+	cache->count++;
+}
+
+
+// .............................................................................................
+// Double the table (or allocate the first one). Returns 0 if out of memory.
+static int
+Text_Format_Cache_Grow(Text_Format_Cache *cache)
+{
+	int new_capacity = cache->capacity ? cache->capacity * 2 : APP_TEXT_FORMAT_CACHE_INITIAL;
+	Text_Format_Entry *entries = (Text_Format_Entry *)calloc(new_capacity, sizeof(Text_Format_Entry));
+	if (!entries) return 0;
+	
+	Text_Format_Entry *old_entries = cache->entries;
+	int old_capacity = cache->capacity;
+	cache->entries = entries;
+	cache->capacity = new_capacity;
+	cache->count = 0;
+	
+	for (int i = 0; i < old_capacity; i++) {
+		if (old_entries[i].format) Text_Format_Cache_Insert(cache, &old_entries[i]);
+	}
+	free(old_entries);
+	return 1;
+}
+
+
+// .............................................................................................
+void
+Text_Format_Cache_Release()
+{
+	Text_Format_Cache *cache = &g_text_format_cache;
+	for (int i = 0; i < cache->capacity; i++) {
+		if (cache->entries[i].format) cache->entries[i].format->Release();
 	}
+	free(cache->entries);
+	memset(cache, 0, sizeof(Text_Format_Cache));
+}
+
+
+// .............................................................................................
+static IDWriteTextFormat*
+Create_Text_Format(int font_size, int font_style, int align_h, int align_v)
+{
+	DWRITE_FONT_WEIGHT weight = DWRITE_FONT_WEIGHT_NORMAL;
+	int weight_bits = (font_style & UI_FONT_WEIGHT_MASK) >> UI_FONT_WEIGHT_SHIFT;
+	if (weight_bits > 0) weight = (DWRITE_FONT_WEIGHT)(weight_bits * 100);
 	
-	// Create new format if not cached
-	if (g_text_format_cache.count < APP_MAX_TEXT_FORMATS) {
-		IDWriteTextFormat *fmt;
-		
-		// Choose font family based on style
-		const wchar_t *font_family = L"Segoe UI";
-		if (font_style == 1) {
-			// Try Consolas first (common on Windows), fall back to Courier New
-			font_family = L"Consolas";
-		}
-		
-		HRESULT hr = p_dwrite_factory->CreateTextFormat(
-			font_family,
+	DWRITE_FONT_STYLE slant = (font_style & UI_FONT_ITALIC) ? DWRITE_FONT_STYLE_ITALIC : DWRITE_FONT_STYLE_NORMAL;
+	int monospace = (font_style & UI_FONT_FAMILY_MASK) == UI_FONT_MONOSPACE;
+	
+	// Try Consolas first (common on Windows), fall back to Courier New
+	IDWriteTextFormat *fmt = 0;
+	HRESULT hr = p_dwrite_factory->CreateTextFormat(
+		monospace ? L"Consolas" : L"Segoe UI",
+		NULL,
+		weight,
+		slant,
+		DWRITE_FONT_STRETCH_NORMAL,
+		(float)font_size,
+		L"en-us",
+		&fmt
+	);
+	
+	if (FAILED(hr) && monospace) {
+		hr = p_dwrite_factory->CreateTextFormat(
+			L"Courier New",
 			NULL,
-			DWRITE_FONT_WEIGHT_NORMAL,
-			DWRITE_FONT_STYLE_NORMAL,
+			weight,
+			slant,
 			DWRITE_FONT_STRETCH_NORMAL,
 			(float)font_size,
 			L"en-us",
 			&fmt
 		);
-		
-		// If Consolas failed, try Courier New
-		if (FAILED(hr) && font_style == 1) {
-			hr = p_dwrite_factory->CreateTextFormat(
-				L"Courier New",
-				NULL,
-				DWRITE_FONT_WEIGHT_NORMAL,
-				DWRITE_FONT_STYLE_NORMAL,
-				DWRITE_FONT_STRETCH_NORMAL,
-				(float)font_size,
-				L"en-us",
-				&fmt
-			);
-		}
-		
-		if (SUCCEEDED(hr)) {
-			int idx = g_text_format_cache.count++;
-			g_text_format_cache.formats[idx] = fmt;
-			g_text_format_cache.sizes[idx] = font_size;
-			g_text_format_cache.styles[idx] = font_style;
-			return fmt;
+	}
+	if (FAILED(hr)) return 0;
+	
+	DWRITE_TEXT_ALIGNMENT h_align;
+	if (align_h == UI_ALIGN_CENTER) h_align = DWRITE_TEXT_ALIGNMENT_CENTER;
+	else if (align_h == UI_ALIGN_END) h_align = DWRITE_TEXT_ALIGNMENT_TRAILING;
+	else h_align = DWRITE_TEXT_ALIGNMENT_LEADING;
+	
+	DWRITE_PARAGRAPH_ALIGNMENT v_align;
+	if (align_v == UI_ALIGN_CENTER) v_align = DWRITE_PARAGRAPH_ALIGNMENT_CENTER;
+	else if (align_v == UI_ALIGN_END) v_align = DWRITE_PARAGRAPH_ALIGNMENT_FAR;
+	else v_align = DWRITE_PARAGRAPH_ALIGNMENT_NEAR;
+	
+	fmt->SetTextAlignment(h_align);
+	fmt->SetParagraphAlignment(v_align);
+	return fmt;
+}
+
+
+// .............................................................................................
+static IDWriteTextFormat*
+Get_Text_Format_Locked(int font_size, int font_style, int align_h, int align_v)
+{
+	Text_Format_Cache *cache = &g_text_format_cache;
+	
+	if (cache->capacity) {
+		uint32_t mask = (uint32_t)cache->capacity - 1;
+		uint32_t slot = Text_Format_Hash(font_size, font_style, align_h, align_v) & mask;
+		for (; cache->entries[slot].format; slot = (slot + 1) & mask) {
+			const Text_Format_Entry *e = &cache->entries[slot];
+			if (e->font_size == font_size && e->font_style == font_style &&
+			    e->align_h == align_h && e->align_v == align_v) {
+				return e->format;
+			}
 		}
 	}
 	
-	return p_text_format_default;
+	// Keep the load factor at or below 50% so probe runs stay short
+	IDWriteTextFormat *fmt = 0;
+	if ((cache->count + 1) * 2 <= cache->capacity || Text_Format_Cache_Grow(cache)) {
+		fmt = Create_Text_Format(font_size, font_style, align_h, align_v);
+	}
+	
+	if (!fmt) {
+		cache->failures++;
+		int monospace = (font_style & UI_FONT_FAMILY_MASK) == UI_FONT_MONOSPACE;
+		return (monospace && p_text_format_monospace) ? p_text_format_monospace : p_text_format_default;
+	}
+	
+	Text_Format_Entry entry = { fmt, font_size, font_style, align_h, align_v };
+	Text_Format_Cache_Insert(cache, &entry);
+	return fmt;
 }
 
 
 // .............................................................................................
-UI_RectI
-App_Measure_Text(const char *text, int font_size)
+IDWriteTextFormat*
+Get_Text_Format_Aligned(int font_size, int font_style, int align_h, int align_v)
 {
-	if (!text || !p_dwrite_factory) {
-		UI_RectI empty = {0, 0, 0, 0};
-		return empty;
+	EnterCriticalSection(&g_text_format_lock);
+	IDWriteTextFormat *fmt = Get_Text_Format_Locked(font_size, font_style, align_h, align_v);
+	LeaveCriticalSection(&g_text_format_lock);
+	return fmt;
+}
+
+
+// .............................................................................................
+// Format for measuring and for atlas lookups (start/start alignment)
+IDWriteTextFormat*
+Get_Text_Format(int font_size, int font_style)
+{
+	return Get_Text_Format_Aligned(font_size, font_style, UI_ALIGN_START, UI_ALIGN_START);
+}
+
+
+// .............................................................................................
+void
+Text_Measure_Cache_Init()
+{
+	memset(&g_text_measure_cache, 0, sizeof(Text_Measure_Cache));
+	for (int i = 0; i < APP_TEXT_MEASURE_CACHE_BUCKETS; i++) {
+		g_text_measure_cache.buckets[i] = -1;
 	}
+	g_text_measure_cache.lru_head = -1;
+	g_text_measure_cache.lru_tail = -1;
+}
+
+
+// .............................................................................................
+void
+Text_Measure_Cache_Release()
+{
+	Text_Measure_Cache *cache = &g_text_measure_cache;
+	for (int i = 0; i < cache->count; i++) free(cache->entries[i].text);
+	Text_Measure_Cache_Init();
+}
+
+
+// .............................................................................................
+static int
+Text_Measure_Cache_Bucket(UI_Id hash, int length, int font_size, int font_style)
+{
+	uint32_t key = (uint32_t)hash;
+	key ^= (uint32_t)length * 0x9E3779B1u;
+	key ^= (uint32_t)font_size * 0x85EBCA77u;
+	key ^= (uint32_t)font_style * 0xC2B2AE3Du;
+	return (int)(key % APP_TEXT_MEASURE_CACHE_BUCKETS);
+}
+
+
+// .............................................................................................
+static void
+Text_Measure_Cache_Unlink_LRU(int idx)
+{
+	Text_Measure_Cache *cache = &g_text_measure_cache;
+	Text_Measure_Entry *e = &cache->entries[idx];
+	
+	if (e->lru_prev >= 0) cache->entries[e->lru_prev].lru_next = e->lru_next;
+	else cache->lru_head = e->lru_next;
+	
+	if (e->lru_next >= 0) cache->entries[e->lru_next].lru_prev = e->lru_prev;
+	else cache->lru_tail = e->lru_prev;
 	
+	e->lru_prev = -1;
+	e->lru_next = -1;
+}
+
+
+// .............................................................................................
+static void
+Text_Measure_Cache_Push_LRU(int idx)
+{
+	Text_Measure_Cache *cache = &g_text_measure_cache;
+	Text_Measure_Entry *e = &cache->entries[idx];
+	
+	e->lru_prev = -1;
+	e->lru_next = cache->lru_head;
+	if (cache->lru_head >= 0) cache->entries[cache->lru_head].lru_prev = idx;
+	cache->lru_head = idx;
+	if (cache->lru_tail < 0) cache->lru_tail = idx;
+}
+
+
+// .............................................................................................
+static void
+Text_Measure_Cache_Unlink_Bucket(int idx)
+{
+	Text_Measure_Cache *cache = &g_text_measure_cache;
+	Text_Measure_Entry *e = &cache->entries[idx];
+	int bucket = Text_Measure_Cache_Bucket(e->hash, e->length, e->font_size, e->font_style);
+	
+	int *link = &cache->buckets[bucket];
+	while (*link >= 0) {
+		if (*link == idx) {
+			*link = e->bucket_next;
+			break;
+		}
+		link = &cache->entries[*link].bucket_next;
+	}
+	e->bucket_next = -1;
+}
+
+
+// .............................................................................................
+// Measure text with DirectWrite (no caching). Returns 0 if the layout could not be created.
+static int
+App_Measure_Text_Uncached(const char *text, int font_size, int font_style, UI_RectI *out_size)
+{
 	// Convert UTF-8 to UTF-16
 	wchar_t wtext[MAX_UI_TEXT_LENGTH];
 	MultiByteToWideChar(CP_UTF8, 0, text, -1, wtext, MAX_UI_TEXT_LENGTH);
 	
-	// Get text format (default proportional font)
-	IDWriteTextFormat *fmt = Get_Text_Format(font_size, 0);
-	
-	// Create text layout for measurement
-	IDWriteTextLayout *layout;
-	HRESULT hr = p_dwrite_factory->CreateTextLayout(
-		wtext,
-		(UINT32)wcslen(wtext),
-		fmt,
-		10000.0f,  // Max width (large number for single-line)
-		10000.0f,  // Max height
-		&layout
-	);
-	
-	if (FAILED(hr)) {
-		UI_RectI fallback = {0, 0, 0, 20};
-		return fallback;
+	// Create text layout for measurement (the format is shared with the drawing thread)
+	EnterCriticalSection(&g_text_format_lock);
+	IDWriteTextFormat *fmt = Get_Text_Format_Locked(font_size, font_style, UI_ALIGN_START, UI_ALIGN_START);
+	IDWriteTextLayout *layout = 0;
+	HRESULT hr = E_FAIL;
+	if (fmt) {
+		hr = p_dwrite_factory->CreateTextLayout(
+			wtext,
+			(UINT32)wcslen(wtext),
+			fmt,
+			10000.0f,  // Max width (large number for single-line)
+			10000.0f,  // Max height
+			&layout
+		);
 	}
+	LeaveCriticalSection(&g_text_format_lock);
+	
+	if (FAILED(hr)) return 0;
 	
 	// Get metrics
 	DWRITE_TEXT_METRICS metrics;
 	layout->GetMetrics(&metrics);
 	layout->Release();
 	
-	UI_RectI result;
-	result.x = 0;
-	result.y = 0;
-	result.w = (int)(metrics.width + 0.5f);
-	result.h = (int)(metrics.height + 0.5f);
-	return result;
+	out_size->x = 0;
+	out_size->y = 0;
+	out_size->w = (int)(metrics.width + 0.5f);
+	out_size->h = (int)(metrics.height + 0.5f);
+	return 1;
 }
 
 
 // .............................................................................................
-UI_RectI
-App_Measure_Text_Monospace(const char *text, int font_size)
+// Add a measurement as the most recently used entry (the key must not be cached yet;
+// nothing is cached if the text copy cannot be allocated)
+static void
+Text_Measure_Cache_Insert(const char *text, int length, int font_size, int font_style, UI_RectI size)
 {
-	if (!text || !p_dwrite_factory) {
-		UI_RectI fallback;
-		memset(&fallback, 0, sizeof(UI_RectI));
-		fallback.w = 100;
-		fallback.h = 20;
-		return fallback;
+	Text_Measure_Cache *cache = &g_text_measure_cache;
+	UI_Id hash = UI_HashString(text);
+	int bucket = Text_Measure_Cache_Bucket(hash, length, font_size, font_style);
+	
+	char *copy = (char *)malloc(length + 1);
+	if (!copy) return;
+	memcpy(copy, text, length);
+	copy[length] = 0;
+	
+	// Take a free slot, or evict the least recently used entry
+	int idx;
+	if (cache->count < APP_TEXT_MEASURE_CACHE_CAPACITY) {
+		idx = cache->count++;
+	} else {
+		idx = cache->lru_tail;
+		Text_Measure_Cache_Unlink_LRU(idx);
+		Text_Measure_Cache_Unlink_Bucket(idx);
+		free(cache->entries[idx].text);
+		cache->evictions++;
 	}
 	
-	// Convert UTF-8 to UTF-16
-	wchar_t wtext[MAX_UI_TEXT_LENGTH];
-	MultiByteToWideChar(CP_UTF8, 0, text, -1, wtext, MAX_UI_TEXT_LENGTH);
+	Text_Measure_Entry *e = &cache->entries[idx];
+	e->hash = hash;
+	e->length = length;
+	e->text = copy;
+	e->font_size = font_size;
+	e->font_style = font_style;
+	e->size = size;
+	e->bucket_next = cache->buckets[bucket];
+	cache->buckets[bucket] = idx;
+	Text_Measure_Cache_Push_LRU(idx);
+}
+
+
+// .............................................................................................
+// Measure text through the LRU cache. Failed measurements are not cached so a transient
+// DirectWrite failure does not stick; the caller's fallback size is returned instead.
+static UI_RectI
+App_Measure_Text_Cached(const char *text, int font_size, int font_style, UI_RectI fallback)
+{
+	Text_Measure_Cache *cache = &g_text_measure_cache;
 	
-	// Get monospace text format (style=1)
-	IDWriteTextFormat *fmt = Get_Text_Format(font_size, 1);
-	if (!fmt) {
-		UI_RectI fallback;
-		memset(&fallback, 0, sizeof(UI_RectI));
-		fallback.w = 100;
-		fallback.h = 20;
-		return fallback;
+	UI_Id hash = UI_HashString(text);
+	int length = (int)strlen(text);
+	int bucket = Text_Measure_Cache_Bucket(hash, length, font_size, font_style);
+	
+	for (int i = cache->buckets[bucket]; i >= 0; i = cache->entries[i].bucket_next) {
+		Text_Measure_Entry *e = &cache->entries[i];
+		if (e->hash == hash && e->length == length && 
+		    e->font_size == font_size && e->font_style == font_style &&
+		    memcmp(e->text, text, length) == 0) {
+			cache->hits++;
+			if (cache->lru_head != i) {
+				Text_Measure_Cache_Unlink_LRU(i);
+				Text_Measure_Cache_Push_LRU(i);
+			}
+			return e->size;
+		}
 	}
 	
-	// Create text layout for measurement
-	IDWriteTextLayout *layout;
-	HRESULT hr = p_dwrite_factory->CreateTextLayout(
-		wtext,
-		(UINT32)wcslen(wtext),
-		fmt,
-		10000.0f,  // Max width (large number for single-line)
-		10000.0f,  // Max height
-		&layout
-	);
+	cache->misses++;
 	
-	if (FAILED(hr)) {
-		UI_RectI fallback;
-		memset(&fallback, 0, sizeof(UI_RectI));
-		fallback.w = 100;
-		fallback.h = 20;
+	UI_RectI size;
+	if (!App_Measure_Text_Uncached(text, font_size, font_style, &size)) {
 		return fallback;
 	}
 	
-	// Get metrics
-	DWRITE_TEXT_METRICS metrics;
-	layout->GetMetrics(&metrics);
-	layout->Release();
+	Text_Measure_Cache_Insert(text, length, font_size, font_style, size);
+	return size;
+}
+
+
+// .............................................................................................
+// Font style is UI_FONT_* bits (weight and italic change the measured width)
+UI_RectI
+App_Measure_Text(const char *text, int font_size, int font_style)
+{
+	if (!text || !p_dwrite_factory) {
+		UI_RectI empty = {0, 0, 0, 0};
+		return empty;
+	}
 	
-	UI_RectI result;
-	result.x = 0;
-	result.y = 0;
-	result.w = (int)(metrics.width + 0.5f);
-	result.h = (int)(metrics.height + 0.5f);
-	return result;
+	UI_RectI fallback = {0, 0, 0, 20};
+	return App_Measure_Text_Cached(text, font_size, font_style, fallback);
 }
 
 
 // .............................................................................................
-void
-Render_UI(UI_Render_List *render_list)
+UI_RectI
+App_Measure_Text_Monospace(const char *text, int font_size)
 {
-	PROFILE_ZONE;  // Auto-named "Render_UI"
+	UI_RectI fallback = {0, 0, 100, 20};
+	if (!text || !p_dwrite_factory) {
+		return fallback;
+	}
 	
-	for (int i = 0; i < render_list->rect_count; i++)
-	{
-		const UI_Rectangle *src = &render_list->rectangles[i];
-		
-		D2D1_RECT_F rect = D2D1::RectF(
-			(float)src->left,
-			(float)src->top,
-			(float)src->right,
-			(float)src->bottom
-		);
-		
-		uint32_t c = src->color;
-		
-		float a = ((c >> 24) & 0xFF) / 255.0f;
-		float r = ((c >> 16) & 0xFF) / 255.0f;
-		float g = ((c >>  8) & 0xFF) / 255.0f;
-		float b = ((c >>  0) & 0xFF) / 255.0f;
-		
-		// If your color is 0xAARRGGBB, use the byte-based ColorF:
-		p_brush->SetColor(D2D1::ColorF(r, g, b, a));
-		p_render_target->FillRectangle(rect, p_brush);
+	return App_Measure_Text_Cached(text, font_size, UI_FONT_MONOSPACE, fallback);
+}
+
+
+// .............................................................................................
+// Measurement environment: a probe string measured with both families (font versions,
+// substitution or DPI changes make stored measurements stale)
+static uint32_t
+App_Snapshot_Key()
+{
+	uint32_t key = 2166136261u;
+	for (int style = 0; style <= UI_FONT_MONOSPACE; style++) {
+		UI_RectI size = {0, 0, 0, 0};
+		App_Measure_Text_Uncached("Wg|0 Il.", 14, style, &size);
+		key = (key ^ (uint32_t)size.w) * 16777619u;
+		key = (key ^ (uint32_t)size.h) * 16777619u;
+	}
+	return key;
+}
+
+
+// .............................................................................................
+static void
+App_Snapshot_Init(const char *command_line)
+{
+	memset(&g_snapshot, 0, sizeof(App_Snapshot_State));
+	g_snapshot.enabled = !(command_line && strstr(command_line, "--snapshot=off"));
+	if (!g_snapshot.enabled) return;
+	
+	// Directory of the executable
+	DWORD length = GetModuleFileNameW(NULL, g_snapshot.path, MAX_PATH);
+	if (length == 0 || length >= MAX_PATH) {
+		g_snapshot.enabled = 0;
+		return;
+	}
+	while (length > 0 && g_snapshot.path[length - 1] != L'\\') length--;
+	if (length + wcslen(APP_SNAPSHOT_FILE) + 5 >= MAX_PATH) {  // Room for ".tmp" when saving
+		g_snapshot.enabled = 0;
+		return;
+	}
+	memcpy(g_snapshot.path + length, APP_SNAPSHOT_FILE, sizeof(APP_SNAPSHOT_FILE));
+}
+
+
+// .............................................................................................
+// Map the snapshot and restore it; a missing, foreign or damaged file is ignored
+static void
+App_Snapshot_Load()
+{
+	if (!g_snapshot.enabled) return;
+	
+	HANDLE file = CreateFileW(g_snapshot.path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+	                          FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) return;
+	
+	LARGE_INTEGER file_size;
+	HANDLE mapping = NULL;
+	const void *view = NULL;
+	if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 && file_size.QuadPart < 0x7FFFFFFF) {
+		mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping) view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+	
+	int size = view ? (int)file_size.QuadPart : 0;
+	if (view && UI_Snapshot_Load(&g_ui_context, view, size)) {
+		g_snapshot.loaded_bytes = size;
+		
+		UI_Snapshot_Header header;
+		memcpy(&header, view, sizeof(header));
+		int measures_size;
+		const unsigned char *measures = (const unsigned char *)UI_Snapshot_Find(view, size, UI_SNAPSHOT_MEASURES, &measures_size);
+		if (measures && measures_size >= 8 && header.app_key == App_Snapshot_Key()) {
+			int32_t count, strings_size;
+			memcpy(&count, measures, sizeof(count));
+			memcpy(&strings_size, measures + 4, sizeof(strings_size));
+			int valid = count > 0 && strings_size >= 0 &&
+			            8 + (int64_t)count * (int64_t)sizeof(UI_Snapshot_Measure) + strings_size == (int64_t)measures_size;
+			const char *strings = valid ? (const char *)(measures + 8 + count * sizeof(UI_Snapshot_Measure)) : 0;
+			
+			// Every text must fit the strings block and end in its NUL
+			int64_t offset = 0;
+			for (int i = 0; valid && i < count; i++) {
+				UI_Snapshot_Measure m;
+				memcpy(&m, measures + 8 + i * sizeof(UI_Snapshot_Measure), sizeof(m));
+				valid = m.length >= 0 && offset + m.length < strings_size && strings[offset + m.length] == 0;
+				offset += m.length + 1;
+			}
+			
+			if (valid) {
+				// Stored most recently used first: insert from the back to keep the order
+				// (only the newest APP_TEXT_MEASURE_CACHE_CAPACITY stay)
+				for (int i = count - 1; i >= 0; i--) {
+					UI_Snapshot_Measure m;
+					memcpy(&m, measures + 8 + i * sizeof(UI_Snapshot_Measure), sizeof(m));
+					offset -= m.length + 1;
+					Text_Measure_Cache_Insert(strings + offset, m.length, m.font_size, m.font_style, m.size);
+				}
+				g_snapshot.loaded_measures = count < APP_TEXT_MEASURE_CACHE_CAPACITY ? count : APP_TEXT_MEASURE_CACHE_CAPACITY;
+			}
+		}
+	}
+	
+	if (view) UnmapViewOfFile(view);
+	if (mapping) CloseHandle(mapping);
+	CloseHandle(file);
+}
+
+
+// .............................................................................................
+// Write the last built frame and the measurement cache (temporary file, then replace)
+static void
+App_Snapshot_Save()
+{
+	if (!g_snapshot.enabled) return;
+	
+	Text_Measure_Cache *cache = &g_text_measure_cache;
+	int capacity = cache->count > 0 ? cache->count : 1;
+	UI_Snapshot_Measure *measures = (UI_Snapshot_Measure *)malloc(capacity * sizeof(UI_Snapshot_Measure));
+	const char **texts = (const char **)malloc(capacity * sizeof(const char *));
+	if (!measures || !texts) {
+		free(measures);
+		free(texts);
+		return;
+	}
+	
+	int measure_count = 0;
+	for (int i = cache->lru_head; i >= 0; i = cache->entries[i].lru_next) {
+		const Text_Measure_Entry *e = &cache->entries[i];
+		texts[measure_count] = e->text;
+		UI_Snapshot_Measure *m = &measures[measure_count++];
+		m->hash = e->hash;
+		m->length = e->length;
+		m->font_size = e->font_size;
+		m->font_style = e->font_style;
+		m->size = e->size;
+	}
+	
+	uint32_t key = App_Snapshot_Key();
+	int size = UI_Snapshot_Write(&g_ui_context, key, measures, texts, measure_count, NULL, 0);
+	void *data = malloc(size);
+	if (data && UI_Snapshot_Write(&g_ui_context, key, measures, texts, measure_count, data, size) == size) {
+		wchar_t temp_path[MAX_PATH];
+		swprintf(temp_path, MAX_PATH, L"%ls.tmp", g_snapshot.path);
+		
+		HANDLE file = CreateFileW(temp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file != INVALID_HANDLE_VALUE) {
+			DWORD written = 0;
+			BOOL ok = WriteFile(file, data, (DWORD)size, &written, NULL) && written == (DWORD)size;
+			CloseHandle(file);
+			if (ok && MoveFileExW(temp_path, g_snapshot.path, MOVEFILE_REPLACE_EXISTING)) {
+				g_snapshot.saved_bytes = size;
+			} else {
+				DeleteFileW(temp_path);
+			}
+		}
+	}
+	
+	free(data);
+	free(texts);
+	free(measures);
+}
+
+
+// .............................................................................................
+static int
+Rect_Intersects_Dirty(const UI_RectI *dirty, int l, int t, int r, int b)
+{
+	if (!dirty) return 1;
+	return l < dirty->x + dirty->w && r > dirty->x && 
+	       t < dirty->y + dirty->h && b > dirty->y;
+}
+
+
+// .............................................................................................
+void
+Color_Brush_Cache_Release()
+{
+	for (int i = 0; i < g_color_brush_cache.count; i++) {
+		if (g_color_brush_cache.brushes[i]) g_color_brush_cache.brushes[i]->Release();
+	}
+	memset(&g_color_brush_cache, 0, sizeof(Color_Brush_Cache));
+}
+
+
+// .............................................................................................
+// Get a brush for an ARGB color. Falls back to the shared p_brush (with SetColor) when
+// every cached brush was already used this frame.
+static ID2D1SolidColorBrush*
+Get_Color_Brush(uint32_t c)
+{
+	Color_Brush_Cache *cache = &g_color_brush_cache;
+	
+	for (int i = 0; i < cache->count; i++) {
+		if (cache->colors[i] == c) {
+			cache->last_used_frame[i] = cache->frame;
+			return cache->brushes[i];
+		}
+	}
+	
+	float a = ((c >> 24) & 0xFF) / 255.0f;
+	float r = ((c >> 16) & 0xFF) / 255.0f;
+	float g = ((c >>  8) & 0xFF) / 255.0f;
+	float b = ((c >>  0) & 0xFF) / 255.0f;
+	D2D1_COLOR_F color = D2D1::ColorF(r, g, b, a);
+	
+	// Take a free slot, or replace the least recently used brush from an earlier frame
+	int idx = -1;
+	if (cache->count < APP_MAX_COLOR_BRUSHES) {
+		idx = cache->count;
+	} else {
+		int oldest_frame = cache->frame;
+		for (int i = 0; i < cache->count; i++) {
+			if (cache->last_used_frame[i] < oldest_frame) {
+				oldest_frame = cache->last_used_frame[i];
+				idx = i;
+			}
+		}
+	}
+	
+	ID2D1SolidColorBrush *brush = 0;
+	if (idx < 0 || FAILED(p_render_target->CreateSolidColorBrush(color, &brush))) {
+		p_brush->SetColor(color);
+		return p_brush;
+	}
+	
+	if (idx == cache->count) {
+		cache->count++;
+	} else {
+		cache->brushes[idx]->Release();
+	}
+	cache->brushes[idx] = brush;
+	cache->colors[idx] = c;
+	cache->last_used_frame[idx] = cache->frame;
+	return brush;
+}
+
+
+// .............................................................................................
+static int
+Rect_Batch_Overlaps(const Rect_Batch *batch, const UI_Rectangle *r)
+{
+	return r->left < batch->right && r->right > batch->left &&
+	       r->top < batch->bottom && r->bottom > batch->top;
+}
+
+
+// .............................................................................................
+// Group rectangles into same-color batches without changing what ends up on screen.
+// Searching backward from the newest batch, a rect joins the first batch with its color;
+// the search stops at the first batch it overlaps (it must stay drawn above that one).
+static void
+Rect_Batcher_Build(UI_Render_List *render_list, const UI_RectI *dirty)
+{
+	Rect_Batcher *rb = &g_rect_batcher;
+	rb->batch_count = 0;
+	rb->rects_drawn = 0;
+	rb->batches_drawn = 0;
+	
+	if (render_list->rect_count > rb->capacity) {
+		int capacity = render_list->rect_capacity;
+		Rect_Batch *batches = (Rect_Batch *)realloc(rb->batches, capacity * sizeof(Rect_Batch));
+		if (batches) rb->batches = batches;
+		int *rect_next = (int *)realloc(rb->rect_next, capacity * sizeof(int));
+		if (rect_next) rb->rect_next = rect_next;
+		if (!batches || !rect_next) return;  // Nothing drawn this frame
+		rb->capacity = capacity;
+	}
+	
+	Bitmap_Cache *bc = &g_bitmap_cache;
+	int group = 0;
+	
+	for (int i = 0; i < render_list->rect_count; i++) {
+		// Rects of groups drawn from a cached bitmap are skipped (see Bitmap_Cache_Draw)
+		while (group < bc->group_count && i >= render_list->cache_groups[group].rect_end) group++;
+		if (group < bc->group_count && i >= render_list->cache_groups[group].rect_begin &&
+		    bc->group_entry[group] >= 0) continue;
+		
+		const UI_Rectangle *src = &render_list->rectangles[i];
+		if ((src->color >> 24) == 0) continue;  // Fully transparent, draws nothing
+		if (src->right <= src->left || src->bottom <= src->top) continue;
+		if (!Rect_Intersects_Dirty(dirty, src->left, src->top, src->right, src->bottom)) continue;
+		
+		rb->rects_drawn++;
+		rb->rect_next[i] = -1;
+		
+		int target = -1;
+		int stop = rb->batch_count - APP_RECT_BATCH_LOOKBACK;
+		if (stop < 0) stop = 0;
+		
+		for (int b = rb->batch_count - 1; b >= stop; b--) {
+			Rect_Batch *batch = &rb->batches[b];
+			if (batch->color == src->color) {
+				target = b;
+				break;
+			}
+			if (Rect_Batch_Overlaps(batch, src)) break;
+		}
+		
+		if (target >= 0) {
+			Rect_Batch *batch = &rb->batches[target];
+			rb->rect_next[batch->last_rect] = i;
+			batch->last_rect = i;
+			if (src->left < batch->left) batch->left = src->left;
+			if (src->top < batch->top) batch->top = src->top;
+			if (src->right > batch->right) batch->right = src->right;
+			if (src->bottom > batch->bottom) batch->bottom = src->bottom;
+		} else {
+			Rect_Batch *batch = &rb->batches[rb->batch_count++];
+			batch->color = src->color;
+			batch->first_rect = i;
+			batch->last_rect = i;
+			batch->left = src->left;
+			batch->top = src->top;
+			batch->right = src->right;
+			batch->bottom = src->bottom;
+		}
+	}
+	
+	rb->batches_drawn = rb->batch_count;
+}
+
+
+// .............................................................................................
+// Draw all rectangles, or only those touching dirty (NULL = everything)
+// Rects are drawn batch by batch with one cached brush per color, so Direct2D sees long
+// runs of FillRectangle with no brush state changes in between.
+void
+Render_UI(UI_Render_List *render_list, const UI_RectI *dirty)
+{
+	PROFILE_ZONE;  // Auto-named "Render_UI"
+	
+	g_color_brush_cache.frame++;
+	Rect_Batcher_Build(render_list, dirty);
+	
+	Rect_Batcher *rb = &g_rect_batcher;
+	for (int b = 0; b < rb->batch_count; b++)
+	{
+		Rect_Batch *batch = &rb->batches[b];
+		ID2D1SolidColorBrush *brush = Get_Color_Brush(batch->color);
+		
+		for (int i = batch->first_rect; i != -1; i = rb->rect_next[i]) {
+			const UI_Rectangle *src = &render_list->rectangles[i];
+			D2D1_RECT_F rect = D2D1::RectF(
+				(float)src->left,
+				(float)src->top,
+				(float)src->right,
+				(float)src->bottom
+			);
+			p_render_target->FillRectangle(rect, brush);
+		}
+	}
+}
+
+
+// .............................................................................................
+void
+Text_Layout_Cache_Init()
+{
+	memset(&g_text_layout_cache, 0, sizeof(Text_Layout_Cache));
+	for (int i = 0; i < APP_TEXT_LAYOUT_CACHE_BUCKETS; i++) {
+		g_text_layout_cache.buckets[i] = -1;
+	}
+	g_text_layout_cache.free_list = -1;
+}
+
+
+// .............................................................................................
+void
+Text_Layout_Cache_Release()
+{
+	Text_Layout_Cache *cache = &g_text_layout_cache;
+	for (int i = 0; i < cache->count; i++) {
+		if (cache->entries[i].layout) {
+			cache->entries[i].layout->Release();
+			cache->entries[i].layout = 0;
+			free(cache->entries[i].text);
+		}
+	}
+	Text_Layout_Cache_Init();
+}
+
+
+// .............................................................................................
+static int
+Text_Layout_Cache_Bucket(UI_Id hash, int length, IDWriteTextFormat *fmt, int w, int h, int align_h, int align_v)
+{
+	uint32_t key = (uint32_t)hash;
+	key ^= (uint32_t)length * 0x9E3779B1u;
+	key ^= (uint32_t)(uintptr_t)fmt * 0x85EBCA77u;
+	key ^= (uint32_t)w * 0xC2B2AE3Du;
+	key ^= (uint32_t)h * 0x27D4EB2Fu;
+	key ^= (uint32_t)(align_h * 3 + align_v) * 0x165667B1u;
+	return (int)(key % APP_TEXT_LAYOUT_CACHE_BUCKETS);
+}
+
+
+// .............................................................................................
+// Release layouts that have not been drawn for APP_TEXT_LAYOUT_EVICT_FRAMES frames
+static void
+Text_Layout_Cache_Evict_Stale()
+{
+	Text_Layout_Cache *cache = &g_text_layout_cache;
+	
+	for (int b = 0; b < APP_TEXT_LAYOUT_CACHE_BUCKETS; b++) {
+		int *link = &cache->buckets[b];
+		while (*link >= 0) {
+			int idx = *link;
+			Text_Layout_Entry *e = &cache->entries[idx];
+			
+			if (cache->frame - e->last_used_frame > APP_TEXT_LAYOUT_EVICT_FRAMES) {
+				*link = e->bucket_next;
+				
+				e->layout->Release();
+				e->layout = 0;
+				free(e->text);
+				e->text = 0;
+				e->bucket_next = cache->free_list;
+				cache->free_list = idx;
+				cache->live_count--;
+				cache->evictions++;
+			} else {
+				link = &e->bucket_next;
+			}
+		}
+	}
+}
+
+
+// .............................................................................................
+// Find or create the layout for a text primitive. Returns NULL if the cache is full or
+// layout creation failed (caller falls back to DrawText).
+static IDWriteTextLayout*
+Text_Layout_Cache_Get(const UI_Text *src, IDWriteTextFormat *fmt)
+{
+	Text_Layout_Cache *cache = &g_text_layout_cache;
+	
+	UI_Id hash = UI_HashString(src->text);
+	int length = src->text_length;
+	int w = (src->w > 0) ? src->w : 0;
+	int h = (src->h > 0) ? src->h : 0;
+	int bucket = Text_Layout_Cache_Bucket(hash, length, fmt, w, h, src->align_h, src->align_v);
+	
+	for (int i = cache->buckets[bucket]; i >= 0; i = cache->entries[i].bucket_next) {
+		Text_Layout_Entry *e = &cache->entries[i];
+		if (e->hash == hash && e->length == length && e->format == fmt &&
+		    e->w == w && e->h == h && e->align_h == src->align_h && e->align_v == src->align_v &&
+		    memcmp(e->text, src->text, length) == 0) {
+			cache->hits++;
+			e->last_used_frame = cache->frame;
+			return e->layout;
+		}
+	}
+	
+	cache->misses++;
+	
+	int idx;
+	if (cache->free_list >= 0) {
+		idx = cache->free_list;
+		cache->free_list = cache->entries[idx].bucket_next;
+	} else if (cache->count < APP_TEXT_LAYOUT_CACHE_CAPACITY) {
+		idx = cache->count++;
+	} else {
+		return 0;
+	}
+	
+	char *copy = (char *)malloc(length + 1);
+	if (!copy) {
+		cache->entries[idx].bucket_next = cache->free_list;
+		cache->free_list = idx;
+		return 0;
+	}
+	memcpy(copy, src->text, length + 1);
+	
+	// Convert UTF-8 to UTF-16
+	wchar_t wtext[MAX_UI_TEXT_LENGTH];
+	MultiByteToWideChar(CP_UTF8, 0, src->text, -1, wtext, MAX_UI_TEXT_LENGTH);
+	
+	IDWriteTextLayout *layout;
+	EnterCriticalSection(&g_text_format_lock);
+	HRESULT hr = p_dwrite_factory->CreateTextLayout(
+		wtext,
+		(UINT32)wcslen(wtext),
+		fmt,
+		(float)w,
+		(float)h,
+		&layout
+	);
+	LeaveCriticalSection(&g_text_format_lock);
+	
+	if (FAILED(hr)) {
+		free(copy);
+		cache->entries[idx].bucket_next = cache->free_list;
+		cache->free_list = idx;
+		return 0;
+	}
+	
+	Text_Layout_Entry *e = &cache->entries[idx];
+	e->layout = layout;
+	e->format = fmt;
+	e->hash = hash;
+	e->length = length;
+	e->text = copy;
+	e->w = w;
+	e->h = h;
+	e->align_h = src->align_h;
+	e->align_v = src->align_v;
+	e->last_used_frame = cache->frame;
+	e->bucket_next = cache->buckets[bucket];
+	cache->buckets[bucket] = idx;
+	cache->live_count++;
+	
+	return layout;
+}
+
+
+// .............................................................................................
+// Resolve the font face a text format draws with (NULL if the family is not installed)
+static IDWriteFontFace*
+Glyph_Atlas_Font_Face(IDWriteTextFormat *fmt)
+{
+	IDWriteFontCollection *collection = 0;
+	fmt->GetFontCollection(&collection);
+	if (!collection) p_dwrite_factory->GetSystemFontCollection(&collection);
+	if (!collection) return 0;
+	
+	IDWriteFontFace *face = 0;
+	wchar_t family_name[64];
+	UINT32 family_index = 0;
+	BOOL exists = FALSE;
+	IDWriteFontFamily *family = 0;
+	
+	if (SUCCEEDED(fmt->GetFontFamilyName(family_name, 64)) &&
+	    SUCCEEDED(collection->FindFamilyName(family_name, &family_index, &exists)) && exists &&
+	    SUCCEEDED(collection->GetFontFamily(family_index, &family))) {
+		IDWriteFont *font = 0;
+		if (SUCCEEDED(family->GetFirstMatchingFont(fmt->GetFontWeight(), fmt->GetFontStretch(),
+		                                           fmt->GetFontStyle(), &font))) {
+			font->CreateFontFace(&face);
+			font->Release();
+		}
+		family->Release();
+	}
+	
+	collection->Release();
+	return face;
+}
+
+
+// .............................................................................................
+// Rasterize the atlas glyphs of fmt (leaves atlas->bitmap NULL on failure)
+static void
+Glyph_Atlas_Build(Glyph_Atlas *atlas, IDWriteTextFormat *fmt)
+{
+	IDWriteFontFace *face = Glyph_Atlas_Font_Face(fmt);
+	if (!face) return;
+	
+	float font_size = fmt->GetFontSize();
+	DWRITE_FONT_METRICS font_metrics;
+	face->GetMetrics(&font_metrics);
+	float scale = font_size / (float)font_metrics.designUnitsPerEm;
+	
+	UINT32 codepoints[APP_GLYPH_ATLAS_GLYPHS];
+	UINT16 glyphs[APP_GLYPH_ATLAS_GLYPHS];
+	DWRITE_GLYPH_METRICS glyph_metrics[APP_GLYPH_ATLAS_GLYPHS];
+	for (int i = 0; i < APP_GLYPH_ATLAS_GLYPHS; i++) {
+		codepoints[i] = APP_GLYPH_ATLAS_FIRST + i;
+	}
+	
+	if (FAILED(face->GetGlyphIndices(codepoints, APP_GLYPH_ATLAS_GLYPHS, glyphs)) ||
+	    FAILED(face->GetDesignGlyphMetrics(glyphs, APP_GLYPH_ATLAS_GLYPHS, glyph_metrics))) {
+		face->Release();
+		return;
+	}
+	
+	float max_advance = 0.0f;
+	for (int i = 0; i < APP_GLYPH_ATLAS_GLYPHS; i++) {
+		atlas->advances[i] = glyph_metrics[i].advanceWidth * scale;
+		if (atlas->advances[i] > max_advance) max_advance = atlas->advances[i];
+	}
+	
+	// Cells get a pad on every side for glyphs that overhang their advance box
+	float ascent = font_metrics.ascent * scale;
+	float descent = font_metrics.descent * scale;
+	atlas->ascent = ascent;
+	atlas->line_height = (font_metrics.ascent + font_metrics.descent + font_metrics.lineGap) * scale;
+	atlas->pad = 2 + (int)(font_size / 8);
+	atlas->baseline = atlas->pad + (int)ceilf(ascent);
+	atlas->cell_w = (int)ceilf(max_advance) + 2 * atlas->pad;
+	atlas->cell_h = atlas->baseline + (int)ceilf(descent) + atlas->pad;
+	atlas->columns = APP_GLYPH_ATLAS_WIDTH / atlas->cell_w;
+	if (atlas->columns < 1) atlas->columns = 1;
+	int rows = (APP_GLYPH_ATLAS_GLYPHS + atlas->columns - 1) / atlas->columns;
+	
+	D2D1_SIZE_F size = D2D1::SizeF((float)(atlas->columns * atlas->cell_w), (float)(rows * atlas->cell_h));
+	D2D1_PIXEL_FORMAT format = D2D1::PixelFormat(DXGI_FORMAT_A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED);
+	HRESULT hr = p_render_target->CreateCompatibleRenderTarget(
+		&size, NULL, &format, D2D1_COMPATIBLE_RENDER_TARGET_OPTIONS_NONE, &atlas->target);
+	if (FAILED(hr)) {
+		atlas->target = 0;
+		face->Release();
+		return;
+	}
+	
+	ID2D1SolidColorBrush *white = 0;
+	hr = atlas->target->CreateSolidColorBrush(D2D1::ColorF(1.0f, 1.0f, 1.0f, 1.0f), &white);
+	if (SUCCEEDED(hr)) {
+		atlas->target->BeginDraw();
+		atlas->target->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
+		atlas->target->Clear(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.0f));
+		
+		for (int i = 0; i < APP_GLYPH_ATLAS_GLYPHS; i++) {
+			float advance = 0.0f;
+			DWRITE_GLYPH_RUN run;
+			memset(&run, 0, sizeof(run));
+			run.fontFace = face;
+			run.fontEmSize = font_size;
+			run.glyphCount = 1;
+			run.glyphIndices = &glyphs[i];
+			run.glyphAdvances = &advance;
+			
+			int cx = (i % atlas->columns) * atlas->cell_w;
+			int cy = (i / atlas->columns) * atlas->cell_h;
+			atlas->target->DrawGlyphRun(
+				D2D1::Point2F((float)(cx + atlas->pad), (float)(cy + atlas->baseline)),
+				&run, white);
+		}
+		
+		hr = atlas->target->EndDraw();
+		white->Release();
+	}
+	
+	if (SUCCEEDED(hr)) hr = atlas->target->GetBitmap(&atlas->bitmap);
+	if (FAILED(hr)) {
+		atlas->bitmap = 0;
+		atlas->target->Release();
+		atlas->target = 0;
+	}
+	face->Release();
+}
+
+
+// .............................................................................................
+// Find or build the atlas for fmt (NULL when the atlas table is full)
+static Glyph_Atlas*
+Glyph_Atlas_Get(IDWriteTextFormat *fmt)
+{
+	Glyph_Atlas_Cache *cache = &g_glyph_atlas_cache;
+	for (int i = 0; i < cache->count; i++) {
+		if (cache->atlases[i].format == fmt) return &cache->atlases[i];
+	}
+	
+	if (cache->count >= APP_MAX_GLYPH_ATLASES) return 0;
+	
+	Glyph_Atlas *atlas = &cache->atlases[cache->count++];
+	memset(atlas, 0, sizeof(Glyph_Atlas));
+	atlas->format = fmt;
+	Glyph_Atlas_Build(atlas, fmt);
+	return atlas;
+}
+
+
+// .............................................................................................
+void
+Glyph_Atlas_Release()
+{
+	Glyph_Atlas_Cache *cache = &g_glyph_atlas_cache;
+	for (int i = 0; i < cache->count; i++) {
+		if (cache->atlases[i].bitmap) cache->atlases[i].bitmap->Release();
+		if (cache->atlases[i].target) cache->atlases[i].target->Release();
+	}
+	cache->count = 0;
+}
+
+
+// .............................................................................................
+// Draw src from the atlas of fmt with p_brush (color already set). Returns 0 if the text
+// needs the layout path.
+static int
+Glyph_Atlas_Draw_Text(ID2D1RenderTarget *target, const UI_Text *src, IDWriteTextFormat *fmt)
+{
+	Glyph_Atlas *atlas = Glyph_Atlas_Get(fmt);
+	if (!atlas || !atlas->bitmap) return 0;
+	
+	float width = 0.0f;
+	for (int i = 0; i < src->text_length; i++) {
+		int glyph = (unsigned char)src->text[i] - APP_GLYPH_ATLAS_FIRST;
+		if (glyph < 0 || glyph >= APP_GLYPH_ATLAS_GLYPHS) return 0;
+		width += atlas->advances[glyph];
+	}
+	if (width > (float)src->w + 0.5f) return 0;
+	
+	// Same box alignment as the layout path
+	float x = (float)src->x;
+	if (src->align_h == UI_ALIGN_CENTER) x += ((float)src->w - width) * 0.5f;
+	else if (src->align_h == UI_ALIGN_END) x += (float)src->w - width;
+	
+	float top = (float)src->y;
+	if (src->align_v == UI_ALIGN_CENTER) top += ((float)src->h - atlas->line_height) * 0.5f;
+	else if (src->align_v == UI_ALIGN_END) top += (float)src->h - atlas->line_height;
+	float baseline = floorf(top + atlas->ascent + 0.5f);
+	
+	// FillOpacityMask requires aliased primitive antialiasing
+	D2D1_ANTIALIAS_MODE previous_mode = target->GetAntialiasMode();
+	target->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+	
+	float pen = x;
+	for (int i = 0; i < src->text_length; i++) {
+		int glyph = (unsigned char)src->text[i] - APP_GLYPH_ATLAS_FIRST;
+		float left = floorf(pen + 0.5f) - (float)atlas->pad;
+		float cell_top = baseline - (float)atlas->baseline;
+		pen += atlas->advances[glyph];
+		if (glyph == 0) continue;  // Space
+		
+		float cx = (float)((glyph % atlas->columns) * atlas->cell_w);
+		float cy = (float)((glyph / atlas->columns) * atlas->cell_h);
+		target->FillOpacityMask(
+			atlas->bitmap,
+			p_brush,
+			D2D1_OPACITY_MASK_CONTENT_TEXT_NATURAL,
+			D2D1::RectF(left, cell_top, left + atlas->cell_w, cell_top + atlas->cell_h),
+			D2D1::RectF(cx, cy, cx + atlas->cell_w, cy + atlas->cell_h)
+		);
+		g_glyph_atlas_cache.glyphs++;
+	}
+	
+	target->SetAntialiasMode(previous_mode);
+	g_glyph_atlas_cache.texts++;
+	return 1;
+}
+
+
+// .............................................................................................
+// Draw one text primitive into target (the window or a cached bitmap)
+static void
+Draw_UI_Text(ID2D1RenderTarget *target, const UI_Text *src)
+{
+	// Set color
+	uint32_t c = src->color;
+	float a = ((c >> 24) & 0xFF) / 255.0f;
+	float r = ((c >> 16) & 0xFF) / 255.0f;
+	float g = ((c >>  8) & 0xFF) / 255.0f;
+	float b = ((c >>  0) & 0xFF) / 255.0f;
+	p_brush->SetColor(D2D1::ColorF(r, g, b, a));
+	
+	// Unsized texts use the 14pt default size
+	int font_size = (src->font_size > 0) ? src->font_size : 14;
+	
+	// Glyph atlas backend (--text=atlas) draws what it can, the rest takes the layout path
+	if (g_glyph_atlas_cache.enabled) {
+		if (Glyph_Atlas_Draw_Text(target, src, Get_Text_Format(font_size, src->font_style))) return;
+		g_glyph_atlas_cache.fallbacks++;
+	}
+	
+	// The cached format already carries this text's alignment
+	IDWriteTextFormat *fmt = Get_Text_Format_Aligned(font_size, src->font_style, src->align_h, src->align_v);
+	
+	// Draw retained layout (layout box is the text rect, origin at its top-left)
+	IDWriteTextLayout *layout = Text_Layout_Cache_Get(src, fmt);
+	if (layout) {
+		target->DrawTextLayout(
+			D2D1::Point2F((float)src->x, (float)src->y),
+			layout,
+			p_brush
+		);
+		return;
+	}
+	
+	// Fallback: cache full or layout creation failed
+	g_text_layout_cache.uncached_draws++;
+	
+	wchar_t wtext[MAX_UI_TEXT_LENGTH];
+	MultiByteToWideChar(CP_UTF8, 0, src->text, -1, wtext, MAX_UI_TEXT_LENGTH);
+	
+	D2D1_RECT_F rect = D2D1::RectF(
+		(float)src->x, 
+		(float)src->y,
+		(float)(src->x + src->w), 
+		(float)(src->y + src->h)
+	);
+	
+	EnterCriticalSection(&g_text_format_lock);
+	target->DrawText(
+		wtext, 
+		(UINT32)wcslen(wtext),
+		fmt,
+		rect,
+		p_brush
+	);
+	LeaveCriticalSection(&g_text_format_lock);
+}
+
+
+// .............................................................................................
+// Switch the text clip (UI_Text::clip) on target; returns the new current clip
+static int
+Set_Text_Clip(ID2D1RenderTarget *target, const UI_Render_List *list, int current, int clip)
+{
+	if (clip == current) return current;
+	if (current >= 0) target->PopAxisAlignedClip();
+	
+	if (clip >= 0) {
+		const UI_RectI *c = &list->clip_rects[clip];
+		D2D1_RECT_F rect = D2D1::RectF(
+			(float)c->x,
+			(float)c->y,
+			(float)(c->x + c->w),
+			(float)(c->y + c->h)
+		);
+		target->PushAxisAlignedClip(rect, D2D1_ANTIALIAS_MODE_ALIASED);
+	}
+	return clip;
+}
+
+
+// .............................................................................................
+// Draw all texts, or only those touching dirty (NULL = everything)
+void
+Render_UI_Text(UI_Render_List *render_list, const UI_RectI *dirty)
+{
+	PROFILE_ZONE;  // Auto-named "Render_UI_Text"
+	
+	g_text_layout_cache.frame++;
+	
+	Bitmap_Cache *bc = &g_bitmap_cache;
+	int group = 0;
+	int clip = -1;
+	
+	for (int i = 0; i < render_list->text_count; i++)
+	{
+		// Texts of groups drawn from a cached bitmap are already on screen
+		while (group < bc->group_count && i >= render_list->cache_groups[group].text_end) group++;
+		if (group < bc->group_count && i >= render_list->cache_groups[group].text_begin &&
+		    bc->group_entry[group] >= 0) continue;
+		
+		const UI_Text *src = &render_list->texts[i];
+		if (!Rect_Intersects_Dirty(dirty, src->x, src->y, src->x + src->w, src->y + src->h)) continue;
+		
+		clip = Set_Text_Clip(p_render_target, render_list, clip, src->clip);
+		Draw_UI_Text(p_render_target, src);
+	}
+	Set_Text_Clip(p_render_target, render_list, clip, -1);
+	
+	// Sweep for stale layouts a few times per eviction window rather than every frame
+	if ((g_text_layout_cache.frame & 15) == 0) {
+		Text_Layout_Cache_Evict_Stale();
+	}
+}
+
+
+// .............................................................................................
+static void
+Bitmap_Cache_Release_Entry(Bitmap_Cache_Entry *e)
+{
+	if (e->bitmap) e->bitmap->Release();
+	if (e->target) e->target->Release();
+	g_bitmap_cache.bytes_used -= e->bytes;
+	memset(e, 0, sizeof(Bitmap_Cache_Entry));
+}
+
+
+// .............................................................................................
+void
+Bitmap_Cache_Release()
+{
+	Bitmap_Cache *bc = &g_bitmap_cache;
+	for (int i = 0; i < bc->count; i++) Bitmap_Cache_Release_Entry(&bc->entries[i]);
+	free(bc->group_entry);
+	
+	int budget = bc->budget_bytes;
+	memset(bc, 0, sizeof(Bitmap_Cache));
+	bc->budget_bytes = budget;
+}
+
+
+// .............................................................................................
+// Release the least recently used bitmap not drawn this frame. Returns 0 if there is none.
+static int
+Bitmap_Cache_Evict_LRU()
+{
+	Bitmap_Cache *bc = &g_bitmap_cache;
+	int idx = -1;
+	for (int i = 0; i < bc->count; i++) {
+		Bitmap_Cache_Entry *e = &bc->entries[i];
+		if (!e->target || e->last_used_frame == bc->frame) continue;
+		if (idx < 0 || e->last_used_frame < bc->entries[idx].last_used_frame) idx = i;
+	}
+	
+	if (idx < 0) return 0;
+	Bitmap_Cache_Release_Entry(&bc->entries[idx]);
+	bc->evictions++;
+	return 1;
+}
+
+
+// .............................................................................................
+// A later rect, or any text outside the group, overlapping its bounds would end up under
+// the blit; such groups are drawn directly this frame.
+static int
+Bitmap_Cache_Group_Overlapped(const UI_Render_List *list, const UI_Cache_Group *group)
+{
+	int l = group->x, t = group->y, r = group->x + group->w, b = group->y + group->h;
+	
+	for (int i = group->rect_end; i < list->rect_count; i++) {
+		const UI_Rectangle *src = &list->rectangles[i];
+		if ((src->color >> 24) == 0) continue;
+		if (src->left < r && src->right > l && src->top < b && src->bottom > t) return 1;
+	}
+	
+	for (int i = 0; i < list->text_count; i++) {
+		if (i == group->text_begin) i = group->text_end;
+		if (i >= list->text_count) break;
+		const UI_Text *src = &list->texts[i];
+		if (src->x < r && src->x + src->w > l && src->y < b && src->y + src->h > t) return 1;
+	}
+	
+	return 0;
+}
+
+
+// .............................................................................................
+// Draw a group's primitives into its bitmap, origin at the group's top-left
+static int
+Bitmap_Cache_Render(Bitmap_Cache_Entry *e, const UI_Render_List *list, const UI_Cache_Group *group)
+{
+	ID2D1BitmapRenderTarget *target = e->target;
+	
+	target->BeginDraw();
+	target->Clear(D2D1::ColorF(0, 0, 0, 0));
+	target->SetTransform(D2D1::Matrix3x2F::Translation((float)-group->x, (float)-group->y));
+	
+	for (int i = group->rect_begin; i < group->rect_end; i++) {
+		const UI_Rectangle *src = &list->rectangles[i];
+		if ((src->color >> 24) == 0) continue;
+		if (src->right <= src->left || src->bottom <= src->top) continue;
+		
+		D2D1_RECT_F rect = D2D1::RectF(
+			(float)src->left,
+			(float)src->top,
+			(float)src->right,
+			(float)src->bottom
+		);
+		target->FillRectangle(rect, Get_Color_Brush(src->color));
+	}
+	
+	int clip = -1;
+	for (int i = group->text_begin; i < group->text_end; i++) {
+		clip = Set_Text_Clip(target, list, clip, list->texts[i].clip);
+		Draw_UI_Text(target, &list->texts[i]);
+	}
+	Set_Text_Clip(target, list, clip, -1);
+	
+	target->SetTransform(D2D1::Matrix3x2F::Identity());
+	return SUCCEEDED(target->EndDraw());
+}
+
+
+// .............................................................................................
+// Bitmap_Cache_Prepare - Decide per cache group whether it is blitted this frame, and
+// (re)render stale bitmaps. Must run before Render_UI / Render_UI_Text.
+void
+Bitmap_Cache_Prepare(UI_Render_List *list, const UI_RectI *dirty)
+{
+	PROFILE_ZONE;  // Auto-named "Bitmap_Cache_Prepare"
+	
+	Bitmap_Cache *bc = &g_bitmap_cache;
+	bc->frame++;
+	bc->group_count = 0;
+	
+	if (list->cache_group_count > bc->group_capacity) {
+		int *group_entry = (int *)realloc(bc->group_entry, list->cache_group_capacity * sizeof(int));
+		if (!group_entry) return;  // Everything drawn directly
+		bc->group_entry = group_entry;
+		bc->group_capacity = list->cache_group_capacity;
+	}
+	
+	for (int g = 0; g < list->cache_group_count; g++) {
+		const UI_Cache_Group *group = &list->cache_groups[g];
+		bc->group_entry[g] = -1;
+		
+		if (!Rect_Intersects_Dirty(dirty, group->x, group->y, group->x + group->w, group->y + group->h)) continue;
+		if (Bitmap_Cache_Group_Overlapped(list, group)) {
+			bc->overlapped++;
+			continue;
+		}
+		
+		int idx = -1;
+		int free_idx = -1;
+		for (int i = 0; i < bc->count; i++) {
+			if (bc->entries[i].target && bc->entries[i].id == group->id) { idx = i; break; }
+			if (!bc->entries[i].target && free_idx < 0) free_idx = i;
+		}
+		
+		if (idx >= 0) {
+			Bitmap_Cache_Entry *e = &bc->entries[idx];
+			if (e->last_used_frame == bc->frame) continue;  // Same ID twice in one frame
+			if (e->w == group->w && e->h == group->h && e->content_hash == group->content_hash) {
+				e->last_used_frame = bc->frame;
+				bc->group_entry[g] = idx;
+				bc->hits++;
+				continue;
+			}
+			
+			if (e->w != group->w || e->h != group->h) {
+				Bitmap_Cache_Release_Entry(e);  // Size changed: recreated below
+				free_idx = idx;
+				idx = -1;
+			}
+		}
+		
+		if (idx < 0) {
+			int bytes = group->w * group->h * 4;
+			if (bytes > bc->budget_bytes) continue;
+			while (bc->bytes_used + bytes > bc->budget_bytes && Bitmap_Cache_Evict_LRU()) {}
+			if (bc->bytes_used + bytes > bc->budget_bytes) continue;
+			
+			// Slot: one freed above (or by eviction), a new one, or the LRU entry's
+			for (int i = 0; i < bc->count && free_idx < 0; i++) {
+				if (!bc->entries[i].target) free_idx = i;
+			}
+			if (free_idx < 0 && bc->count < APP_MAX_CACHED_BITMAPS) free_idx = bc->count++;
+			if (free_idx < 0) {
+				if (!Bitmap_Cache_Evict_LRU()) continue;
+				for (int i = 0; i < bc->count && free_idx < 0; i++) {
+					if (!bc->entries[i].target) free_idx = i;
+				}
+			}
+			
+			Bitmap_Cache_Entry *e = &bc->entries[free_idx];
+			HRESULT hr = p_render_target->CreateCompatibleRenderTarget(
+				D2D1::SizeF((float)group->w, (float)group->h), &e->target);
+			if (FAILED(hr)) {
+				e->target = 0;
+				continue;
+			}
+			if (FAILED(e->target->GetBitmap(&e->bitmap))) {
+				Bitmap_Cache_Release_Entry(e);
+				continue;
+			}
+			
+			// ClearType needs an opaque background; the bitmap starts transparent
+			e->target->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
+			
+			D2D1_SIZE_U pixels = e->target->GetPixelSize();
+			e->id = group->id;
+			e->w = group->w;
+			e->h = group->h;
+			e->bytes = (int)(pixels.width * pixels.height * 4);
+			bc->bytes_used += e->bytes;
+			idx = free_idx;
+		}
+		
+		Bitmap_Cache_Entry *e = &bc->entries[idx];
+		if (!Bitmap_Cache_Render(e, list, group)) {
+			Bitmap_Cache_Release_Entry(e);
+			continue;
+		}
+		
+		e->content_hash = group->content_hash;
+		e->last_used_frame = bc->frame;
+		bc->group_entry[g] = idx;
+		bc->renders++;
+	}
+	
+	bc->group_count = list->cache_group_count;
+}
+
+
+// .............................................................................................
+// Blit the cached groups (after Render_UI, before Render_UI_Text)
+void
+Bitmap_Cache_Draw(UI_Render_List *list)
+{
+	Bitmap_Cache *bc = &g_bitmap_cache;
+	bc->blits = 0;
+	
+	for (int g = 0; g < bc->group_count; g++) {
+		if (bc->group_entry[g] < 0) continue;
+		
+		const UI_Cache_Group *group = &list->cache_groups[g];
+		D2D1_RECT_F dest = D2D1::RectF(
+			(float)group->x,
+			(float)group->y,
+			(float)(group->x + group->w),
+			(float)(group->y + group->h)
+		);
+		p_render_target->DrawBitmap(bc->entries[bc->group_entry[g]].bitmap, dest, 1.0f,
+		                            D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR);
+		bc->blits++;
+	}
+}
+
+
+// .............................................................................................
+void
+UI_Set_Cursor(HCURSOR cursor)
+{
+	if (cursor != g_current_cursor) {
+		SetCursor(cursor);
+		g_current_cursor = cursor;
+	}
+}
+
+
+// .............................................................................................
+void
+Frame_Timer_Init(int pacing_mode, int target_fps)
+{
+	QueryPerformanceFrequency(&g_frame_timer.frequency);
+	QueryPerformanceCounter(&g_frame_timer.frame_start);
+	g_frame_timer.target_fps = target_fps;
+	g_frame_timer.target_frame_time_ms = 1000.0 / g_frame_timer.target_fps;
+	g_frame_timer.actual_fps = 0;
+	g_frame_timer.fps_update_timer = 0.0;
+	g_frame_timer.frame_count_for_fps = 0;
+	g_frame_timer.pacing_mode = pacing_mode;
+	
+	// Timer based modes: prefer the high-resolution timer (Windows 10 1803+)
+	if (pacing_mode == FRAME_PACING_WAITABLE_TIMER || pacing_mode == FRAME_PACING_IDLE) {
+		g_frame_timer.waitable_timer = CreateWaitableTimerExW(
+			NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		g_frame_timer.timer_high_resolution = (g_frame_timer.waitable_timer != NULL);
+		
+		if (!g_frame_timer.waitable_timer) {
+			g_frame_timer.waitable_timer = CreateWaitableTimerW(NULL, TRUE, NULL);
+		}
+		if (!g_frame_timer.waitable_timer) {
+			g_frame_timer.pacing_mode = FRAME_PACING_BUSY_WAIT;
+		}
+	}
+}
+
+
+// .............................................................................................
+void
+Frame_Timer_Shutdown()
+{
+	if (g_frame_timer.waitable_timer) {
+		CloseHandle(g_frame_timer.waitable_timer);
+		g_frame_timer.waitable_timer = NULL;
+	}
+}
+
+
+// .............................................................................................
+static double
+Frame_Timer_Elapsed_Ms(LARGE_INTEGER *out_now)
+{
+	QueryPerformanceCounter(out_now);
+	return (double)(out_now->QuadPart - g_frame_timer.frame_start.QuadPart) 
+	       * 1000.0 / (double)g_frame_timer.frequency.QuadPart;
+}
+
+
+// .............................................................................................
+// UI_Input_Queue timestamp source (window procedure thread)
+static int64_t
+App_Input_Clock(void)
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return (int64_t)now.QuadPart;
+}
+
+
+// .............................................................................................
+static void
+Frame_Wait_Busy()
+{
+	LARGE_INTEGER now;
+	double elapsed_ms = Frame_Timer_Elapsed_Ms(&now);
+	
+	// Busy-wait until we reach target frame time
+	while (elapsed_ms < g_frame_timer.target_frame_time_ms) {
+		// Yield CPU if we're more than 1ms away
+		if (elapsed_ms < g_frame_timer.target_frame_time_ms - 1.0) {
+			Sleep(0);
+		}
+		elapsed_ms = Frame_Timer_Elapsed_Ms(&now);
+	}
+}
+
+
+// .............................................................................................
+static void
+Frame_Wait_Timer()
+{
+	LARGE_INTEGER now;
+	double remaining_ms = g_frame_timer.target_frame_time_ms - Frame_Timer_Elapsed_Ms(&now);
+	
+	// A legacy timer only has scheduler granularity, so leave the last 2ms to the spin
+	if (!g_frame_timer.timer_high_resolution) remaining_ms -= 2.0;
+	
+	if (remaining_ms > 0.0) {
+		LARGE_INTEGER due;
+		due.QuadPart = -(LONGLONG)(remaining_ms * 10000.0);  // Relative, 100ns units
+		if (SetWaitableTimer(g_frame_timer.waitable_timer, &due, 0, NULL, NULL, FALSE)) {
+			WaitForSingleObject(g_frame_timer.waitable_timer, INFINITE);
+		}
+	}
+	
+	if (!g_frame_timer.timer_high_resolution) {
+		Frame_Wait_Busy();
+	}
+}
+
+
+// .............................................................................................
+static void
+Frame_Wait_Vsync()
+{
+	// Fails when composition is unavailable; fall back to the precise spin
+	if (FAILED(DwmFlush())) {
+		Frame_Wait_Busy();
+	}
+}
+
+
+// .............................................................................................
+static void
+Frame_Wait_Idle()
+{
+	// Cap the frame rate while input is flowing
+	Frame_Wait_Timer();
+	
+	// One quiet frame lets pressed/released edges clear before the UI goes to sleep
+	// Events deferred by UI_Input_NewFrame (a second click in one frame) need another frame
+	if (g_frame_timer.quiet_frames >= 2 && UI_Input_Queue_Pending(&g_ui_context.input_queue) == 0) {
+		MsgWaitForMultipleObjectsEx(0, NULL, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+		g_frame_timer.slept_for_input = 1;
+	}
+}
+
+
+// .............................................................................................
+void
+Wait_For_Target_Frame_Time()
+{
+	PROFILE_ZONE;  // Auto-named "Wait_For_Target_Frame_Time"
+	
+	g_frame_timer.slept_for_input = 0;
+	
+	switch (g_frame_timer.pacing_mode) {
+		case FRAME_PACING_WAITABLE_TIMER: Frame_Wait_Timer(); break;
+		case FRAME_PACING_DWM_VSYNC:      Frame_Wait_Vsync(); break;
+		case FRAME_PACING_IDLE:           Frame_Wait_Idle();  break;
+		default:                          Frame_Wait_Busy();  break;
+	}
+	
+	LARGE_INTEGER current_time;
+	double elapsed_ms = Frame_Timer_Elapsed_Ms(&current_time);
+	
+	// Update frame timing
+	g_frame_timer.frame_end = current_time;
+	g_frame_timer.actual_frame_time_ms = elapsed_ms;
+	
+	// Accumulate jitter (frames that slept waiting for input are not pacing error)
+	if (!g_frame_timer.slept_for_input) {
+		double deviation_ms = elapsed_ms - g_frame_timer.target_frame_time_ms;
+		g_frame_timer.jitter_sum_ms += deviation_ms;
+		g_frame_timer.jitter_abs_sum_ms += (deviation_ms < 0.0) ? -deviation_ms : deviation_ms;
+		g_frame_timer.frame_time_sum_ms += elapsed_ms;
+		g_frame_timer.frame_time_sq_sum_ms += elapsed_ms * elapsed_ms;
+		if (elapsed_ms > g_frame_timer.frame_time_max_ms) g_frame_timer.frame_time_max_ms = elapsed_ms;
+		g_frame_timer.jitter_samples++;
+	}
+	
+	// Update FPS counter and jitter statistics (once per second)
+	g_frame_timer.frame_count_for_fps++;
+	g_frame_timer.fps_update_timer += elapsed_ms;
+	
+	if (g_frame_timer.fps_update_timer >= 1000.0) {
+		g_frame_timer.actual_fps = g_frame_timer.frame_count_for_fps;
+		g_frame_timer.frame_count_for_fps = 0;
+		g_frame_timer.fps_update_timer -= 1000.0;
+		if (g_frame_timer.fps_update_timer >= 1000.0) g_frame_timer.fps_update_timer = 0.0;
+		
+		int n = g_frame_timer.jitter_samples;
+		if (n > 0) {
+			double mean = g_frame_timer.frame_time_sum_ms / n;
+			double variance = g_frame_timer.frame_time_sq_sum_ms / n - mean * mean;
+			g_frame_timer.jitter_mean_ms = g_frame_timer.jitter_sum_ms / n;
+			g_frame_timer.jitter_abs_mean_ms = g_frame_timer.jitter_abs_sum_ms / n;
+			g_frame_timer.jitter_stddev_ms = (variance > 0.0) ? sqrt(variance) : 0.0;
+			g_frame_timer.jitter_max_ms = g_frame_timer.frame_time_max_ms;
+		}
+		
+		g_frame_timer.jitter_sum_ms = 0.0;
+		g_frame_timer.jitter_abs_sum_ms = 0.0;
+		g_frame_timer.frame_time_sum_ms = 0.0;
+		g_frame_timer.frame_time_sq_sum_ms = 0.0;
+		g_frame_timer.frame_time_max_ms = 0.0;
+		g_frame_timer.jitter_samples = 0;
+	}
+	
+	// Mark start of next frame
+	g_frame_timer.frame_start = current_time;
+}
+
+
+// .............................................................................................
+static void
+Swap_Chain_Release_Targets()
+{
+	App_Swap_Chain *sc = &g_swap_chain;
+	if (sc->context) sc->context->SetTarget(NULL);
+	if (sc->back_buffer) { sc->back_buffer->Release(); sc->back_buffer = 0; }
+	if (sc->canvas) { sc->canvas->Release(); sc->canvas = 0; }
+}
+
+
+// .............................................................................................
+// Wrap buffer 0 in a target bitmap and create the canvas at the same size
+static int
+Swap_Chain_Create_Targets(int w, int h)
+{
+	App_Swap_Chain *sc = &g_swap_chain;
+	float dpi_x, dpi_y;
+	sc->context->GetDpi(&dpi_x, &dpi_y);
+	D2D1_PIXEL_FORMAT format = D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE);
+	
+	IDXGISurface *surface = 0;
+	HRESULT hr = sc->swap_chain->GetBuffer(0, __uuidof(IDXGISurface), (void **)&surface);
+	if (SUCCEEDED(hr)) {
+		D2D1_BITMAP_PROPERTIES1 props = D2D1::BitmapProperties1(
+			D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW, format, dpi_x, dpi_y);
+		hr = sc->context->CreateBitmapFromDxgiSurface(surface, &props, &sc->back_buffer);
+		surface->Release();
+	}
+	if (SUCCEEDED(hr)) {
+		D2D1_BITMAP_PROPERTIES1 props = D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_TARGET, format, dpi_x, dpi_y);
+		hr = sc->context->CreateBitmap(D2D1::SizeU(w, h), NULL, 0, &props, &sc->canvas);
+	}
+	
+	if (FAILED(hr)) {
+		Swap_Chain_Release_Targets();
+		return 0;
+	}
+	
+	sc->context->SetTarget(sc->canvas);
+	sc->w = w;
+	sc->h = h;
+	sc->dpi_scale = dpi_x / 96.0f;
+	return 1;
+}
+
+
+// .............................................................................................
+static void
+Swap_Chain_Release()
+{
+	App_Swap_Chain *sc = &g_swap_chain;
+	Swap_Chain_Release_Targets();
+	if (sc->latency_waitable) CloseHandle(sc->latency_waitable);
+	if (sc->context) sc->context->Release();
+	if (sc->d2d_device) sc->d2d_device->Release();
+	if (sc->swap_chain) sc->swap_chain->Release();
+	if (sc->d3d_context) sc->d3d_context->Release();
+	if (sc->d3d_device) sc->d3d_device->Release();
+	memset(sc, 0, sizeof(App_Swap_Chain));
+}
+
+
+// .............................................................................................
+// Create the flip-model backend for window and make it p_render_target.
+// Returns 0 (nothing left allocated) if any step fails.
+static int
+Swap_Chain_Create(HWND window, int w, int h)
+{
+	App_Swap_Chain *sc = &g_swap_chain;
+	memset(sc, 0, sizeof(App_Swap_Chain));
+	if (w <= 0 || h <= 0) return 0;
+	sc->window = window;
+	
+	// Runtimes that predate 11_1 reject the whole list with E_INVALIDARG
+	D3D_FEATURE_LEVEL levels[] = {
+		D3D_FEATURE_LEVEL_11_1, D3D_FEATURE_LEVEL_11_0, D3D_FEATURE_LEVEL_10_1, D3D_FEATURE_LEVEL_10_0
+	};
+	UINT device_flags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;  // Required by Direct2D
+	HRESULT hr = D3D11CreateDevice(NULL, D3D_DRIVER_TYPE_HARDWARE, NULL, device_flags, levels, 4,
+	                               D3D11_SDK_VERSION, &sc->d3d_device, NULL, &sc->d3d_context);
+	if (hr == E_INVALIDARG) {
+		hr = D3D11CreateDevice(NULL, D3D_DRIVER_TYPE_HARDWARE, NULL, device_flags, levels + 1, 3,
+		                       D3D11_SDK_VERSION, &sc->d3d_device, NULL, &sc->d3d_context);
+	}
+	
+	IDXGIDevice *dxgi_device = 0;
+	IDXGIAdapter *adapter = 0;
+	IDXGIFactory2 *dxgi_factory = 0;
+	ID2D1Factory1 *d2d_factory = 0;
+	if (SUCCEEDED(hr)) hr = sc->d3d_device->QueryInterface(__uuidof(IDXGIDevice), (void **)&dxgi_device);
+	if (SUCCEEDED(hr)) hr = dxgi_device->GetAdapter(&adapter);
+	if (SUCCEEDED(hr)) hr = adapter->GetParent(__uuidof(IDXGIFactory2), (void **)&dxgi_factory);
+	
+	if (SUCCEEDED(hr)) {
+		DXGI_SWAP_CHAIN_DESC1 desc;
+		memset(&desc, 0, sizeof(desc));
+		desc.Width = (UINT)w;
+		desc.Height = (UINT)h;
+		desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+		desc.SampleDesc.Count = 1;
+		desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+		desc.BufferCount = APP_SWAP_CHAIN_BUFFERS;
+		desc.Scaling = g_resize.stretch ? DXGI_SCALING_STRETCH : DXGI_SCALING_NONE;
+		desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+		desc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
+		desc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+		
+		// FLIP_DISCARD needs Windows 10; FLIP_SEQUENTIAL works the same for a whole-canvas copy
+		hr = dxgi_factory->CreateSwapChainForHwnd(sc->d3d_device, window, &desc, NULL, NULL, &sc->swap_chain);
+		sc->flip_discard = SUCCEEDED(hr);
+		if (FAILED(hr)) {
+			desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+			hr = dxgi_factory->CreateSwapChainForHwnd(sc->d3d_device, window, &desc, NULL, NULL, &sc->swap_chain);
+		}
+		if (SUCCEEDED(hr)) dxgi_factory->MakeWindowAssociation(window, DXGI_MWA_NO_ALT_ENTER);
+	}
+	
+	if (SUCCEEDED(hr)) hr = p_d2d_factory->QueryInterface(__uuidof(ID2D1Factory1), (void **)&d2d_factory);
+	if (SUCCEEDED(hr)) hr = d2d_factory->CreateDevice(dxgi_device, &sc->d2d_device);
+	if (SUCCEEDED(hr)) hr = sc->d2d_device->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, &sc->context);
+	
+	if (d2d_factory) d2d_factory->Release();
+	if (dxgi_factory) dxgi_factory->Release();
+	if (adapter) adapter->Release();
+	if (dxgi_device) dxgi_device->Release();
+	
+	if (SUCCEEDED(hr)) {
+		// The context keeps its default 96 DPI: the process is not DPI aware, so the HWND
+		// target runs at 96 DPI too and UI coordinates mean the same in both backends
+		IDXGISwapChain2 *swap_chain2 = 0;
+		if (SUCCEEDED(sc->swap_chain->QueryInterface(__uuidof(IDXGISwapChain2), (void **)&swap_chain2))) {
+			swap_chain2->SetMaximumFrameLatency(APP_SWAP_CHAIN_MAX_LATENCY);
+			sc->latency_waitable = swap_chain2->GetFrameLatencyWaitableObject();
+			swap_chain2->Release();
+		}
+		sc->wait_pending = 1;  // The waitable starts signaled, wait before the first frame
+	}
+	
+	if (FAILED(hr) || !Swap_Chain_Create_Targets(w, h)) {
+		Swap_Chain_Release();
+		return 0;
+	}
+	
+	sc->enabled = 1;
+	p_render_target = sc->context;
+	return 1;
+}
+
+
+// .............................................................................................
+// Block until the swap chain can queue another frame (called before input is sampled).
+// Only after a present: a skipped frame did not consume a frame of latency.
+static void
+Swap_Chain_Wait()
+{
+	App_Swap_Chain *sc = &g_swap_chain;
+	if (!sc->enabled || !sc->latency_waitable || !sc->wait_pending) return;
+	
+	PROFILE_ZONE_N("Swap Chain Wait");
+	LARGE_INTEGER start, end;
+	QueryPerformanceCounter(&start);
+	WaitForSingleObjectEx(sc->latency_waitable, 1000, TRUE);
+	QueryPerformanceCounter(&end);
+	
+	sc->last_wait_ms = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)g_frame_timer.frequency.QuadPart;
+	sc->wait_pending = 0;
+}
+
+
+// .............................................................................................
+// Copy the canvas to the back buffer and present it with dirty (UI coordinates, NULL =
+// whole window) as the changed region. Returns 0 if the device is gone.
+static int
+Swap_Chain_Present(const UI_RectI *dirty)
+{
+	App_Swap_Chain *sc = &g_swap_chain;
+	
+	// Flip-discard buffers start out undefined, so the whole canvas is copied every frame
+	HRESULT hr = sc->back_buffer->CopyFromBitmap(NULL, sc->canvas, NULL);
+	
+	DXGI_PRESENT_PARAMETERS params;
+	memset(&params, 0, sizeof(params));
+	RECT dirty_rect;
+	if (dirty) {
+		dirty_rect.left = (LONG)floorf(dirty->x * sc->dpi_scale);
+		dirty_rect.top = (LONG)floorf(dirty->y * sc->dpi_scale);
+		dirty_rect.right = (LONG)ceilf((dirty->x + dirty->w) * sc->dpi_scale);
+		dirty_rect.bottom = (LONG)ceilf((dirty->y + dirty->h) * sc->dpi_scale);
+		if (dirty_rect.left < 0) dirty_rect.left = 0;
+		if (dirty_rect.top < 0) dirty_rect.top = 0;
+		if (dirty_rect.right > sc->w) dirty_rect.right = sc->w;
+		if (dirty_rect.bottom > sc->h) dirty_rect.bottom = sc->h;
+		
+		if (dirty_rect.left < dirty_rect.right && dirty_rect.top < dirty_rect.bottom) {
+			params.DirtyRectsCount = 1;
+			params.pDirtyRects = &dirty_rect;
+		}
+	}
+	
+	// Sync interval 0 like D2D1_PRESENT_OPTIONS_IMMEDIATELY; --pacing sets the frame rate
+	if (SUCCEEDED(hr)) hr = sc->swap_chain->Present1(0, 0, &params);
+	if (FAILED(hr)) return 0;
+	
+	sc->wait_pending = 1;
+	if (params.DirtyRectsCount) sc->presents_partial++;
+	else sc->presents_full++;
+	return 1;
+}
+
+
+// .............................................................................................
+// Resize the buffers for a w x h client area; with allow_larger, buffers that are already
+// big enough are kept and growth is rounded up to APP_RESIZE_BUFFER_STEP (the slack is
+// cropped by DXGI_SCALING_NONE). Returns 0 if the swap chain is unusable.
+static int
+Swap_Chain_Resize(int w, int h, int allow_larger)
+{
+	App_Swap_Chain *sc = &g_swap_chain;
+	if (w <= 0 || h <= 0) return 1;  // Minimized: keep the old buffers
+	if (w == sc->w && h == sc->h) return 1;
+	
+	if (allow_larger) {
+		if (w <= sc->w && h <= sc->h) {
+			g_resize.buffer_reuses++;
+			return 1;
+		}
+		if (w < sc->w) w = sc->w;
+		if (h < sc->h) h = sc->h;
+		w = (w + APP_RESIZE_BUFFER_STEP - 1) / APP_RESIZE_BUFFER_STEP * APP_RESIZE_BUFFER_STEP;
+		h = (h + APP_RESIZE_BUFFER_STEP - 1) / APP_RESIZE_BUFFER_STEP * APP_RESIZE_BUFFER_STEP;
+	}
+	g_resize.target_resizes++;
+	
+	// Every reference to the buffers must be gone, including D2D's deferred releases
+	Swap_Chain_Release_Targets();
+	sc->d3d_context->Flush();
+	
+	HRESULT hr = sc->swap_chain->ResizeBuffers(0, (UINT)w, (UINT)h, DXGI_FORMAT_UNKNOWN,
+	                                           DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT);
+	return SUCCEEDED(hr) && Swap_Chain_Create_Targets(w, h);
+}
+
+
+// .............................................................................................
+// Create the HWND render target (the default backend and the swap chain fallback)
+static int
+Create_Hwnd_Render_Target(HWND window)
+{
+	RECT client_rect;
+	GetClientRect(window, &client_rect);
+	HRESULT result = p_d2d_factory->CreateHwndRenderTarget(D2D1::RenderTargetProperties(),
+			D2D1::HwndRenderTargetProperties(window, D2D1::SizeU(client_rect.right - client_rect.left, client_rect.bottom - client_rect.top),
+			D2D1_PRESENT_OPTIONS_IMMEDIATELY | D2D1_PRESENT_OPTIONS_RETAIN_CONTENTS),
+			&p_hwnd_target);
+	if (FAILED(result)) {
+		p_hwnd_target = 0;
+		return 0;
 	}
+	
+	p_render_target = p_hwnd_target;
+	return 1;
 }
 
 
 // .............................................................................................
-void
-Render_UI_Text(UI_Render_List *render_list)
+// Drop a failed swap chain and continue on the HWND target. Everything created from the
+// old device (brushes, cached bitmaps, glyph atlases) is released; caches refill lazily.
+static void
+Swap_Chain_Fall_Back()
 {
-	PROFILE_ZONE;  // Auto-named "Render_UI_Text"
+	HWND window = g_swap_chain.window;
 	
-	for (int i = 0; i < render_list->text_count; i++)
-	{
-		const UI_Text *src = &render_list->texts[i];
-		
-		// Convert UTF-8 to UTF-16
-		wchar_t wtext[MAX_UI_TEXT_LENGTH];
-		MultiByteToWideChar(CP_UTF8, 0, src->text, -1, wtext, MAX_UI_TEXT_LENGTH);
-		
-		// Set color
-		uint32_t c = src->color;
-		float a = ((c >> 24) & 0xFF) / 255.0f;
-		float r = ((c >> 16) & 0xFF) / 255.0f;
-		float g = ((c >>  8) & 0xFF) / 255.0f;
-		float b = ((c >>  0) & 0xFF) / 255.0f;
-		p_brush->SetColor(D2D1::ColorF(r, g, b, a));
-		
-		// Get text format (use cached or default based on font style)
-		IDWriteTextFormat *fmt;
-		if (src->font_size > 0) {
-			fmt = Get_Text_Format(src->font_size, src->font_style);
-		} else {
-			// Use default format based on style
-			fmt = (src->font_style == 1) ? p_text_format_monospace : p_text_format_default;
-		}
-		
-		// Set alignment
-		DWRITE_TEXT_ALIGNMENT h_align;
-		if (src->align_h == UI_ALIGN_CENTER) h_align = DWRITE_TEXT_ALIGNMENT_CENTER;
-		else if (src->align_h == UI_ALIGN_END) h_align = DWRITE_TEXT_ALIGNMENT_TRAILING;
-		else h_align = DWRITE_TEXT_ALIGNMENT_LEADING;
-		
-		DWRITE_PARAGRAPH_ALIGNMENT v_align;
-		if (src->align_v == UI_ALIGN_CENTER) v_align = DWRITE_PARAGRAPH_ALIGNMENT_CENTER;
-		else if (src->align_v == UI_ALIGN_END) v_align = DWRITE_PARAGRAPH_ALIGNMENT_FAR;
-		else v_align = DWRITE_PARAGRAPH_ALIGNMENT_NEAR;
-		
-		fmt->SetTextAlignment(h_align);
-		fmt->SetParagraphAlignment(v_align);
-		
-		// Draw text
-		D2D1_RECT_F rect = D2D1::RectF(
-			(float)src->x, 
-			(float)src->y,
-			(float)(src->x + src->w), 
-			(float)(src->y + src->h)
-		);
-		
-		p_render_target->DrawText(
-			wtext, 
-			(UINT32)wcslen(wtext),
-			fmt,
-			rect,
-			p_brush
-		);
+	Color_Brush_Cache_Release();
+	Bitmap_Cache_Release();
+	Glyph_Atlas_Release();
+	if (p_brush) { p_brush->Release(); p_brush = 0; }
+	Swap_Chain_Release();
+	p_render_target = 0;
+	
+	if (Create_Hwnd_Render_Target(window)) {
+		p_render_target->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &p_brush);
+	} else {
+		MessageBoxA(NULL, "Failed to create Direct2D render target", "Error", MB_OK | MB_ICONERROR);
+		PostQuitMessage(1);
 	}
+	g_render_skip.force_full_redraw = 1;
 }
 
 
 // .............................................................................................
-void
-UI_Set_Cursor(HCURSOR cursor)
+// Record a new client size (WM_SIZE); the target is resized by Resize_Apply
+static void
+Resize_Request(HWND window, int w, int h)
 {
-	if (cursor != g_current_cursor) {
-		SetCursor(cursor);
-		g_current_cursor = cursor;
+	g_resize.pending = 1;
+	g_resize.pending_w = w;
+	g_resize.pending_h = h;
+	g_resize.size_messages++;
+	g_render_skip.force_full_redraw = 1;
+	
+	// The modal size loop blocks the main loop, so the paint it triggers renders instead
+	if (g_is_resizing) InvalidateRect(window, NULL, FALSE);
+}
+
+
+// .............................................................................................
+// Size the render target for the latest WM_SIZE (once per render, not per message)
+static void
+Resize_Apply()
+{
+	if (!g_resize.pending) return;
+	g_resize.pending = 0;
+	
+	int w = g_resize.pending_w;
+	int h = g_resize.pending_h;
+	if (g_swap_chain.enabled) {
+		// Slack buffers only while dragging; the final size is fitted exactly
+		int allow_larger = g_is_resizing && !g_resize.stretch;
+		if (!Swap_Chain_Resize(w, h, allow_larger)) Swap_Chain_Fall_Back();
+	} else if (p_hwnd_target) {
+		p_hwnd_target->Resize(D2D1::SizeU((UINT)w, (UINT)h));
+		g_resize.target_resizes++;
 	}
 }
 
 
 // .............................................................................................
+// Draw_Render_List - Submit the frame to Direct2D, skipping or clipping unchanged content
 void
-Wait_For_Target_Frame_Time()
+Draw_Render_List(UI_Render_List *list, int w, int h)
 {
-	PROFILE_ZONE;  // Auto-named "Wait_For_Target_Frame_Time"
+	PROFILE_ZONE;  // Auto-named "Draw_Render_List"
 	
-	// Calculate elapsed time this frame
-	LARGE_INTEGER current_time;
-	QueryPerformanceCounter(&current_time);
+	Render_Skip_State *skip = &g_render_skip;
 	
-	double elapsed_ms = (double)(current_time.QuadPart - g_frame_timer.frame_start.QuadPart) 
-	                    * 1000.0 / (double)g_frame_timer.frequency.QuadPart;
+	uint32_t hash = UI_Render_List_Hash(list);
+	int full = skip->force_full_redraw || skip->mode == APP_RENDER_ALWAYS ||
+	           w != skip->prev_w || h != skip->prev_h;
 	
-	// Busy-wait until we reach target frame time
-	while (elapsed_ms < g_frame_timer.target_frame_time_ms) {
-		QueryPerformanceCounter(&current_time);
-		elapsed_ms = (double)(current_time.QuadPart - g_frame_timer.frame_start.QuadPart) 
-		             * 1000.0 / (double)g_frame_timer.frequency.QuadPart;
-		
-		// Yield CPU if we're more than 1ms away
-		if (elapsed_ms < g_frame_timer.target_frame_time_ms - 1.0) {
-			Sleep(0);
+	if (!full && hash == skip->prev_hash) {
+		skip->frames_skipped++;
+		return;
+	}
+	
+	// Find the changed region (dirty-rect mode only)
+	UI_RectI dirty;
+	int partial = 0;
+	if (!full && skip->mode == APP_RENDER_DIRTY_RECTS) {
+		int change = UI_Render_List_Diff(&skip->prev_list, list, &dirty);
+		if (change == UI_RENDER_LIST_UNCHANGED) {
+			skip->prev_hash = hash;
+			skip->frames_skipped++;
+			return;
+		}
+		if (change == UI_RENDER_LIST_PARTIAL) {
+			// Pad for glyph overhang and antialiased edges
+			dirty.x -= 2; dirty.y -= 2;
+			dirty.w += 4; dirty.h += 4;
+			partial = 1;
 		}
 	}
 	
-	// Update frame timing
-	g_frame_timer.frame_end = current_time;
-	g_frame_timer.actual_frame_time_ms = elapsed_ms;
+	// Refresh cached panel bitmaps (their own BeginDraw/EndDraw, before the window's)
+	Bitmap_Cache_Prepare(list, partial ? &dirty : NULL);
 	
-	// Update FPS counter (once per second)
-	g_frame_timer.frame_count_for_fps++;
-	g_frame_timer.fps_update_timer += elapsed_ms;
+	p_render_target->BeginDraw();
 	
-	if (g_frame_timer.fps_update_timer >= 1000.0) {
-		g_frame_timer.actual_fps = g_frame_timer.frame_count_for_fps;
-		g_frame_timer.frame_count_for_fps = 0;
-		g_frame_timer.fps_update_timer -= 1000.0;
+	if (partial) {
+		D2D1_RECT_F clip = D2D1::RectF(
+			(float)dirty.x, 
+			(float)dirty.y, 
+			(float)(dirty.x + dirty.w), 
+			(float)(dirty.y + dirty.h)
+		);
+		p_render_target->PushAxisAlignedClip(clip, D2D1_ANTIALIAS_MODE_ALIASED);
+		p_render_target->Clear(D2D1::ColorF(D2D1::ColorF::Black));
+		
+		Render_UI(list, &dirty);
+		Bitmap_Cache_Draw(list);
+		Render_UI_Text(list, &dirty);
+		
+		p_render_target->PopAxisAlignedClip();
+		skip->last_dirty = dirty;
+		skip->frames_partial++;
+	} else {
+		p_render_target->Clear(D2D1::ColorF(D2D1::ColorF::Black));
+		
+		Render_UI(list, NULL);
+		Bitmap_Cache_Draw(list);
+		Render_UI_Text(list, NULL);
+		
+		skip->last_dirty.x = 0; skip->last_dirty.y = 0;
+		skip->last_dirty.w = w; skip->last_dirty.h = h;
+		skip->frames_full++;
 	}
 	
-	// Mark start of next frame
-	g_frame_timer.frame_start = current_time;
+	HRESULT hr = p_render_target->EndDraw();
+	
+	// The swap chain presents explicitly (the HWND target presented in EndDraw)
+	int lost = 0;
+	if (g_swap_chain.enabled) {
+		lost = FAILED(hr) || !Swap_Chain_Present(partial ? &dirty : NULL);
+	}
+	
+	skip->force_full_redraw = 0;
+	skip->prev_hash = hash;
+	skip->prev_w = w;
+	skip->prev_h = h;
+	if (skip->mode == APP_RENDER_DIRTY_RECTS) {
+		if (!UI_Render_List_Copy(&skip->prev_list, list)) skip->force_full_redraw = 1;
+	}
+	
+	if (lost) Swap_Chain_Fall_Back();
 }
 
 
 // .............................................................................................
-void
-Render(HWND window)
+// Cursor for the current interaction state (NULL = keep the current cursor)
+static HCURSOR
+App_Select_Cursor()
 {
-    PROFILE_ZONE;  // Profile entire render function
+    PROFILE_ZONE_N("Cursor Update");
     
-    // Use frame timer's actual frame time
-    float delta_time_ms = (float)g_frame_timer.actual_frame_time_ms;
+    if (g_ui_context.interaction.dragging_divider != 0) {
+        // During drag, keep resize cursor
+        int divider_idx = UI_Find_Panel_By_Id(&g_ui_context.state, g_ui_context.interaction.dragging_divider);
+        
+        if (divider_idx >= 0) {
+            UI_Panel *divider = &g_ui_context.state.panels[divider_idx];
+            if (divider->parent >= 0) {
+                if (g_ui_context.state.styles[divider->parent].direction == UI_DIRECTION_ROW) {
+                    return g_cursor_size_we;
+                } else {
+                    return g_cursor_size_ns;
+                }
+            }
+        }
+        return NULL;
+    }
     
-    RECT cr; GetClientRect(window, &cr);
-    int w = cr.right - cr.left;
-    int h = cr.bottom - cr.top;
+    if (g_ui_context.interaction.hot_widget != 0) {
+        // Check if hot widget is a resizable divider
+        int hot_idx = UI_Find_Panel_By_Id(&g_ui_context.state, g_ui_context.interaction.hot_widget);
+        
+        if (hot_idx >= 0 && g_ui_context.state.styles[hot_idx].resizable) {
+            UI_Panel *hot_panel = &g_ui_context.state.panels[hot_idx];
+            if (hot_panel->parent >= 0) {
+                if (g_ui_context.state.styles[hot_panel->parent].direction == UI_DIRECTION_ROW) {
+                    return g_cursor_size_we;
+                } else {
+                    return g_cursor_size_ns;
+                }
+            }
+            return NULL;
+        }
+    }
+    
+    return g_cursor_arrow;
+}
+
+
+// .............................................................................................
+// App_Phase_Timer - Scoped QPC timer adding its scope's duration to *out_ms
+// Always compiled (PROFILE_ZONE is empty without TRACY_ENABLE); feeds UI_Frame_Stats.
+struct App_Phase_Timer {
+    float *out_ms;
+    LARGE_INTEGER start;
+    
+    App_Phase_Timer(float *out) : out_ms(out) { QueryPerformanceCounter(&start); }
+    ~App_Phase_Timer()
+    {
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&end);
+        *out_ms += (float)((double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)g_frame_timer.frequency.QuadPart);
+    }
+};
+#define APP_PHASE_TIMER(sample, phase) App_Phase_Timer phase_timer(&(sample)->phase_ms[phase])
 
-    p_render_target->BeginDraw();
-    p_render_target->Clear(D2D1::ColorF(D2D1::ColorF::Black));
 
-    // Use global context
-    g_ui_context.measure_text = App_Measure_Text;
-    UI_Render_List list;
-    memset(&list, 0, sizeof(UI_Render_List));
-    UI_Begin_Frame_With_Time(&g_ui_context, &list, w, h, delta_time_ms);
+// .............................................................................................
+// App_Build_Frame - One UI frame into list: build, layout, interaction, emit
+// Runs on the main thread, or on the pipeline worker (then nothing else touches
+// g_ui_context until it finishes). Fills the UI phases and counts of sample.
+// input_latency_ms is passed in because Latency_Record writes g_latency during the draw.
+// Returns the cursor to show (NULL = keep).
+static HCURSOR
+App_Build_Frame(UI_Render_List *list, int w, int h, float delta_time_ms, float input_latency_ms,
+                UI_Frame_Sample *sample)
+{
+    PROFILE_ZONE;  // Auto-named "App_Build_Frame"
     
-    // Update FPS for debug display
-    g_ui_context.current_fps = g_frame_timer.actual_fps;
+    uint64_t measure_hits = g_text_measure_cache.hits;
+    uint64_t measure_misses = g_text_measure_cache.misses;
     
     // Build UI tree
     {
         PROFILE_ZONE_N("UI Build");
+        APP_PHASE_TIMER(sample, UI_PHASE_BUILD);
+        
+        // Use global context
+        g_ui_context.measure_text = App_Measure_Text;
+        UI_Begin_Frame_With_Time(&g_ui_context, list, w, h, delta_time_ms);
+        
+        // Update FPS, pacing jitter and latency for debug display
+        g_ui_context.current_fps = g_frame_timer.actual_fps;
+        g_ui_context.frame_jitter_ms = (float)g_frame_timer.jitter_stddev_ms;
+        g_ui_context.input_latency_ms = input_latency_ms;
+        
         App_UI_Build(&g_ui_context);
     }
     
     // Layout (calculates panel rects)
     if (g_ui_context.state.panel_count > 0) {
         PROFILE_ZONE_N("UI Layout");
+        APP_PHASE_TIMER(sample, UI_PHASE_LAYOUT);
         UI_Layout_Panel_Tree(&g_ui_context.state, 0);
     }
     
     // Update interaction (after layout, before render)
     {
         PROFILE_ZONE_N("UI Interaction");
+        APP_PHASE_TIMER(sample, UI_PHASE_INTERACTION);
         UI_Update_Interaction(&g_ui_context);
     }
     
     // Cursor selection based on hot widget and drag state
-    {
-        PROFILE_ZONE_N("Cursor Update");
-        if (g_ui_context.interaction.dragging_divider != 0) {
-            // During drag, keep resize cursor
-            int divider_idx = -1;
-            for (int i = 0; i < g_ui_context.state.panel_count; i++) {
-                if (g_ui_context.state.panels[i].id == g_ui_context.interaction.dragging_divider) {
-                    divider_idx = i;
-                    break;
-                }
-            }
-            
-            if (divider_idx >= 0) {
-                UI_Panel *divider = &g_ui_context.state.panels[divider_idx];
-                if (divider->parent >= 0) {
-                    UI_Panel *parent = &g_ui_context.state.panels[divider->parent];
-                    if (parent->style.direction == UI_DIRECTION_ROW) {
-                        UI_Set_Cursor(g_cursor_size_we);
-                    } else {
-                        UI_Set_Cursor(g_cursor_size_ns);
-                    }
-                }
-            }
-        } else if (g_ui_context.interaction.hot_widget != 0) {
-            // Check if hot widget is a resizable divider
-            int hot_idx = -1;
-            for (int i = 0; i < g_ui_context.state.panel_count; i++) {
-                if (g_ui_context.state.panels[i].id == g_ui_context.interaction.hot_widget) {
-                    hot_idx = i;
-                    break;
-                }
-            }
-            
-            if (hot_idx >= 0 && g_ui_context.state.panels[hot_idx].style.resizable) {
-                UI_Panel *hot_panel = &g_ui_context.state.panels[hot_idx];
-                if (hot_panel->parent >= 0) {
-                    UI_Panel *parent = &g_ui_context.state.panels[hot_panel->parent];
-                    if (parent->style.direction == UI_DIRECTION_ROW) {
-                        UI_Set_Cursor(g_cursor_size_we);
-                    } else {
-                        UI_Set_Cursor(g_cursor_size_ns);
-                    }
-                }
-            } else {
-                UI_Set_Cursor(g_cursor_arrow);
-            }
-        } else {
-            UI_Set_Cursor(g_cursor_arrow);
-        }
-    }
+    HCURSOR cursor = App_Select_Cursor();
     
     // Render
     if (g_ui_context.state.panel_count > 0) {
         PROFILE_ZONE_N("UI Emit");
+        APP_PHASE_TIMER(sample, UI_PHASE_EMIT);
         UI_Emit_Panels(&g_ui_context.state, 0);
     }
-
-    Render_UI(&list);
-    Render_UI_Text(&list);
-
-    p_render_target->EndDraw();
+    
+    sample->panels = g_ui_context.state.panel_count;
+    sample->rectangles = list->rect_count;
+    sample->texts = list->text_count;
+    sample->measure_hits = (int)(g_text_measure_cache.hits - measure_hits);
+    sample->measure_misses = (int)(g_text_measure_cache.misses - measure_misses);
     
     // Copy input state for next frame's edge detection
     UI_Input_EndFrame(&g_ui_context);
+    return cursor;
+}
+
+
+// .............................................................................................
+// Complete a drawn frame's sample and add it to the stats ring (worker must be idle)
+static void
+Frame_Stats_Record(UI_Frame_Sample *sample, float delta_time_ms)
+{
+    sample->frame_ms = delta_time_ms;
+    sample->cpu_ms = 0.0f;
+    for (int ph = 0; ph < UI_PHASE_COUNT; ph++) sample->cpu_ms += sample->phase_ms[ph];
+    UI_Frame_Stats_Push(&g_ui_context.frame_stats, sample);
+}
+
+
+// .............................................................................................
+// Record input-snapshot-to-present latency of the frame just drawn
+static void
+Latency_Record(LARGE_INTEGER snapshot_time)
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    double ms = (double)(now.QuadPart - snapshot_time.QuadPart) * 1000.0 / (double)g_frame_timer.frequency.QuadPart;
+    
+    App_Latency_Stats *st = &g_latency;
+    st->last_ms = ms;
+    st->sum_ms += ms;
+    if (ms > st->max_ms) st->max_ms = ms;
+    
+    if (++st->samples >= APP_LATENCY_WINDOW_FRAMES) {
+        st->avg_ms = st->sum_ms / st->samples;
+        st->window_max_ms = st->max_ms;
+        st->sum_ms = 0.0;
+        st->max_ms = 0.0;
+        st->samples = 0;
+    }
+}
+
+
+// .............................................................................................
+static DWORD WINAPI
+Pipeline_Worker(LPVOID param)
+{
+    App_Pipeline *pl = (App_Pipeline *)param;
+    
+    for (;;) {
+        WaitForSingleObject(pl->kick_event, INFINITE);
+        if (pl->quit) break;
+        
+        int job = pl->job_list;
+        memset(&pl->samples[job], 0, sizeof(UI_Frame_Sample));
+        pl->job_cursor = App_Build_Frame(&pl->lists[job], pl->built_w[job], pl->built_h[job],
+                                         pl->job_delta_time_ms, pl->job_input_latency_ms, &pl->samples[job]);
+        SetEvent(pl->done_event);
+    }
+    
+    return 0;
+}
+
+
+// .............................................................................................
+// Start the worker thread. Returns 0 (pipeline stays disabled) if it cannot be created.
+static int
+Pipeline_Start()
+{
+    App_Pipeline *pl = &g_pipeline;
+    pl->kick_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    pl->done_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (pl->kick_event && pl->done_event) {
+        pl->thread = CreateThread(NULL, 0, Pipeline_Worker, pl, 0, NULL);
+    }
+    
+    if (!pl->thread) {
+        if (pl->kick_event) CloseHandle(pl->kick_event);
+        if (pl->done_event) CloseHandle(pl->done_event);
+        memset(pl, 0, sizeof(App_Pipeline));
+        return 0;
+    }
+    
+    pl->enabled = 1;
+    return 1;
+}
+
+
+// .............................................................................................
+// Stop the worker (it is idle between frames) and free the render lists
+static void
+Pipeline_Stop()
+{
+    App_Pipeline *pl = &g_pipeline;
+    if (pl->thread) {
+        InterlockedExchange(&pl->quit, 1);
+        SetEvent(pl->kick_event);
+        WaitForSingleObject(pl->thread, INFINITE);
+        CloseHandle(pl->thread);
+        CloseHandle(pl->kick_event);
+        CloseHandle(pl->done_event);
+    }
+    
+    UI_Render_List_Free(&pl->lists[0]);
+    UI_Render_List_Free(&pl->lists[1]);
+    memset(pl, 0, sizeof(App_Pipeline));
+}
+
+
+// .............................................................................................
+// Pipelined frame: kick the build of the next frame, draw the previous one meanwhile,
+// then wait for the build (so at most one frame is in flight)
+static void
+Render_Pipelined(int w, int h, float delta_time_ms)
+{
+    App_Pipeline *pl = &g_pipeline;
+    int back = pl->front ^ 1;
+    
+    pl->job_list = back;
+    pl->job_delta_time_ms = delta_time_ms;
+    pl->job_input_latency_ms = (float)g_latency.avg_ms;
+    pl->built_w[back] = w;
+    pl->built_h[back] = h;
+    QueryPerformanceCounter(&pl->snapshot_time[back]);
+    SetEvent(pl->kick_event);
+    
+    if (pl->has_front) {
+        {
+            APP_PHASE_TIMER(&pl->samples[pl->front], UI_PHASE_DRAW);
+            Draw_Render_List(&pl->lists[pl->front], pl->built_w[pl->front], pl->built_h[pl->front]);
+        }
+        Latency_Record(pl->snapshot_time[pl->front]);
+    }
+    
+    {
+        PROFILE_ZONE_N("Pipeline Wait");
+        WaitForSingleObject(pl->done_event, INFINITE);
+    }
+    
+    if (pl->has_front) Frame_Stats_Record(&pl->samples[pl->front], delta_time_ms);
+    
+    if (pl->job_cursor) UI_Set_Cursor(pl->job_cursor);
+    pl->front = back;
+    pl->has_front = 1;
+}
+
+
+// .............................................................................................
+void
+Render(HWND window)
+{
+    PROFILE_ZONE;  // Profile entire render function
+    
+    if (!p_render_target) return;  // Backend lost, quitting
+    
+    // Apply the latest client size (WM_SIZE only records it)
+    Resize_Apply();
+    if (!p_render_target) return;
+    
+    // Flip model: wait until a frame can be queued, so input is sampled as late as possible
+    Swap_Chain_Wait();
+    
+    // Use frame timer's actual frame time
+    float delta_time_ms = (float)g_frame_timer.actual_frame_time_ms;
+    
+    RECT cr; GetClientRect(window, &cr);
+    int w = cr.right - cr.left;
+    int h = cr.bottom - cr.top;
+    
+    if (g_pipeline.enabled) {
+        Render_Pipelined(w, h, delta_time_ms);
+        return;
+    }
+    
+    LARGE_INTEGER snapshot_time;
+    QueryPerformanceCounter(&snapshot_time);
+    
+    UI_Frame_Sample sample;
+    memset(&sample, 0, sizeof(UI_Frame_Sample));
+    
+    UI_Render_List *list = &g_render_list_storage;
+    HCURSOR cursor = App_Build_Frame(list, w, h, delta_time_ms, (float)g_latency.avg_ms, &sample);
+    if (cursor) UI_Set_Cursor(cursor);
+    
+    {
+        APP_PHASE_TIMER(&sample, UI_PHASE_DRAW);
+        Draw_Render_List(list, w, h);
+    }
+    Latency_Record(snapshot_time);
+    Frame_Stats_Record(&sample, delta_time_ms);
+}
+
+
+// .............................................................................................
+// Render for the modal size loop: at most once per DWM composition tick. A request inside
+// a tick that already rendered arms the timer for a trailing render of the final size.
+static void
+Resize_Render(HWND window)
+{
+    App_Resize_State *rs = &g_resize;
+    rs->paints++;
+    
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    
+    // Earliest time of the next render: the next composition tick if this one already
+    // rendered (60 Hz after the last render when composition timing is unavailable)
+    LONGLONG period = g_frame_timer.frequency.QuadPart / 60;
+    LONGLONG next_render = rs->last_render.QuadPart + period;
+    DWM_TIMING_INFO timing;
+    memset(&timing, 0, sizeof(timing));
+    timing.cbSize = sizeof(timing);
+    if (SUCCEEDED(DwmGetCompositionTimingInfo(NULL, &timing)) && timing.qpcRefreshPeriod > 0) {
+        period = (LONGLONG)timing.qpcRefreshPeriod;
+        LONGLONG since_vblank = now.QuadPart - (LONGLONG)timing.qpcVBlank;
+        LONGLONG tick_start = now.QuadPart - ((since_vblank > 0) ? since_vblank % period : 0);
+        next_render = (rs->last_render.QuadPart >= tick_start) ? tick_start + period : now.QuadPart;
+    }
+    
+    if (now.QuadPart < next_render) {
+        rs->coalesced++;
+        if (!rs->timer_armed) {
+            UINT wait_ms = (UINT)((next_render - now.QuadPart) * 1000 / g_frame_timer.frequency.QuadPart);
+            SetTimer(window, APP_RESIZE_TIMER_ID, (wait_ms > 0) ? wait_ms : 1, NULL);
+            rs->timer_armed = 1;
+        }
+        return;
+    }
+    
+    RECT cr; GetClientRect(window, &cr);
+    int w = cr.right - cr.left;
+    int h = cr.bottom - cr.top;
+    if (w == rs->last_render_w && h == rs->last_render_h) rs->redundant_renders++;
+    
+    Render(window);
+    
+    rs->renders++;
+    rs->last_render = now;
+    rs->last_render_w = w;
+    rs->last_render_h = h;
 }
 
 
@@ -514,16 +2946,9 @@ MainWindowCallback(HWND window, UINT message, WPARAM wparam, LPARAM lparam)
 
 		case WM_SIZE:
 		{
-			if (p_render_target)
-			{
-				UINT width = LOWORD(lparam);
-				UINT height = HIWORD(lparam);
-				p_render_target->Resize(D2D1::SizeU(width, height));
-			}
-
-		InvalidateRect(window, NULL, FALSE);
-
-	} break;
+			// Coalesced: the target is resized once before the next render
+			Resize_Request(window, LOWORD(lparam), HIWORD(lparam));
+		} break;
 
 	case WM_MOUSEMOVE:
 	{
@@ -610,9 +3035,12 @@ MainWindowCallback(HWND window, UINT message, WPARAM wparam, LPARAM lparam)
 			PAINTSTRUCT paint_struct;
 			BeginPaint(window, &paint_struct);
 			
-			// Render during resize (Windows blocks main loop)
+			// Window contents may have been invalidated externally
+			g_render_skip.force_full_redraw = 1;
+			
+			// Render during resize (Windows blocks main loop), once per composition tick
 			if (g_is_resizing) {
-				Render(window);
+				Resize_Render(window);
 			}
 			// Otherwise, continuous loop handles rendering
 			
@@ -625,6 +3053,16 @@ MainWindowCallback(HWND window, UINT message, WPARAM wparam, LPARAM lparam)
 		return 1;
 	}
 	
+	case WM_TIMER:
+	{
+		// Trailing render of a composition tick that coalesced paints
+		if (wparam == APP_RESIZE_TIMER_ID) {
+			KillTimer(window, APP_RESIZE_TIMER_ID);
+			g_resize.timer_armed = 0;
+			if (g_is_resizing) Resize_Render(window);
+		}
+	} break;
+	
 	case WM_ENTERSIZEMOVE:
 	{
 		g_is_resizing = true;
@@ -633,6 +3071,12 @@ MainWindowCallback(HWND window, UINT message, WPARAM wparam, LPARAM lparam)
 	case WM_EXITSIZEMOVE:
 	{
 		g_is_resizing = false;
+		KillTimer(window, APP_RESIZE_TIMER_ID);
+		g_resize.timer_armed = 0;
+		
+		// Fit swap chain buffers that kept slack during the drag
+		RECT cr; GetClientRect(window, &cr);
+		Resize_Request(window, cr.right - cr.left, cr.bottom - cr.top);
 	} break;
 
 	case WM_CLOSE:
@@ -642,18 +3086,39 @@ MainWindowCallback(HWND window, UINT message, WPARAM wparam, LPARAM lparam)
 
         case WM_DESTROY:
 		{
+			// Stop the pipeline worker before the state it builds is freed
+			Pipeline_Stop();
+			
+			// Last built frame and measurements for the next startup (before any release)
+			App_Snapshot_Save();
+			g_ui_context.state.layout_pool = NULL;
+			Task_Pool_Shutdown(&g_layout_pool);
+			
+			// Release retained text layouts (before the formats they reference)
+			Text_Layout_Cache_Release();
+			Text_Measure_Cache_Release();
+			Color_Brush_Cache_Release();
+			Bitmap_Cache_Release();
+			Glyph_Atlas_Release();
+			
+			// Free render list storage
+			UI_Context_Free(&g_ui_context);
+			UI_Render_List_Free(&g_render_list_storage);
+			UI_Render_List_Free(&g_render_skip.prev_list);
+			free(g_rect_batcher.batches);
+			free(g_rect_batcher.rect_next);
+			memset(&g_rect_batcher, 0, sizeof(Rect_Batcher));
+			
 			// Release cached text formats
-			for (int i = 0; i < g_text_format_cache.count; i++) {
-				if (g_text_format_cache.formats[i]) {
-					g_text_format_cache.formats[i]->Release();
-				}
-			}
-			g_text_format_cache.count = 0;
+			Text_Format_Cache_Release();
+			DeleteCriticalSection(&g_text_format_lock);
 			
 			if (p_text_format_default) { p_text_format_default->Release(); p_text_format_default = 0; }
 			if (p_text_format_monospace) { p_text_format_monospace->Release(); p_text_format_monospace = 0; }
 			if (p_dwrite_factory) { p_dwrite_factory->Release(); p_dwrite_factory = 0; }
-			if (p_render_target) { p_render_target->Release(); p_render_target = 0; }
+			Swap_Chain_Release();
+			if (p_hwnd_target) { p_hwnd_target->Release(); p_hwnd_target = 0; }
+			p_render_target = 0;
 			if (p_brush) { p_brush->Release(); p_brush = 0; }
 			if (p_d2d_factory) { p_d2d_factory->Release(); p_d2d_factory = 0; }
 			PostQuitMessage(0);
@@ -713,14 +3178,23 @@ WinMain(HINSTANCE instance, HINSTANCE previous_instance, LPSTR command_line, int
 				}
 			}
 
-			RECT client_rect;
-			GetClientRect(window, &client_rect);
-			HRESULT result = p_d2d_factory->CreateHwndRenderTarget(D2D1::RenderTargetProperties(),
-					D2D1::HwndRenderTargetProperties(window, D2D1::SizeU(client_rect.right - client_rect.left, client_rect.bottom - client_rect.top),
-					D2D1_PRESENT_OPTIONS_IMMEDIATELY),
-					&p_render_target);
+			// Drag resizing (--resize=stretch shows the stretched last frame between renders)
+			memset(&g_resize, 0, sizeof(App_Resize_State));
+			if (command_line && strstr(command_line, "--resize=stretch")) g_resize.stretch = 1;
+			
+			// Render backend: flip-model swap chain with --present=flip, else (or if it
+			// cannot be created) the HWND render target
+			int have_target = 0;
+			if (command_line && strstr(command_line, "--present=flip"))
+			{
+				RECT client_rect;
+				GetClientRect(window, &client_rect);
+				have_target = Swap_Chain_Create(window, client_rect.right - client_rect.left,
+				                                client_rect.bottom - client_rect.top);
+			}
+			if (!have_target) have_target = Create_Hwnd_Render_Target(window);
 
-		if (SUCCEEDED(result))
+		if (have_target)
 		{
 			p_render_target->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &p_brush);
 		}
@@ -797,20 +3271,34 @@ WinMain(HINSTANCE instance, HINSTANCE previous_instance, LPSTR command_line, int
 			p_text_format_monospace->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR);
 		}
 		
-		// Initialize cache
-		g_text_format_cache.count = 0;
+		// Initialize caches
+		memset(&g_text_format_cache, 0, sizeof(Text_Format_Cache));
+		Text_Measure_Cache_Init();
+		Text_Layout_Cache_Init();
 	}
 	
+	// Text format cache lock (taken by measure on the pipeline worker)
+	InitializeCriticalSection(&g_text_format_lock);
+	
 	// Initialize UI context
 	memset(&g_ui_context, 0, sizeof(UI_Context));
 	g_ui_context.frame_number = 0;
 	g_ui_context.delta_time_ms = 0.0f;
-	g_ui_context.last_button_clicked[0] = 0;  // Empty string
 	
 	// Initialize input system
 	UI_Input_Init(&g_ui_context.input);
 	UI_Input_Init(&g_ui_context.input_prev);
 	
+	// Input events are stamped with QPC ticks when the window procedure queues them
+	LARGE_INTEGER input_clock_frequency;
+	QueryPerformanceFrequency(&input_clock_frequency);
+	g_ui_context.input_queue.clock = App_Input_Clock;
+	g_ui_context.input_queue.clock_frequency = input_clock_frequency.QuadPart;
+	
+	// Warm start from the snapshot saved on the last exit (--snapshot=off skips it)
+	App_Snapshot_Init(command_line);
+	App_Snapshot_Load();
+	
 	// Initialize cursor handles
 	g_cursor_arrow = LoadCursor(NULL, IDC_ARROW);
 	g_cursor_size_we = LoadCursor(NULL, IDC_SIZEWE);
@@ -818,14 +3306,69 @@ WinMain(HINSTANCE instance, HINSTANCE previous_instance, LPSTR command_line, int
 	g_current_cursor = g_cursor_arrow;
 	SetCursor(g_cursor_arrow);  // Set initial cursor to prevent spinning wheel
 	
+	// Initialize frame skipping (first frame always draws)
+	memset(&g_render_skip, 0, sizeof(Render_Skip_State));
+	g_render_skip.mode = APP_RENDER_SKIP_UNCHANGED;
+	g_render_skip.force_full_redraw = 1;
+	if (command_line) {
+		if (strstr(command_line, "--render=always")) g_render_skip.mode = APP_RENDER_ALWAYS;
+		if (strstr(command_line, "--render=dirty"))  g_render_skip.mode = APP_RENDER_DIRTY_RECTS;
+	}
+	
+	// Text backend (--text=atlas draws ASCII labels from glyph atlases, default is layouts)
+	memset(&g_glyph_atlas_cache, 0, sizeof(Glyph_Atlas_Cache));
+	if (command_line && strstr(command_line, "--text=atlas")) {
+		g_glyph_atlas_cache.enabled = 1;
+	}
+	
+	// Frame statistics overlay starts visible with --stats (F2 toggles it)
+	if (command_line && strstr(command_line, "--stats")) {
+		g_ui_context.frame_stats.overlay_visible = 1;
+	}
+	
+	// Initialize parallel layout (--layout-threads=N, 0 = one per core, default serial)
+	if (command_line) {
+		const char *threads_arg = strstr(command_line, "--layout-threads=");
+		if (threads_arg) {
+			int threads = atoi(threads_arg + 17);
+			if (threads == 0) threads = Task_Pool_Default_Worker_Count();
+			if (threads > 1 && Task_Pool_Init(&g_layout_pool, threads)) {
+				g_ui_context.state.layout_pool = &g_layout_pool;
+			}
+		}
+	}
+	
+	// Initialize build/render pipeline (--pipeline, falls back to serial frames)
+	if (command_line && strstr(command_line, "--pipeline")) {
+		Pipeline_Start();
+	}
+	
+	// Initialize bitmap cache budget (--bitmap-cache=<MB>, 0 disables it)
+	memset(&g_bitmap_cache, 0, sizeof(Bitmap_Cache));
+	g_bitmap_cache.budget_bytes = APP_BITMAP_CACHE_BUDGET;
+	if (command_line) {
+		const char *budget_arg = strstr(command_line, "--bitmap-cache=");
+		if (budget_arg) {
+			int mb = atoi(budget_arg + 15);
+			if (mb >= 0 && mb <= 1024) g_bitmap_cache.budget_bytes = mb * 1024 * 1024;
+		}
+	}
+	
 	// Initialize frame timing system
-	QueryPerformanceFrequency(&g_frame_timer.frequency);
-	QueryPerformanceCounter(&g_frame_timer.frame_start);
-	g_frame_timer.target_fps = 720;
-	g_frame_timer.target_frame_time_ms = 1000.0 / g_frame_timer.target_fps;
-	g_frame_timer.actual_fps = 0;
-	g_frame_timer.fps_update_timer = 0.0;
-	g_frame_timer.frame_count_for_fps = 0;
+	int pacing_mode = FRAME_PACING_WAITABLE_TIMER;
+	int target_fps = 720;
+	if (command_line) {
+		if (strstr(command_line, "--pacing=busy"))  pacing_mode = FRAME_PACING_BUSY_WAIT;
+		if (strstr(command_line, "--pacing=vsync")) pacing_mode = FRAME_PACING_DWM_VSYNC;
+		if (strstr(command_line, "--pacing=idle"))  pacing_mode = FRAME_PACING_IDLE;
+		
+		const char *fps_arg = strstr(command_line, "--fps=");
+		if (fps_arg) {
+			int fps = atoi(fps_arg + 6);
+			if (fps > 0) target_fps = fps;
+		}
+	}
+	Frame_Timer_Init(pacing_mode, target_fps);
 
 	ShowWindow(window, SW_MAXIMIZE);
 			UpdateWindow(window);
@@ -834,8 +3377,10 @@ WinMain(HINSTANCE instance, HINSTANCE previous_instance, LPSTR command_line, int
 		while (g_is_running)
 		{
 			// Process all pending messages (non-blocking)
+			int message_count = 0;
 			while (PeekMessage(&message, 0, 0, 0, PM_REMOVE))
 			{
+				message_count++;
 				if(message.message == WM_QUIT)
 				{
 					g_is_running = false;
@@ -846,13 +3391,17 @@ WinMain(HINSTANCE instance, HINSTANCE previous_instance, LPSTR command_line, int
 				DispatchMessageW(&message);
 			}
 			
+			g_frame_timer.quiet_frames = message_count ? 0 : g_frame_timer.quiet_frames + 1;
+			
 		Render(window);
 		
-		// Wait for target frame time (precise pacing)
+		// Wait for next frame according to the pacing policy
 		Wait_For_Target_Frame_Time();
 		
 		PROFILE_FRAME;  // Mark end of frame for Tracy profiler
 	}
+	
+	Frame_Timer_Shutdown();
 	}
 	
 	return 0;
@@ -0,0 +1,461 @@
+// benchmark.cpp - Layout micro-benchmark (console, unity build like application.cpp)
+//
+// Builds a large synthetic panel tree once and times repeated layout passes over it:
+//   - SoA: the library's UI_Layout_Panel_Tree (hot links/rects, styles, cold label data
+//     in separate arrays)
+//   - AoS: reference copy of the previous layout code over the old fat UI_Panel
+//     (style and a 256-byte label buffer inline), for before/after comparison; its flex
+//     shares use the library's exact integer edges, computed in plain int64 math
+//   - Cached: UI_Layout_Panel_Tree with the layout cache enabled on an unchanged tree
+//     (the SoA/AoS runs disable the cache so they measure full layouts)
+//   - Parallel: full layouts with UI_State::layout_pool set (work-stealing task pool)
+//   - Grid: a heatmap-like tree of flex rows with row_width children each (the flex
+//     kernel's wide case), SoA against AoS, and a check that every flex row and column
+//     ends exactly at its content edge (no pixels lost to rounding)
+// All runs are checked to produce identical rects.
+//
+// Usage: benchmark.exe [panel_count] [iterations] [threads] [row_width]
+//   (defaults: 10000 panels, 200 iterations, one thread per core, 512 children per grid row)
+//
+#include <windows.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "ui.cpp"
+#include "task_pool.cpp"
+
+
+// AoS reference panel (layout of UI_Panel before the hot/cold split)
+struct Bench_AoS_Panel {
+	UI_Id id;
+	UI_Style style;
+	int parent;
+	int first_child;
+	int last_child;
+	int next_sibling;
+	UI_RectI rect;
+	char label_text[MAX_UI_TEXT_LENGTH];
+	uint32_t label_color;
+	int label_font_style;
+	int is_label;
+};
+
+
+// .............................................................................................
+static double
+Bench_Now_Ms()
+{
+	static LARGE_INTEGER frequency;
+	if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart * 1000.0 / (double)frequency.QuadPart;
+}
+
+
+// .............................................................................................
+static void
+Bench_AoS_Layout_Row(Bench_AoS_Panel *panels, int panel_idx)
+{
+	Bench_AoS_Panel *p = &panels[panel_idx];
+
+	int x0 = p->rect.x + p->style.pad_l;
+	int y0 = p->rect.y + p->style.pad_t;
+	int cw = p->rect.w - (p->style.pad_l + p->style.pad_r);
+	int ch = p->rect.h - (p->style.pad_t + p->style.pad_b);
+	if (cw < 0) cw = 0;
+	if (ch < 0) ch = 0;
+
+	int child_count = 0;
+	int fixed_sum = 0;
+	int64_t grow_sum = 0;
+
+	for (int c = p->first_child; c != -1; c = panels[c].next_sibling) {
+		child_count++;
+		Bench_AoS_Panel *child = &panels[c];
+		fixed_sum += (child->style.pref_w >= 0) ? child->style.pref_w : 0;
+		grow_sum += UI_Layout_Grow_Units(child->style.flex_grow);
+	}
+
+	int gaps_total = (child_count > 1) ? (p->style.gap * (child_count - 1)) : 0;
+	int remaining = cw - fixed_sum - gaps_total;
+	if (remaining < 0) remaining = 0;
+
+	int cursor_x = x0;
+	int64_t grow_cum = 0;
+	int prev_edge = 0;
+	for (int c = p->first_child; c != -1; c = panels[c].next_sibling) {
+		Bench_AoS_Panel *child = &panels[c];
+		int w = (child->style.pref_w >= 0) ? child->style.pref_w : 0;
+		if (grow_sum > 0) {
+			grow_cum += UI_Layout_Grow_Units(child->style.flex_grow);
+			int edge = (int)((int64_t)remaining * grow_cum / grow_sum);
+			w += edge - prev_edge;
+			prev_edge = edge;
+		}
+		child->rect.x = cursor_x;
+		child->rect.y = y0;
+		child->rect.w = w;
+		child->rect.h = ch;
+		cursor_x += w + p->style.gap;
+	}
+}
+
+
+// .............................................................................................
+static void
+Bench_AoS_Layout_Column(Bench_AoS_Panel *panels, int panel_idx)
+{
+	Bench_AoS_Panel *p = &panels[panel_idx];
+
+	int x0 = p->rect.x + p->style.pad_l;
+	int y0 = p->rect.y + p->style.pad_t;
+	int cw = p->rect.w - (p->style.pad_l + p->style.pad_r);
+	int ch = p->rect.h - (p->style.pad_t + p->style.pad_b);
+	if (cw < 0) cw = 0;
+	if (ch < 0) ch = 0;
+
+	int child_count = 0;
+	int fixed_sum = 0;
+	int64_t grow_sum = 0;
+
+	for (int c = p->first_child; c != -1; c = panels[c].next_sibling) {
+		child_count++;
+		Bench_AoS_Panel *child = &panels[c];
+		fixed_sum += (child->style.pref_h >= 0) ? child->style.pref_h : 0;
+		grow_sum += UI_Layout_Grow_Units(child->style.flex_grow);
+	}
+
+	int gaps_total = (child_count > 1) ? (p->style.gap * (child_count - 1)) : 0;
+	int remaining = ch - fixed_sum - gaps_total;
+	if (remaining < 0) remaining = 0;
+
+	int cursor_y = y0;
+	int64_t grow_cum = 0;
+	int prev_edge = 0;
+	for (int c = p->first_child; c != -1; c = panels[c].next_sibling) {
+		Bench_AoS_Panel *child = &panels[c];
+		int h = (child->style.pref_h >= 0) ? child->style.pref_h : 0;
+		if (grow_sum > 0) {
+			grow_cum += UI_Layout_Grow_Units(child->style.flex_grow);
+			int edge = (int)((int64_t)remaining * grow_cum / grow_sum);
+			h += edge - prev_edge;
+			prev_edge = edge;
+		}
+		child->rect.x = x0;
+		child->rect.y = cursor_y;
+		child->rect.w = cw;
+		child->rect.h = h;
+		cursor_y += h + p->style.gap;
+	}
+}
+
+
+// .............................................................................................
+static void
+Bench_AoS_Layout_Tree(Bench_AoS_Panel *panels, int panel_idx)
+{
+	Bench_AoS_Panel *p = &panels[panel_idx];
+	if (p->first_child == -1) return;
+
+	if (p->style.direction == 0)      Bench_AoS_Layout_Row(panels, panel_idx);
+	else if (p->style.direction == 1) Bench_AoS_Layout_Column(panels, panel_idx);
+
+	for (int c = p->first_child; c != -1; c = panels[c].next_sibling)
+		Bench_AoS_Layout_Tree(panels, c);
+}
+
+
+// .............................................................................................
+// Build a synthetic tree: root column -> rows -> mix of fixed, flex and label leaves
+static void
+Bench_Build_Tree(UI_Context *ui, int panel_count)
+{
+	int rows = 1;
+	while (rows * rows < panel_count) rows++;
+	int per_row = (panel_count - 1) / rows - 1;
+	if (per_row < 1) per_row = 1;
+
+	UI_Id next_id = 1;
+	UI_Begin_Panel_With_Id(ui, next_id++, "root");
+	UI_Panel_Set_Direction(ui, UI_DIRECTION_COLUMN);
+	UI_Panel_Set_Padding_Uniform(ui, 4);
+	UI_Panel_Set_Gap(ui, 1);
+
+	while (ui->state.panel_count < panel_count) {
+		UI_Begin_Panel_With_Id(ui, next_id++, "row");
+		UI_Panel_Set_Direction(ui, UI_DIRECTION_ROW);
+		UI_Panel_Set_Size(ui, -1, 12);
+		UI_Panel_Set_Shrink(ui, 0.0f);  // Rows overflow the root (the AoS reference never shrinks)
+		UI_Panel_Set_Gap(ui, 2);
+		UI_Panel_Set_Padding(ui, 2, 1, 2, 1);
+
+		for (int c = 0; c < per_row && ui->state.panel_count < panel_count; c++) {
+			UI_Begin_Panel_With_Id(ui, next_id++, "leaf");
+			UI_Panel_Set_Shrink(ui, 0.0f);  // Long rows overflow 1920px, the reference does not shrink
+			if (c % 3 == 0) {
+				UI_Panel_Set_Size(ui, 24 + (c % 7), -1);
+			} else {
+				UI_Panel_Set_Grow(ui, 1.0f + (float)(c % 4));
+			}
+
+			// Some leaves carry label data (exercises the cold array in the SoA layout)
+			if (c % 5 == 0) {
+				int idx = ui->parent_stack[ui->parent_stack_count - 1];
+				ui->state.cold[idx].is_label = 1;
+				ui->state.cold[idx].label_text = UI_Frame_String(&ui->state, "label");
+			}
+			UI_End_Panel(ui);
+		}
+
+		UI_End_Panel(ui);
+	}
+
+	UI_End_Panel(ui);
+}
+
+
+// .............................................................................................
+// Build a grid: root column of flex rows, each with row_width cells (mostly flex, every
+// eighth one fixed), gapless like a heatmap
+static void
+Bench_Build_Grid(UI_Context *ui, int rows, int row_width)
+{
+	UI_Id next_id = 1;
+	UI_Begin_Panel_With_Id(ui, next_id++, "grid");
+	UI_Panel_Set_Direction(ui, UI_DIRECTION_COLUMN);
+	UI_Panel_Set_Padding_Uniform(ui, 4);
+	UI_Panel_Set_Gap(ui, 1);
+
+	for (int r = 0; r < rows; r++) {
+		UI_Begin_Panel_With_Id(ui, next_id++, "grid_row");
+		UI_Panel_Set_Direction(ui, UI_DIRECTION_ROW);
+		UI_Panel_Set_Grow(ui, 1.0f);
+
+		for (int c = 0; c < row_width; c++) {
+			UI_Begin_Panel_With_Id(ui, next_id++, "cell");
+			UI_Panel_Set_Shrink(ui, 0.0f);  // As in Bench_Build_Tree
+			if (c % 8 == 0) {
+				UI_Panel_Set_Size(ui, 1 + (c % 3), -1);
+			} else {
+				UI_Panel_Set_Grow(ui, 0.5f + (float)((c + r) % 3));
+			}
+			UI_End_Panel(ui);
+		}
+
+		UI_End_Panel(ui);
+	}
+
+	UI_End_Panel(ui);
+}
+
+
+// .............................................................................................
+// Count flex containers whose last child does not end at the content edge (the space
+// left after fixed sizes and gaps must be distributed exactly)
+static int
+Bench_Count_Leaks(UI_State *s)
+{
+	int leaks = 0;
+	for (int i = 0; i < s->panel_count; i++) {
+		const UI_Panel *p = &s->panels[i];
+		const UI_Style *ps = &s->styles[i];
+		if (p->first_child == -1 || ps->direction > 1) continue;
+
+		int axis = ps->direction;
+		int content = axis ? p->rect.h - ps->pad_t - ps->pad_b : p->rect.w - ps->pad_l - ps->pad_r;
+		int used = 0, grows = 0;
+		for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling) {
+			int pref = axis ? s->styles[c].pref_h : s->styles[c].pref_w;
+			used += (pref > 0 ? pref : 0) + (c != p->first_child ? ps->gap : 0);
+			if (s->styles[c].flex_grow > 0.0f) grows++;
+		}
+		if (!grows || used >= content) continue;
+
+		const UI_RectI *last = &s->panels[p->last_child].rect;
+		int end = axis ? last->y + last->h : last->x + last->w;
+		int content_end = axis ? p->rect.y + p->rect.h - ps->pad_b : p->rect.x + p->rect.w - ps->pad_r;
+		if (end != content_end) leaks++;
+	}
+	return leaks;
+}
+
+
+// .............................................................................................
+// Copy the SoA tree into the AoS reference layout
+static Bench_AoS_Panel*
+Bench_Make_AoS(UI_State *s)
+{
+	Bench_AoS_Panel *panels = (Bench_AoS_Panel *)calloc(s->panel_count, sizeof(Bench_AoS_Panel));
+	if (!panels) return 0;
+
+	for (int i = 0; i < s->panel_count; i++) {
+		Bench_AoS_Panel *dst = &panels[i];
+		dst->id = s->panels[i].id;
+		dst->style = s->styles[i];
+		dst->parent = s->panels[i].parent;
+		dst->first_child = s->panels[i].first_child;
+		dst->last_child = s->panels[i].last_child;
+		dst->next_sibling = s->panels[i].next_sibling;
+		dst->rect = s->panels[i].rect;
+		dst->label_color = s->cold[i].label_color;
+		dst->label_font_style = s->cold[i].label_font_style;
+		dst->is_label = s->cold[i].is_label;
+		if (s->cold[i].label_text) {
+			strncpy(dst->label_text, s->cold[i].label_text, MAX_UI_TEXT_LENGTH - 1);
+		}
+	}
+
+	return panels;
+}
+
+
+// .............................................................................................
+// Count panels whose rect differs from the AoS reference
+static int
+Bench_Count_Mismatches(UI_State *s, const Bench_AoS_Panel *aos)
+{
+	int mismatches = 0;
+	for (int i = 0; i < s->panel_count; i++) {
+		UI_RectI a = aos[i].rect, b = s->panels[i].rect;
+		if (a.x != b.x || a.y != b.y || a.w != b.w || a.h != b.h) mismatches++;
+	}
+	return mismatches;
+}
+
+
+// .............................................................................................
+int
+main(int argc, char **argv)
+{
+	int panel_count = (argc > 1) ? atoi(argv[1]) : 10000;
+	int iterations = (argc > 2) ? atoi(argv[2]) : 200;
+	int threads = (argc > 3) ? atoi(argv[3]) : Task_Pool_Default_Worker_Count();
+	int row_width = (argc > 4) ? atoi(argv[4]) : 512;
+	if (panel_count < 2) panel_count = 2;
+	if (row_width < 1) row_width = 1;
+	if (iterations < 1) iterations = 1;
+
+	static UI_Context ui;
+	memset(&ui, 0, sizeof(UI_Context));
+
+	UI_Render_List list;
+	memset(&list, 0, sizeof(UI_Render_List));
+	UI_Begin_Frame(&ui, &list, 1920, 1080);
+	Bench_Build_Tree(&ui, panel_count);
+
+	UI_State *s = &ui.state;
+	Bench_AoS_Panel *aos = Bench_Make_AoS(s);
+	if (!aos) {
+		printf("allocation failed\n");
+		return 1;
+	}
+
+	// Warm up both paths once (full layouts: cache disabled)
+	s->layout_cache.disabled = 1;
+	UI_Layout_Panel_Tree(s, 0);
+	Bench_AoS_Layout_Tree(aos, 0);
+
+	double start = Bench_Now_Ms();
+	for (int i = 0; i < iterations; i++) Bench_AoS_Layout_Tree(aos, 0);
+	double aos_ms = (Bench_Now_Ms() - start) / iterations;
+
+	start = Bench_Now_Ms();
+	for (int i = 0; i < iterations; i++) UI_Layout_Panel_Tree(s, 0);
+	double soa_ms = (Bench_Now_Ms() - start) / iterations;
+
+	// Both layouts must agree
+	int mismatches = Bench_Count_Mismatches(s, aos);
+	int serial_laid_out = s->layout_cache.panels_laid_out;
+	
+	// Cached layout of the unchanged tree (first pass fills the cache)
+	s->layout_cache.disabled = 0;
+	UI_Layout_Panel_Tree(s, 0);
+	start = Bench_Now_Ms();
+	for (int i = 0; i < iterations; i++) UI_Layout_Panel_Tree(s, 0);
+	double cached_ms = (Bench_Now_Ms() - start) / iterations;
+	
+	mismatches += Bench_Count_Mismatches(s, aos);
+	int cached_hits = s->layout_cache.subtree_hits;
+	int cached_reused = s->layout_cache.panels_reused;
+	
+	// Parallel full layouts
+	static Task_Pool pool;
+	Task_Pool_Init(&pool, threads);
+	s->layout_cache.disabled = 1;
+	s->layout_pool = &pool;
+	UI_Layout_Panel_Tree(s, 0);
+	start = Bench_Now_Ms();
+	for (int i = 0; i < iterations; i++) UI_Layout_Panel_Tree(s, 0);
+	double parallel_ms = (Bench_Now_Ms() - start) / iterations;
+	
+	// Verify from cleared rects, so every rect must have been written by this pass
+	for (int i = 1; i < s->panel_count; i++) memset(&s->panels[i].rect, 0, sizeof(UI_RectI));
+	UI_Layout_Panel_Tree(s, 0);
+	mismatches += Bench_Count_Mismatches(s, aos);
+	if (s->layout_cache.panels_laid_out != serial_laid_out) mismatches++;
+	int parallel_tasks = s->layout_cache.parallel_tasks;
+	s->layout_pool = NULL;
+
+	printf("panels: %d  iterations: %d\n", s->panel_count, iterations);
+	printf("  AoS layout (%4d B/panel): %8.4f ms\n", (int)sizeof(Bench_AoS_Panel), aos_ms);
+	printf("  SoA layout (%4d B/panel): %8.4f ms  (hot %d + style %d)\n",
+	       (int)(sizeof(UI_Panel) + sizeof(UI_Style) + sizeof(UI_Panel_Cold) + sizeof(UI_Panel_Content)), soa_ms,
+	       (int)sizeof(UI_Panel), (int)sizeof(UI_Style));
+	printf("  Cached layout:            %8.4f ms  (%d subtrees reused, %d rects copied)\n",
+	       cached_ms, cached_hits, cached_reused);
+	printf("  Parallel layout:          %8.4f ms  (%d threads, %d tasks/layout, %ld stolen total)\n",
+	       parallel_ms, pool.worker_count, parallel_tasks, (long)pool.tasks_stolen);
+	printf("  speedup: %.2fx  parallel speedup: %.2fx  mismatches: %d\n",
+	       soa_ms > 0.0 ? aos_ms / soa_ms : 0.0, parallel_ms > 0.0 ? soa_ms / parallel_ms : 0.0,
+	       mismatches);
+
+	Task_Pool_Shutdown(&pool);
+	free(aos);
+	UI_State_Free(s);
+	UI_Render_List_Free(&list);
+
+	// Grid of wide flex rows (same panel budget, serial, full layouts)
+	static UI_Context grid_ui;
+	memset(&grid_ui, 0, sizeof(UI_Context));
+	memset(&list, 0, sizeof(UI_Render_List));
+	UI_Begin_Frame(&grid_ui, &list, 1920, 1080);
+	int grid_rows = panel_count / (row_width + 1);
+	if (grid_rows < 1) grid_rows = 1;
+	Bench_Build_Grid(&grid_ui, grid_rows, row_width);
+
+	s = &grid_ui.state;
+	aos = Bench_Make_AoS(s);
+	if (!aos) {
+		printf("allocation failed\n");
+		return 1;
+	}
+
+	s->layout_cache.disabled = 1;
+	UI_Layout_Panel_Tree(s, 0);
+	Bench_AoS_Layout_Tree(aos, 0);
+
+	start = Bench_Now_Ms();
+	for (int i = 0; i < iterations; i++) Bench_AoS_Layout_Tree(aos, 0);
+	double grid_aos_ms = (Bench_Now_Ms() - start) / iterations;
+
+	start = Bench_Now_Ms();
+	for (int i = 0; i < iterations; i++) UI_Layout_Panel_Tree(s, 0);
+	double grid_soa_ms = (Bench_Now_Ms() - start) / iterations;
+
+	int grid_mismatches = Bench_Count_Mismatches(s, aos);
+	int grid_leaks = Bench_Count_Leaks(s);
+
+	printf("grid: %d rows x %d cells  kernel: %s\n", grid_rows, row_width, UI_LAYOUT_KERNEL_NAME);
+	printf("  AoS layout:               %8.4f ms\n", grid_aos_ms);
+	printf("  SoA layout:               %8.4f ms  (%.2fx)\n", grid_soa_ms,
+	       grid_soa_ms > 0.0 ? grid_aos_ms / grid_soa_ms : 0.0);
+	printf("  mismatches: %d  inexact containers: %d\n", grid_mismatches, grid_leaks);
+
+	free(aos);
+	UI_State_Free(s);
+	UI_Render_List_Free(&list);
+	mismatches += grid_mismatches + grid_leaks;
+	return mismatches ? 1 : 0;
+}
@@ -4,7 +4,7 @@ pushd %~dp0
 if not exist build mkdir build
 pushd build
 
-cl /Zi /Od /W4 ..\application.cpp d2d1.lib dwrite.lib user32.lib
+cl /Zi /Od /W4 ..\application.cpp d2d1.lib dwrite.lib user32.lib dwmapi.lib d3d11.lib dxgi.lib
 
 popd
 popd
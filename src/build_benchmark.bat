@@ -0,0 +1,10 @@
+@echo off
+pushd %~dp0
+
+if not exist build mkdir build
+pushd build
+
+cl /Zi /O2 /W4 ..\benchmark.cpp
+
+popd
+popd
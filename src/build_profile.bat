@@ -15,7 +15,7 @@ REM ws2_32.lib - Winsock library (Tracy networking)
 cl /O2 /Zi /W4 /DTRACY_ENABLE /DTRACY_NO_SYSTEM_TRACING /I..\..\tracy\public ^
    ..\application.cpp ^
    ..\..\tracy\public\TracyClient.cpp ^
-   d2d1.lib dwrite.lib user32.lib ws2_32.lib
+   d2d1.lib dwrite.lib user32.lib dwmapi.lib d3d11.lib dxgi.lib ws2_32.lib
 
 popd
 popd
@@ -0,0 +1,414 @@
+// frame_benchmark.cpp - Headless per-phase frame benchmark (console, no window, no D2D)
+//
+// Runs full UI frames over synthetic trees with a stub text measure function and
+// reports, per scenario, the average cost of each phase:
+//   - build:       UI_Begin_Frame_With_Time + panel tree construction
+//   - layout:      UI_Layout_Panel_Tree (layout cache enabled, as in the application)
+//   - interaction: UI_Update_Interaction (mouse sweeps the window, periodic drags)
+//   - emit:        UI_Emit_Panels
+// plus heap and memset traffic per frame, counted through the UI_MALLOC/UI_CALLOC/
+// UI_REALLOC/UI_MEMSET hooks in ui.cpp.
+//
+// Output is one JSON object per line (one per scenario), stable field names, so runs of
+// different versions can be diffed or loaded by a script:
+//   {"format":1,"scenario":"labels","frames":500,"panels":2201,...,"build_ns":...}
+//
+// Usage: frame_benchmark.exe [frames] [scale] [scenario | snapshot file]
+//   (defaults: 500 frames, scale 1, all scenarios: deep, wide, labels, dividers)
+// A snapshot file (ui_snapshot.bin saved by the application on exit, see UI_Snapshot_Write)
+// replays that frame: its panels are loaded as the build phase of every frame, at the
+// window size it was saved with, and reported as scenario "snapshot" (scale is ignored).
+//
+#include <windows.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Allocation / clearing counters (measured frames only)
+static int64_t g_bench_alloc_calls;
+static int64_t g_bench_alloc_bytes;
+static int64_t g_bench_memset_bytes;
+
+
+// .............................................................................................
+static void*
+Bench_Malloc(size_t size)
+{
+	g_bench_alloc_calls++;
+	g_bench_alloc_bytes += (int64_t)size;
+	return malloc(size);
+}
+
+
+// .............................................................................................
+static void*
+Bench_Calloc(size_t count, size_t size)
+{
+	g_bench_alloc_calls++;
+	g_bench_alloc_bytes += (int64_t)(count * size);
+	g_bench_memset_bytes += (int64_t)(count * size);
+	return calloc(count, size);
+}
+
+
+// .............................................................................................
+// Counts the full new size (realloc may move every byte)
+static void*
+Bench_Realloc(void *ptr, size_t size)
+{
+	g_bench_alloc_calls++;
+	g_bench_alloc_bytes += (int64_t)size;
+	return realloc(ptr, size);
+}
+
+
+// .............................................................................................
+static void*
+Bench_Memset(void *dst, int value, size_t size)
+{
+	g_bench_memset_bytes += (int64_t)size;
+	return memset(dst, value, size);
+}
+
+#define UI_MALLOC(size) Bench_Malloc(size)
+#define UI_CALLOC(count, size) Bench_Calloc(count, size)
+#define UI_REALLOC(ptr, size) Bench_Realloc(ptr, size)
+#define UI_MEMSET(dst, value, size) Bench_Memset(dst, value, size)
+#include "ui.cpp"
+#include "task_pool.cpp"
+
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_WARMUP_FRAMES 20
+
+typedef void Bench_Build_Func(UI_Context *ui, int scale);
+
+struct Bench_Scenario {
+	const char *name;
+	Bench_Build_Func *build;
+	int width, height;     // 0 = BENCH_WIDTH x BENCH_HEIGHT
+};
+
+// Snapshot replayed by the "snapshot" scenario
+static void *g_bench_snapshot;
+static int g_bench_snapshot_size;
+
+// Per-phase totals over the measured frames
+struct Bench_Result {
+	int64_t build_ticks;
+	int64_t layout_ticks;
+	int64_t interaction_ticks;
+	int64_t emit_ticks;
+	int64_t alloc_calls;
+	int64_t alloc_bytes;
+	int64_t memset_bytes;
+	size_t memory_bytes;      // UI_Memory_Stats total after the last frame
+	size_t memory_peak_bytes;
+	size_t render_list_bytes;
+	int panels;
+	int rectangles;
+	int texts;
+};
+
+
+// .............................................................................................
+// Fixed-width stub: 7px per character, line height from the font size
+static UI_RectI
+Bench_Measure_Text(const char *text, int font_size, int /*font_style*/)
+{
+	UI_RectI r = { 0, 0, 0, 0 };
+	r.w = 7 * (int)strlen(text);
+	r.h = font_size + 4;
+	return r;
+}
+
+
+// .............................................................................................
+static int64_t
+Bench_Ticks()
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return now.QuadPart;
+}
+
+
+// .............................................................................................
+// deep: 64*scale chains nested 24 levels, a label at the bottom of each
+static void
+Bench_Build_Deep(UI_Context *ui, int scale)
+{
+	UI_Begin_Panel(ui, "root");
+	UI_Panel_Set_Direction(ui, UI_DIRECTION_ROW);
+	UI_Panel_Set_Gap(ui, 1);
+
+	for (int chain = 0; chain < 64 * scale; chain++) {
+		UI_Push_Id_Int(ui, chain);
+		for (int depth = 0; depth < 24; depth++) {
+			UI_Begin_Panel(ui, "level");
+			UI_Panel_Set_Direction(ui, (depth & 1) ? UI_DIRECTION_ROW : UI_DIRECTION_COLUMN);
+			UI_Panel_Set_Grow(ui, 1.0f);
+			UI_Panel_Set_Padding_Uniform(ui, 1);
+			UI_Panel_Set_Color(ui, 0xFF202020 + (uint32_t)depth);
+		}
+		UI_Label(ui, "leaf", 0xFFFFFFFF);
+		for (int depth = 0; depth < 24; depth++) UI_End_Panel(ui);
+		UI_Pop_Id(ui);
+	}
+
+	UI_End_Panel(ui);
+}
+
+
+// .............................................................................................
+// wide: one column of 4000*scale flat siblings (most end up below the window)
+static void
+Bench_Build_Wide(UI_Context *ui, int scale)
+{
+	UI_Begin_Panel(ui, "root");
+	UI_Panel_Set_Direction(ui, UI_DIRECTION_COLUMN);
+
+	for (int i = 0; i < 4000 * scale; i++) {
+		UI_Begin_Panel(ui, "item");
+		UI_Panel_Set_Size(ui, -1, 2);
+		UI_Panel_Set_Shrink(ui, 0.0f);  // Overflow the window instead of being squashed to fit
+		UI_Panel_Set_Color(ui, (i & 1) ? 0xFF303030 : 0xFF383838);
+		UI_End_Panel(ui);
+	}
+
+	UI_End_Panel(ui);
+}
+
+
+// .............................................................................................
+// labels: 200*scale rows of 10 labels
+static void
+Bench_Build_Labels(UI_Context *ui, int scale)
+{
+	static const char *words[10] = { "alpha", "beta", "gamma", "delta", "epsilon",
+	                                  "zeta", "eta", "theta", "iota", "kappa" };
+
+	UI_Begin_Panel(ui, "root");
+	UI_Panel_Set_Direction(ui, UI_DIRECTION_COLUMN);
+	UI_Panel_Set_Padding_Uniform(ui, 4);
+
+	for (int row = 0; row < 200 * scale; row++) {
+		UI_Push_Id_Int(ui, row);
+		UI_Begin_Panel(ui, "row");
+		UI_Panel_Set_Direction(ui, UI_DIRECTION_ROW);
+		UI_Panel_Set_Size(ui, -1, 18);
+		UI_Panel_Set_Gap(ui, 6);
+		for (int c = 0; c < 10; c++) {
+			UI_Label(ui, words[(row + c) % 10], 0xFFE0E0E0);
+		}
+		UI_End_Panel(ui);
+		UI_Pop_Id(ui);
+	}
+
+	UI_End_Panel(ui);
+}
+
+
+// .............................................................................................
+// dividers: 16*scale resizable columns, each split into 16 resizable rows by dividers
+static void
+Bench_Build_Dividers(UI_Context *ui, int scale)
+{
+	UI_Begin_Panel(ui, "root");
+	UI_Panel_Set_Direction(ui, UI_DIRECTION_ROW);
+
+	int columns = 16 * scale;
+	for (int col = 0; col < columns; col++) {
+		UI_Push_Id_Int(ui, col);
+		UI_Panel_Resizable(ui, "column", UI_DIRECTION_COLUMN, BENCH_WIDTH / columns - 1, -2, 1, 0, 0xFF252525);
+		UI_Panel_Set_Shrink(ui, 0.0f);  // Drags past the window push columns off it (as before shrink existed)
+		for (int row = 0; row < 16; row++) {
+			UI_Panel_Resizable(ui, "cell", UI_DIRECTION_COLUMN, -2, BENCH_HEIGHT / 16 - 1, 1, 0, 0xFF2A2A2A);
+			UI_Panel_Set_Shrink(ui, 0.0f);
+			UI_End_Panel(ui);
+			if (row < 15) UI_Divider(ui, "hdiv", UI_DIVIDER_HORIZONTAL);
+		}
+		UI_End_Panel(ui);
+		UI_Pop_Id(ui);
+		if (col < columns - 1) UI_Divider(ui, "vdiv", UI_DIVIDER_VERTICAL);
+	}
+
+	UI_End_Panel(ui);
+}
+
+
+// .............................................................................................
+// snapshot: the panels of a saved application frame (no widget calls, no text measuring)
+static void
+Bench_Build_Snapshot(UI_Context *ui, int /*scale*/)
+{
+	UI_Snapshot_Load_Panels(ui, g_bench_snapshot, g_bench_snapshot_size);
+}
+
+
+// .............................................................................................
+// Read a snapshot file; 0 if it cannot be read or is not a snapshot of this build
+static int
+Bench_Read_Snapshot(const char *path, Bench_Scenario *out)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f) return 0;
+	
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	void *data = (size > 0) ? malloc(size) : 0;
+	int ok = data && fread(data, 1, size, f) == (size_t)size && UI_Snapshot_Validate(data, (int)size);
+	fclose(f);
+	if (!ok) {
+		free(data);
+		return 0;
+	}
+	
+	UI_Snapshot_Header header;
+	memcpy(&header, data, sizeof(header));
+	g_bench_snapshot = data;
+	g_bench_snapshot_size = (int)size;
+	out->name = "snapshot";
+	out->build = Bench_Build_Snapshot;
+	out->width = header.screen_w;
+	out->height = header.screen_h;
+	return 1;
+}
+
+
+// .............................................................................................
+// Run warmup + measured frames of one scenario on a fresh context
+static void
+Bench_Run(const Bench_Scenario *scenario, int frames, int scale, Bench_Result *out)
+{
+	static UI_Context ui;
+	memset(&ui, 0, sizeof(UI_Context));
+	ui.measure_text = Bench_Measure_Text;
+	int width = scenario->width > 0 ? scenario->width : BENCH_WIDTH;
+	int height = scenario->height > 0 ? scenario->height : BENCH_HEIGHT;
+
+	UI_Render_List list;
+	memset(&list, 0, sizeof(UI_Render_List));
+	memset(out, 0, sizeof(Bench_Result));
+
+	for (int frame = 0; frame < BENCH_WARMUP_FRAMES + frames; frame++) {
+		if (frame == BENCH_WARMUP_FRAMES) {
+			g_bench_alloc_calls = 0;
+			g_bench_alloc_bytes = 0;
+			g_bench_memset_bytes = 0;
+		}
+
+		// Mouse sweeps the window; the left button is held for 10 of every 60 frames
+		UI_Input_ProcessMouseMove(&ui, (frame * 37) % width, (frame * 23) % height);
+		UI_Input_ProcessMouseButton(&ui, UI_MOUSE_LEFT, (frame % 60) >= 50);
+
+		int64_t t0 = Bench_Ticks();
+		UI_Begin_Frame_With_Time(&ui, &list, width, height, 16.6f);
+		scenario->build(&ui, scale);
+		int64_t t1 = Bench_Ticks();
+		if (ui.state.panel_count > 0) UI_Layout_Panel_Tree(&ui.state, 0);
+		int64_t t2 = Bench_Ticks();
+		UI_Update_Interaction(&ui);
+		int64_t t3 = Bench_Ticks();
+		if (ui.state.panel_count > 0) UI_Emit_Panels(&ui.state, 0);
+		int64_t t4 = Bench_Ticks();
+		UI_Input_EndFrame(&ui);
+
+		if (frame >= BENCH_WARMUP_FRAMES) {
+			out->build_ticks += t1 - t0;
+			out->layout_ticks += t2 - t1;
+			out->interaction_ticks += t3 - t2;
+			out->emit_ticks += t4 - t3;
+		}
+	}
+
+	out->alloc_calls = g_bench_alloc_calls;
+	out->alloc_bytes = g_bench_alloc_bytes;
+	out->memset_bytes = g_bench_memset_bytes;
+	UI_Memory_Stats memory;
+	UI_Memory_Stats_Get(&ui, &memory);
+	out->memory_bytes = memory.total;
+	out->memory_peak_bytes = memory.total_peak;
+	out->render_list_bytes = UI_Render_List_Bytes(&list);
+	out->panels = ui.state.panel_count;
+	out->rectangles = list.rect_count;
+	out->texts = list.text_count;
+
+	UI_Context_Free(&ui);
+	UI_Render_List_Free(&list);
+}
+
+
+// .............................................................................................
+int
+main(int argc, char **argv)
+{
+	int frames = (argc > 1) ? atoi(argv[1]) : 500;
+	int scale = (argc > 2) ? atoi(argv[2]) : 1;
+	const char *only = (argc > 3) ? argv[3] : 0;
+	if (frames < 1) frames = 1;
+	if (scale < 1) scale = 1;
+
+	static const Bench_Scenario scenarios[] = {
+		{ "deep",     Bench_Build_Deep },
+		{ "wide",     Bench_Build_Wide },
+		{ "labels",   Bench_Build_Labels },
+		{ "dividers", Bench_Build_Dividers },
+	};
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	double ns_per_tick = 1e9 / (double)frequency.QuadPart;
+
+	// An argument that names no scenario is tried as a snapshot file
+	int scenario_count = (int)(sizeof(scenarios) / sizeof(scenarios[0]));
+	const Bench_Scenario *run = scenarios;
+	Bench_Scenario replay;
+	memset(&replay, 0, sizeof(Bench_Scenario));
+	if (only) {
+		int known = 0;
+		for (int i = 0; i < scenario_count; i++) known |= strcmp(only, scenarios[i].name) == 0;
+		if (!known && Bench_Read_Snapshot(only, &replay)) {
+			run = &replay;
+			scenario_count = 1;
+			only = 0;
+		}
+	}
+
+	int ran = 0;
+	for (int i = 0; i < scenario_count; i++) {
+		if (only && strcmp(only, run[i].name) != 0) continue;
+
+		Bench_Result r;
+		Bench_Run(&run[i], frames, scale, &r);
+		ran++;
+
+		double f = (double)frames;
+		double build_ns = r.build_ticks * ns_per_tick / f;
+		double layout_ns = r.layout_ticks * ns_per_tick / f;
+		double interaction_ns = r.interaction_ticks * ns_per_tick / f;
+		double emit_ns = r.emit_ticks * ns_per_tick / f;
+
+		printf("{\"format\":1,\"scenario\":\"%s\",\"frames\":%d,\"scale\":%d,"
+		       "\"panels\":%d,\"rectangles\":%d,\"texts\":%d,"
+		       "\"build_ns\":%.0f,\"layout_ns\":%.0f,\"interaction_ns\":%.0f,\"emit_ns\":%.0f,\"total_ns\":%.0f,"
+		       "\"alloc_calls_per_frame\":%.2f,\"alloc_bytes_per_frame\":%.0f,\"memset_bytes_per_frame\":%.0f,"
+		       "\"memory_bytes\":%zu,\"memory_peak_bytes\":%zu,\"render_list_bytes\":%zu}\n",
+		       run[i].name, frames, scale,
+		       r.panels, r.rectangles, r.texts,
+		       build_ns, layout_ns, interaction_ns, emit_ns,
+		       build_ns + layout_ns + interaction_ns + emit_ns,
+		       r.alloc_calls / f, r.alloc_bytes / f, r.memset_bytes / f,
+		       r.memory_bytes, r.memory_peak_bytes, r.render_list_bytes);
+	}
+
+	if (!ran) {
+		fprintf(stderr, "unknown scenario: %s (expected deep, wide, labels, dividers or a snapshot file)\n", only);
+		return 1;
+	}
+	return 0;
+}
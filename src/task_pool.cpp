@@ -0,0 +1,255 @@
+// task_pool.cpp - Work-stealing task pool (Win32 implementation of task_pool.h)
+//
+// Unity build: included after ui.cpp by application.cpp and benchmark.cpp.
+//
+#include "task_pool.h"
+#include <windows.h>
+#include <string.h>
+
+#define TASK_POOL_IDLE_SPINS 2048   // Failed steal rounds before a worker sleeps
+
+
+// Deque of the calling thread (0 = the thread outside the pool that spawns and waits)
+static __declspec(thread) int g_task_worker_index;
+
+
+// .............................................................................................
+static void
+Task_Deque_Lock(Task_Deque *d)
+{
+	while (InterlockedCompareExchange(&d->lock, 1, 0) != 0) {
+		YieldProcessor();
+	}
+}
+
+
+// .............................................................................................
+static void
+Task_Deque_Unlock(Task_Deque *d)
+{
+	InterlockedExchange(&d->lock, 0);
+}
+
+
+// .............................................................................................
+static int
+Task_Deque_Push(Task_Deque *d, const Task *task)
+{
+	Task_Deque_Lock(d);
+	int pushed = (d->bottom - d->top) < TASK_POOL_DEQUE_CAPACITY;
+	if (pushed) {
+		d->tasks[d->bottom & (TASK_POOL_DEQUE_CAPACITY - 1)] = *task;
+		d->bottom++;
+	}
+	Task_Deque_Unlock(d);
+	return pushed;
+}
+
+
+// .............................................................................................
+// Owner end: newest task first
+static int
+Task_Deque_Pop(Task_Deque *d, Task *out)
+{
+	Task_Deque_Lock(d);
+	int popped = d->bottom > d->top;
+	if (popped) {
+		d->bottom--;
+		*out = d->tasks[d->bottom & (TASK_POOL_DEQUE_CAPACITY - 1)];
+	}
+	Task_Deque_Unlock(d);
+	return popped;
+}
+
+
+// .............................................................................................
+// Thief end: oldest task first (closest to the root, so the largest piece of work)
+static int
+Task_Deque_Steal(Task_Deque *d, Task *out)
+{
+	Task_Deque_Lock(d);
+	int stolen = d->bottom > d->top;
+	if (stolen) {
+		*out = d->tasks[d->top & (TASK_POOL_DEQUE_CAPACITY - 1)];
+		d->top++;
+	}
+	Task_Deque_Unlock(d);
+	return stolen;
+}
+
+
+// .............................................................................................
+// Own deque first, then steal round-robin starting after our own index
+static int
+Task_Pool_Find_Work(Task_Pool *pool, int worker, Task *out)
+{
+	if (Task_Deque_Pop(&pool->deques[worker], out)) return 1;
+
+	for (int k = 1; k < pool->worker_count; k++) {
+		int victim = (worker + k) % pool->worker_count;
+		if (Task_Deque_Steal(&pool->deques[victim], out)) {
+			InterlockedIncrement(&pool->tasks_stolen);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+// .............................................................................................
+static void
+Task_Pool_Run(Task_Pool *pool, const Task *task)
+{
+	task->func(task->arg);
+	InterlockedIncrement(&pool->tasks_run);
+	InterlockedDecrement(&task->group->pending);  // Full barrier: results visible to the waiter
+}
+
+
+// .............................................................................................
+static DWORD WINAPI
+Task_Pool_Worker(LPVOID param)
+{
+	Task_Pool *pool = (Task_Pool *)param;
+	int worker = (int)InterlockedIncrement(&pool->next_worker);  // 1..worker_count-1
+	g_task_worker_index = worker;
+	int idle_spins = 0;
+
+	while (!pool->quit) {
+		Task task;
+		if (Task_Pool_Find_Work(pool, worker, &task)) {
+			Task_Pool_Run(pool, &task);
+			idle_spins = 0;
+			continue;
+		}
+
+		if (++idle_spins < TASK_POOL_IDLE_SPINS) {
+			YieldProcessor();
+			continue;
+		}
+
+		// Announce sleep, then look once more: a spawn either sees the sleeper count
+		// and releases the semaphore, or its task is found here (no lost wakeup)
+		InterlockedIncrement(&pool->sleepers);
+		if (Task_Pool_Find_Work(pool, worker, &task)) {
+			InterlockedDecrement(&pool->sleepers);
+			Task_Pool_Run(pool, &task);
+		} else {
+			WaitForSingleObject(pool->wake_semaphore, INFINITE);
+			InterlockedDecrement(&pool->sleepers);
+		}
+		idle_spins = 0;
+	}
+
+	return 0;
+}
+
+
+// .............................................................................................
+int
+Task_Pool_Default_Worker_Count()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	int count = (int)info.dwNumberOfProcessors;
+	if (count < 1) count = 1;
+	if (count > TASK_POOL_MAX_WORKERS) count = TASK_POOL_MAX_WORKERS;
+	return count;
+}
+
+
+// .............................................................................................
+// Task_Pool_Init - Start worker_count - 1 threads (the caller is worker 0)
+// Returns 0 if no thread could be started; the pool then runs every task inline.
+int
+Task_Pool_Init(Task_Pool *pool, int worker_count)
+{
+	memset(pool, 0, sizeof(Task_Pool));
+	pool->worker_count = 1;
+
+	if (worker_count > TASK_POOL_MAX_WORKERS) worker_count = TASK_POOL_MAX_WORKERS;
+	if (worker_count <= 1) return 1;
+
+	pool->wake_semaphore = CreateSemaphoreW(NULL, 0, 0x7FFFFFFF, NULL);
+	if (!pool->wake_semaphore) return 0;
+
+	// Deques of threads that fail to start stay empty, stealing from them is harmless
+	pool->worker_count = worker_count;
+	int started = 0;
+	for (int i = 1; i < worker_count; i++) {
+		pool->threads[i] = CreateThread(NULL, 0, Task_Pool_Worker, pool, 0, NULL);
+		if (pool->threads[i]) started++;
+	}
+
+	if (started == 0) {
+		CloseHandle(pool->wake_semaphore);
+		pool->wake_semaphore = NULL;
+		pool->worker_count = 1;
+		return 0;
+	}
+	return 1;
+}
+
+
+// .............................................................................................
+void
+Task_Pool_Shutdown(Task_Pool *pool)
+{
+	InterlockedExchange(&pool->quit, 1);
+	if (pool->wake_semaphore) {
+		ReleaseSemaphore(pool->wake_semaphore, pool->worker_count, NULL);
+	}
+
+	for (int i = 1; i < pool->worker_count; i++) {
+		if (pool->threads[i]) {
+			WaitForSingleObject(pool->threads[i], INFINITE);
+			CloseHandle(pool->threads[i]);
+		}
+	}
+
+	if (pool->wake_semaphore) CloseHandle(pool->wake_semaphore);
+	memset(pool, 0, sizeof(Task_Pool));
+	pool->worker_count = 1;
+}
+
+
+// .............................................................................................
+// Task_Pool_Spawn - Queue func(arg) on the caller's deque, counted in group
+// Runs inline on a serial pool or when the deque is full.
+void
+Task_Pool_Spawn(Task_Pool *pool, Task_Group *group, Task_Func *func, void *arg)
+{
+	if (pool->worker_count <= 1) {
+		func(arg);
+		return;
+	}
+
+	Task task = { func, arg, group };
+	InterlockedIncrement(&group->pending);
+	if (!Task_Deque_Push(&pool->deques[g_task_worker_index], &task)) {
+		Task_Pool_Run(pool, &task);
+		return;
+	}
+
+	if (pool->sleepers > 0) ReleaseSemaphore(pool->wake_semaphore, 1, NULL);
+}
+
+
+// .............................................................................................
+// Task_Pool_Wait - Run queued tasks (own first, then stolen) until group is finished
+void
+Task_Pool_Wait(Task_Pool *pool, Task_Group *group)
+{
+	int worker = g_task_worker_index;
+
+	while (group->pending > 0) {
+		Task task;
+		if (Task_Pool_Find_Work(pool, worker, &task)) {
+			Task_Pool_Run(pool, &task);
+		} else {
+			YieldProcessor();
+		}
+	}
+	MemoryBarrier();
+}
@@ -0,0 +1,66 @@
+// task_pool.h - Small work-stealing task pool (fork/join)
+//
+// One deque per thread: the owner pushes and pops at the bottom (LIFO, cache-warm),
+// idle threads steal from the top of other deques (FIFO, oldest = largest work).
+// Threads outside the pool use deque 0 and only run tasks while they wait in
+// Task_Pool_Wait; worker threads 1..worker_count-1 run tasks whenever any exist.
+// Waiting threads help (pop/steal) instead of blocking, so tasks may spawn and wait on
+// their own sub-tasks without deadlock.
+//
+// USAGE:
+//   Task_Group group = {0};
+//   Task_Pool_Spawn(&pool, &group, Work, &args[0]);
+//   Task_Pool_Spawn(&pool, &group, Work, &args[1]);
+//   Work(&args[2]);                       // Caller does its share
+//   Task_Pool_Wait(&pool, &group);        // Returns when both spawned tasks finished
+//
+// Only one thread outside the pool at a time may spawn and wait (it owns deque 0).
+// The interface is platform-neutral; task_pool.cpp implements it with Win32 threads.
+//
+#pragma once
+
+#define TASK_POOL_MAX_WORKERS 16
+#define TASK_POOL_DEQUE_CAPACITY 256   // Power of two; Spawn runs the task inline when full
+
+typedef void Task_Func(void *arg);
+
+// Counter of unfinished tasks spawned into this group
+struct Task_Group {
+	volatile long pending;
+};
+
+struct Task {
+	Task_Func *func;
+	void *arg;
+	Task_Group *group;
+};
+
+// Spin-locked ring: bottom = owner end, top = steal end
+struct Task_Deque {
+	volatile long lock;
+	int top;
+	int bottom;
+	Task tasks[TASK_POOL_DEQUE_CAPACITY];
+};
+
+struct Task_Pool {
+	int worker_count;                   // Including worker 0 (the spawning thread)
+	void *threads[TASK_POOL_MAX_WORKERS];
+	Task_Deque deques[TASK_POOL_MAX_WORKERS];
+	void *wake_semaphore;               // Released per spawn while workers sleep
+	volatile long sleepers;
+	volatile long next_worker;          // Deque index handed to each started thread
+	volatile long quit;
+
+	// Statistics (since init)
+	volatile long tasks_run;
+	volatile long tasks_stolen;
+};
+
+// worker_count <= 1 (or failure to start threads) leaves a serial pool: Spawn runs inline
+int Task_Pool_Init(Task_Pool *pool, int worker_count);
+void Task_Pool_Shutdown(Task_Pool *pool);
+int Task_Pool_Default_Worker_Count();
+
+void Task_Pool_Spawn(Task_Pool *pool, Task_Group *group, Task_Func *func, void *arg);
+void Task_Pool_Wait(Task_Pool *pool, Task_Group *group);
@@ -4,19 +4,44 @@
 // 1. Panel Tree Construction: Immediate-mode API builds tree each frame
 // 2. Layout Calculation: Flexbox-inspired two-pass algorithm
 //    - Pass 1: Calculate fixed sizes and sum flex-grow factors
-//    - Pass 2: Distribute remaining space proportionally to flex-grow
+//    - Pass 2: Distribute remaining space exactly (integer edges) by flex-grow
 // 3. Render List Generation: Walk tree and emit rectangle/text primitives
-// 4. Input Processing: Mouse/keyboard state management and edge detection
+// 4. Input Processing: Queued events drained per frame, mouse/keyboard state and edge detection
 // 5. Interaction System: Hot/active widget tracking with resizable divider support
 //
 // PERFORMANCE NOTES:
-// - Panel lookup is O(n) linear search (acceptable for <100 panels, optimize if needed)
-// - Size override lookup is O(n) linear search (max 32 overrides)
-// - ID deduplication is O(n) per widget (could use hash map if needed)
+// - Panel lookup by ID is O(1) (per-frame index built in UI_New_Panel)
+// - Size override lookup is O(1) (persistent open-addressing table, no cap)
+// - ID deduplication is O(1) per widget (generation-cleared open-addressing table)
 //
 #include "ui.h"
+#include "task_pool.h"
 #include <string.h>
+#include <stdlib.h>
 #include <assert.h>
+#include <stddef.h>
+#include <atomic>
+
+// Heap and clearing hooks (defaults: C runtime). Define before including ui.cpp to
+// count or redirect them, as frame_benchmark.cpp does.
+#ifndef UI_MALLOC
+#define UI_MALLOC(size) malloc(size)
+#endif
+#ifndef UI_CALLOC
+#define UI_CALLOC(count, size) calloc(count, size)
+#endif
+#ifndef UI_REALLOC
+#define UI_REALLOC(ptr, size) realloc(ptr, size)
+#endif
+#ifndef UI_FREE
+#define UI_FREE(ptr) free(ptr)
+#endif
+#ifndef UI_MEMSET
+#define UI_MEMSET(dst, value, size) memset(dst, value, size)
+#endif
+#ifndef UI_MEMORY_BARRIER
+#define UI_MEMORY_BARRIER() std::atomic_thread_fence(std::memory_order_seq_cst)
+#endif
 
 
 // internal per-frame pointer (not visible outside UI)
@@ -24,20 +49,71 @@ static UI_Render_List *g_render_list;
 
 
 // .............................................................................................
-// UI_HashString - Hash a string to a 32-bit ID using djb2 algorithm
-// djb2 is chosen for its simplicity, speed, and good distribution for short strings
-// Returns 0 for NULL input (used as sentinel "no ID" value)
+// UI_Hash_String_Seeded - djb2 continued from seed (5381 = plain djb2)
+// ID scopes pass the enclosing scope's ID as seed, so "Save" inside two scopes differs.
+// Unsigned bytes and arithmetic, so UI_Hash_Const produces the same IDs at compile time.
 static UI_Id
-UI_HashString(const char *str)
+UI_Hash_String_Seeded(UI_Id seed, const char *str)
 {
 	if (!str) return 0;
 	
-	UI_Id hash = 5381;
-	int c;
-	while ((c = *str++))
+	uint32_t hash = (uint32_t)seed;
+	uint32_t c;
+	while ((c = (unsigned char)*str++))
 		hash = ((hash << 5) + hash) + c;  // hash * 33 + c
 	
-	return hash;
+	return (UI_Id)hash;
+}
+
+
+// .............................................................................................
+// UI_HashString - Hash a string to a 32-bit ID using djb2 algorithm
+// djb2 is chosen for its simplicity, speed, and good distribution for short strings
+// Returns 0 for NULL input (used as sentinel "no ID" value)
+// Only the application calls it now, so inline keeps the benchmark builds free of C4505
+static inline UI_Id
+UI_HashString(const char *str)
+{
+	return UI_Hash_String_Seeded(5381, str);
+}
+
+
+// .............................................................................................
+// UI_Hash_Bytes - FNV-1a over a byte range, chained through h
+static uint32_t
+UI_Hash_Bytes(uint32_t h, const void *data, int size)
+{
+	const unsigned char *bytes = (const unsigned char *)data;
+	for (int i = 0; i < size; i++) {
+		h ^= bytes[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+
+// .............................................................................................
+// UI_Id_Mix - Derive a new ID from a base ID and a small integer (murmur3 finalizer)
+// Used for duplicate labels and integer ID scopes; never returns 0 ("no ID").
+static UI_Id
+UI_Id_Mix(UI_Id base, int n)
+{
+	uint32_t h = (uint32_t)base ^ ((uint32_t)n * 0x9E3779B9u);
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return h ? (UI_Id)h : 1;
+}
+
+
+// .............................................................................................
+// Current ID seed: innermost scope, or plain djb2 seed at the root
+static UI_Id
+UI_Id_Seed(UI_Context *ctx)
+{
+	return ctx->id_scope_count > 0 ? ctx->id_scope_stack[ctx->id_scope_count - 1] : 5381;
 }
 
 
@@ -46,46 +122,313 @@ UI_HashString(const char *str)
 // 
 // In immediate-mode, multiple widgets with the same label (e.g., "Save") need unique IDs.
 // First occurrence: "Save" -> hash("Save")
-// Second occurrence: "Save" -> hash("Save##0")
-// Third occurrence: "Save" -> hash("Save##1"), etc.
+// Second occurrence: "Save" -> mix(hash("Save"), 1)
+// Third occurrence: "Save" -> mix(hash("Save"), 2), etc.
 // 
+// Seen IDs live in an open-addressing table with linear probing. Slots from earlier
+// frames are ignored by generation, so clearing the table is a counter increment.
+// When the table is at its load limit, further new IDs are not tracked (not deduplicated).
+//
 // This allows natural API: UI_Button(ui, "Save") without manual ID management
+#ifdef UI_COMPACT_CONTEXT
+// Compact contexts start with a small heap table and double it (rehashing this frame's
+// IDs) whenever it is half full, up to UI_ID_TABLE_SIZE
+static int
+UI_Id_Table_Grow(UI_Context *ctx)
+{
+	if (ctx->id_table_capacity >= UI_ID_TABLE_SIZE) return 1;
+	
+	int capacity = ctx->id_table_capacity ? ctx->id_table_capacity * 2 : UI_ID_TABLE_INITIAL;
+	UI_Id_Slot *table = (UI_Id_Slot *)UI_CALLOC(capacity, sizeof(UI_Id_Slot));
+	if (!table) return 0;
+	
+	uint32_t mask = (uint32_t)capacity - 1;
+	for (int i = 0; i < ctx->id_table_capacity; i++) {
+		const UI_Id_Slot *entry = &ctx->id_table[i];
+		if (entry->generation != ctx->id_generation) continue;
+		uint32_t slot = UI_Id_Mix(entry->id, 0) & mask;
+		while (table[slot].generation == ctx->id_generation) slot = (slot + 1) & mask;
+		table[slot] = *entry;
+	}
+	
+	UI_FREE(ctx->id_table);
+	ctx->id_table = table;
+	ctx->id_table_capacity = capacity;
+	return 1;
+}
+#endif
+
+static UI_Id
+UI_Claim_Id(UI_Context *ctx, UI_Id base_id)
+{
+#ifdef UI_COMPACT_CONTEXT
+	if (ctx->used_id_count * 2 >= ctx->id_table_capacity) UI_Id_Table_Grow(ctx);
+	if (!ctx->id_table) return base_id;
+	int capacity = ctx->id_table_capacity;
+#else
+	int capacity = UI_ID_TABLE_SIZE;
+#endif
+	uint32_t mask = (uint32_t)capacity - 1;
+	uint32_t slot = UI_Id_Mix(base_id, 0) & mask;
+	
+	for (int probe = 0; probe < capacity; probe++) {
+		UI_Id_Slot *entry = &ctx->id_table[slot];
+		
+		if (entry->generation != ctx->id_generation) {
+			// Empty slot - first use, track it
+			if (ctx->used_id_count >= UI_MAX_USED_IDS) return base_id;
+			entry->id = base_id;
+			entry->count = 0;
+			entry->generation = ctx->id_generation;
+			ctx->used_id_count++;
+			return base_id;
+		}
+		
+		if (entry->id == base_id) {
+			// Found duplicate - derive a unique ID from the occurrence count
+			return UI_Id_Mix(base_id, ++entry->count);
+		}
+		
+		slot = (slot + 1) & mask;
+	}
+	
+	return base_id;
+}
+
+
+// .............................................................................................
 static UI_Id
 UI_Generate_Id(UI_Context *ctx, const char *str)
 {
-	UI_Id base_id = UI_HashString(str);
+	return UI_Claim_Id(ctx, UI_Hash_String_Seeded(UI_Id_Seed(ctx), str));
+}
+
+
+// .............................................................................................
+void
+UI_Push_Id(UI_Context *ui, const char *str)
+{
+	assert(ui->id_scope_count < UI_MAX_ID_SCOPE_DEPTH && "ID scope stack overflow");
+	if (ui->id_scope_count >= UI_MAX_ID_SCOPE_DEPTH) return;
 	
-	// Check if this ID was already used this frame
-	for (int i = 0; i < ctx->used_id_count; i++) {
-		if (ctx->used_ids[i] == base_id) {
-			// Found duplicate - increment counter and rehash
-			int count = ctx->used_id_counts[i]++;
-			
-			// Create unique ID: hash(original + "##" + count)
-			char unique_str[MAX_UI_TEXT_LENGTH];
-			snprintf(unique_str, sizeof(unique_str), "%s##%d", str, count);
-			return UI_HashString(unique_str);
+	UI_Id scope = UI_Hash_String_Seeded(UI_Id_Seed(ui), str ? str : "");
+	ui->id_scope_stack[ui->id_scope_count++] = scope;
+}
+
+
+// .............................................................................................
+void
+UI_Push_Id_Int(UI_Context *ui, int index)
+{
+	assert(ui->id_scope_count < UI_MAX_ID_SCOPE_DEPTH && "ID scope stack overflow");
+	if (ui->id_scope_count >= UI_MAX_ID_SCOPE_DEPTH) return;
+	
+	ui->id_scope_stack[ui->id_scope_count++] = UI_Id_Mix(UI_Id_Seed(ui), index);
+}
+
+
+// .............................................................................................
+void
+UI_Pop_Id(UI_Context *ui)
+{
+	assert(ui->id_scope_count > 0 && "UI_Pop_Id without matching UI_Push_Id");
+	if (ui->id_scope_count > 0) ui->id_scope_count--;
+}
+
+
+// .............................................................................................
+// UI_Arena_Alloc - Bump-allocate from the current page, moving to (or adding) the next page
+// when it is full. Returns NULL only if a new page cannot be allocated.
+void *
+UI_Arena_Alloc(UI_Arena *arena, int size)
+{
+	size = (size + 7) & ~7;
+	
+	UI_Arena_Page *page = arena->current;
+	while (page && page->used + size > page->capacity) {
+		page = page->next;
+		if (page) page->used = 0;  // Pages after 'current' hold stale data from an older frame
+	}
+	
+	if (!page) {
+		int capacity = size > UI_ARENA_PAGE_SIZE ? size : UI_ARENA_PAGE_SIZE;
+		page = (UI_Arena_Page *)UI_MALLOC(sizeof(UI_Arena_Page) + capacity);
+		if (!page) return 0;
+		page->capacity = capacity;
+		page->used = 0;
+		
+		// Append after 'current' (keeps page order = allocation order)
+		if (arena->current) {
+			page->next = arena->current->next;
+			arena->current->next = page;
+		} else {
+			page->next = arena->first;
+			arena->first = page;
 		}
+		arena->reserved += capacity;
 	}
 	
-	// First use - track it
-	if (ctx->used_id_count < UI_MAX_USED_IDS) {
-		ctx->used_ids[ctx->used_id_count] = base_id;
-		ctx->used_id_counts[ctx->used_id_count] = 0;
-		ctx->used_id_count++;
+	arena->current = page;
+	void *result = (char *)(page + 1) + page->used;
+	page->used += size;
+	arena->used += size;
+	if (arena->used > arena->high_water) arena->high_water = arena->used;
+	return result;
+}
+
+
+// .............................................................................................
+void
+UI_Arena_Reset(UI_Arena *arena)
+{
+	arena->current = arena->first;
+	if (arena->first) arena->first->used = 0;
+	arena->used = 0;
+}
+
+
+// .............................................................................................
+void
+UI_Arena_Free(UI_Arena *arena)
+{
+	UI_Arena_Page *page = arena->first;
+	while (page) {
+		UI_Arena_Page *next = page->next;
+		UI_FREE(page);
+		page = next;
 	}
+	UI_MEMSET(arena, 0, sizeof(UI_Arena));
+}
+
+
+// .............................................................................................
+// Grow a primitive array to hold at least 'needed' entries (doubling, starting at initial)
+static int
+UI_Grow_Array(void **items, int *capacity, int needed, int item_size, int initial)
+{
+	if (needed <= *capacity) return 1;
 	
-	return base_id;
+	int new_capacity = *capacity ? *capacity : initial;
+	while (new_capacity < needed) new_capacity *= 2;
+	
+	void *grown = UI_REALLOC(*items, (size_t)new_capacity * item_size);
+	if (!grown) return 0;
+	*items = grown;
+	*capacity = new_capacity;
+	return 1;
+}
+
+
+// .............................................................................................
+void
+UI_Render_List_Reset(UI_Render_List *list)
+{
+	list->rect_count = 0;
+	list->text_count = 0;
+	list->cache_group_count = 0;
+	list->clip_count = 0;
+	UI_Arena_Reset(&list->strings);
+}
+
+
+// .............................................................................................
+void
+UI_Render_List_Free(UI_Render_List *list)
+{
+	UI_FREE(list->rectangles);
+	UI_FREE(list->texts);
+	UI_FREE(list->cache_groups);
+	UI_FREE(list->clip_rects);
+	UI_Arena_Free(&list->strings);
+	UI_MEMSET(list, 0, sizeof(UI_Render_List));
+}
+
+
+// .............................................................................................
+// UI_Render_List_Copy - Deep copy (strings are copied into dst's own arena)
+// Returns 0 on allocation failure (dst is left empty).
+int
+UI_Render_List_Copy(UI_Render_List *dst, const UI_Render_List *src)
+{
+	UI_Render_List_Reset(dst);
+	
+	if (!UI_Grow_Array((void **)&dst->rectangles, &dst->rect_capacity, src->rect_count,
+	                   sizeof(UI_Rectangle), UI_MAX_RECTANGLES)) return 0;
+	if (!UI_Grow_Array((void **)&dst->texts, &dst->text_capacity, src->text_count,
+	                   sizeof(UI_Text), UI_MAX_TEXTS)) return 0;
+	if (!UI_Grow_Array((void **)&dst->cache_groups, &dst->cache_group_capacity, src->cache_group_count,
+	                   sizeof(UI_Cache_Group), UI_MAX_CACHE_GROUPS)) return 0;
+	if (!UI_Grow_Array((void **)&dst->clip_rects, &dst->clip_capacity, src->clip_count,
+	                   sizeof(UI_RectI), UI_MAX_CLIP_RECTS)) return 0;
+	
+	if (src->rect_count) {
+		memcpy(dst->rectangles, src->rectangles, src->rect_count * sizeof(UI_Rectangle));
+	}
+	if (src->cache_group_count) {
+		memcpy(dst->cache_groups, src->cache_groups, src->cache_group_count * sizeof(UI_Cache_Group));
+	}
+	if (src->clip_count) {
+		memcpy(dst->clip_rects, src->clip_rects, src->clip_count * sizeof(UI_RectI));
+	}
+	
+	for (int i = 0; i < src->text_count; i++) {
+		const UI_Text *t = &src->texts[i];
+		char *text = (char *)UI_Arena_Alloc(&dst->strings, t->text_length + 1);
+		if (!text) {
+			UI_Render_List_Reset(dst);
+			return 0;
+		}
+		memcpy(text, t->text, t->text_length + 1);
+		dst->texts[i] = *t;
+		dst->texts[i].text = text;
+	}
+	
+	dst->rect_count = src->rect_count;
+	dst->text_count = src->text_count;
+	dst->cache_group_count = src->cache_group_count;
+	dst->clip_count = src->clip_count;
+	return 1;
+}
+
+
+// .............................................................................................
+// Intersection of two rects (w or h <= 0 if they do not overlap)
+static UI_RectI
+UI_Intersect_Rect(UI_RectI a, UI_RectI b)
+{
+	int l = a.x > b.x ? a.x : b.x;
+	int t = a.y > b.y ? a.y : b.y;
+	int r = (a.x + a.w < b.x + b.w) ? a.x + a.w : b.x + b.w;
+	int bt = (a.y + a.h < b.y + b.h) ? a.y + a.h : b.y + b.h;
+	UI_RectI out = { l, t, r - l, bt - t };
+	return out;
 }
 
 
 // .............................................................................................
+// Clip applied to emitted primitives (index into g_render_list->clip_rects, -1 = none)
+static int g_emit_clip = -1;
+
 static void
 UI_Add_Rectangle(int l, int t, int r, int b, uint32_t color)
 {
 	if (!g_render_list) return;
-	assert(g_render_list->rect_count < UI_MAX_RECTANGLES && "Rectangle buffer overflow");
-	if (g_render_list->rect_count >= UI_MAX_RECTANGLES) return;  // Silent fail in release
+	
+	// Rects are clipped geometrically, so renderers never need a clip for them
+	if (g_emit_clip >= 0) {
+		const UI_RectI *c = &g_render_list->clip_rects[g_emit_clip];
+		if (l < c->x) l = c->x;
+		if (t < c->y) t = c->y;
+		if (r > c->x + c->w) r = c->x + c->w;
+		if (b > c->y + c->h) b = c->y + c->h;
+		if (r <= l || b <= t) return;
+	}
+	
+	if (!UI_Grow_Array((void **)&g_render_list->rectangles, &g_render_list->rect_capacity,
+	                   g_render_list->rect_count + 1, sizeof(UI_Rectangle), UI_MAX_RECTANGLES)) {
+		assert(!"Rectangle buffer allocation failed");
+		return;  // Silent fail in release
+	}
 
 	UI_Rectangle *dst = &g_render_list->rectangles[g_render_list->rect_count++];
 	dst->left = l;
@@ -102,9 +445,33 @@ UI_Add_Text(int x, int y, int w, int h, const char *text_str,
             uint32_t color, int font_size, int font_style, int align_h, int align_v)
 {
 	if (!g_render_list) return;
-	assert(g_render_list->text_count < UI_MAX_TEXTS && "Text buffer overflow");
-	if (g_render_list->text_count >= UI_MAX_TEXTS) return;  // Silent fail in release
 	if (!text_str) return;
+	
+	// Texts fully inside the clip need none, fully outside are dropped
+	int clip = -1;
+	if (g_emit_clip >= 0) {
+		const UI_RectI *c = &g_render_list->clip_rects[g_emit_clip];
+		if (x >= c->x + c->w || y >= c->y + c->h || x + w <= c->x || y + h <= c->y) return;
+		if (x < c->x || y < c->y || x + w > c->x + c->w || y + h > c->y + c->h) clip = g_emit_clip;
+	}
+	
+	if (!UI_Grow_Array((void **)&g_render_list->texts, &g_render_list->text_capacity,
+	                   g_render_list->text_count + 1, sizeof(UI_Text), UI_MAX_TEXTS)) {
+		assert(!"Text buffer allocation failed");
+		return;  // Silent fail in release
+	}
+	
+	// Copy into the string arena (clamped so renderers can convert into fixed wide buffers)
+	int len = 0;
+	while (len < MAX_UI_TEXT_LENGTH - 1 && text_str[len]) len++;
+	
+	char *text = (char *)UI_Arena_Alloc(&g_render_list->strings, len + 1);
+	if (!text) {
+		assert(!"Text arena allocation failed");
+		return;
+	}
+	memcpy(text, text_str, len);
+	text[len] = 0;
 
 	UI_Text *dst = &g_render_list->texts[g_render_list->text_count++];
 	dst->x = x;
@@ -112,19 +479,98 @@ UI_Add_Text(int x, int y, int w, int h, const char *text_str,
 	dst->w = w;
 	dst->h = h;
 	dst->color = color;
-	
-	// Safe string copy
-	int len = 0;
-	while (len < MAX_UI_TEXT_LENGTH - 1 && text_str[len]) {
-		dst->text[len] = text_str[len];
-		len++;
-	}
-	dst->text[len] = 0;
-	
+	dst->text = text;
+	dst->text_length = len;
 	dst->font_size = font_size;
 	dst->font_style = font_style;
 	dst->align_h = align_h;
 	dst->align_v = align_v;
+	dst->clip = clip;
+}
+
+
+// .............................................................................................
+// Grow the parallel panel arrays together to hold at least 'needed' panels
+static int
+UI_State_Grow(UI_State *s, int needed)
+{
+	int capacity = s->panel_capacity;
+	int panels_capacity = capacity, styles_capacity = capacity, cold_capacity = capacity;
+	int content_capacity = capacity;
+	
+	if (!UI_Grow_Array((void **)&s->panels, &panels_capacity, needed, sizeof(UI_Panel), UI_MAX_PANELS)) return 0;
+	if (!UI_Grow_Array((void **)&s->styles, &styles_capacity, needed, sizeof(UI_Style), UI_MAX_PANELS)) return 0;
+	if (!UI_Grow_Array((void **)&s->cold, &cold_capacity, needed, sizeof(UI_Panel_Cold), UI_MAX_PANELS)) return 0;
+	if (!UI_Grow_Array((void **)&s->content, &content_capacity, needed, sizeof(UI_Panel_Content), UI_MAX_PANELS)) return 0;
+	
+	s->panel_capacity = panels_capacity;
+	return 1;
+}
+
+
+// .............................................................................................
+// Record id -> panel_idx (first panel with an ID wins, matching the old linear scan)
+static void
+UI_Index_Insert(UI_Panel_Index_Slot *table, int capacity, uint32_t generation, UI_Id id, int panel_idx)
+{
+	uint32_t mask = (uint32_t)capacity - 1;
+	uint32_t slot = UI_Id_Mix(id, 0) & mask;
+	
+	while (table[slot].generation == generation) {
+		if (table[slot].id == id) return;
+		slot = (slot + 1) & mask;
+	}
+	
+	table[slot].id = id;
+	table[slot].panel_idx = panel_idx;
+	table[slot].generation = generation;
+}
+
+
+// .............................................................................................
+// Double the ID index and re-insert this frame's panels
+static int
+UI_Index_Grow(UI_State *s)
+{
+	int capacity = s->id_index_capacity ? s->id_index_capacity * 2 : UI_MAX_PANELS * 2;
+	UI_Panel_Index_Slot *table = (UI_Panel_Index_Slot *)UI_CALLOC(capacity, sizeof(UI_Panel_Index_Slot));
+	if (!table) return 0;
+	
+	if (s->id_index_generation == 0) s->id_index_generation = 1;  // 0 marks calloc'd slots empty
+	for (int i = 0; i < s->panel_count; i++) {
+		UI_Index_Insert(table, capacity, s->id_index_generation, s->panels[i].id, i);
+	}
+	
+	UI_FREE(s->id_index);
+	s->id_index = table;
+	s->id_index_capacity = capacity;
+	return 1;
+}
+
+
+// .............................................................................................
+static int
+UI_Index_Find(const UI_Panel_Index_Slot *table, int capacity, uint32_t generation, UI_Id id)
+{
+	if (!table || generation == 0) return -1;
+	
+	uint32_t mask = (uint32_t)capacity - 1;
+	uint32_t slot = UI_Id_Mix(id, 0) & mask;
+	
+	while (table[slot].generation == generation) {
+		if (table[slot].id == id) return table[slot].panel_idx;
+		slot = (slot + 1) & mask;
+	}
+	return -1;
+}
+
+
+// .............................................................................................
+// UI_Find_Panel_By_Id - Panel index for an ID in the current frame, or -1
+int
+UI_Find_Panel_By_Id(UI_State *s, UI_Id id)
+{
+	return UI_Index_Find(s->id_index, s->id_index_capacity, s->id_index_generation, id);
 }
 
 
@@ -133,47 +579,96 @@ static int
 UI_New_Panel(UI_State *s, UI_Id id)
 {
 	assert(s != NULL && "UI_State is NULL");
-	assert(s->panel_count < UI_MAX_PANELS && "Panel array overflow - increase UI_MAX_PANELS");
 	
-	if (s->panel_count >= (int)(sizeof(s->panels)/sizeof(s->panels[0]))) return -1;
+	// Grow the panel arrays (invalidates panel/style pointers, never indices)
+	if (s->panel_count >= s->panel_capacity && !UI_State_Grow(s, s->panel_count + 1)) {
+		assert(!"Panel array allocation failed");
+		return -1;
+	}
 
 	int idx = s->panel_count++;
 	UI_Panel *p = &s->panels[idx];
-	assert(idx >= 0 && idx < UI_MAX_PANELS && "Panel index out of bounds");
-	memset(p, 0, sizeof(UI_Panel));
+	UI_Style *style = &s->styles[idx];
+	UI_Panel_Cold *cold = &s->cold[idx];
+	if (s->panel_count > s->panel_high_water) s->panel_high_water = s->panel_count;
+	UI_MEMSET(p, 0, sizeof(UI_Panel));
+	UI_MEMSET(style, 0, sizeof(UI_Style));
 
 	p->id = id;
+	
+	// Index the ID (table kept at <= 1/2 load; growing re-inserts every panel, this one included)
+	if (s->panel_count * 2 > s->id_index_capacity) UI_Index_Grow(s);
+	else UI_Index_Insert(s->id_index, s->id_index_capacity, s->id_index_generation, id, idx);
+
 	p->parent = -1;
 	p->first_child = -1;
 	p->last_child = -1;
 	p->next_sibling = -1;
 
-	p->style.color = 0xFF222222;
-	p->style.min_w = 200; p->style.max_w = INT32_MAX;
-	p->style.min_h = 200; p->style.max_h = INT32_MAX;
-	p->style.pref_w = -1; p->style.pref_h = -1;
+	style->color = 0xFF222222;
+	style->min_w = 0; style->max_w = INT32_MAX;
+	style->min_h = 0; style->max_h = INT32_MAX;
+	style->pref_w = -1; style->pref_h = -1;
 
-	p->style.flex_grow = 0.0f;
-	p->style.flex_shrink = 1.0f;
-	p->style.flex_basis = -1;
+	style->flex_grow = 0.0f;
+	style->flex_shrink = 1.0f;
+	style->flex_basis = -1;
 
-	p->style.direction = 0; // row by default
-	p->style.gap = 0;
+	style->direction = 0; // row by default
+	style->gap = 0;
 
-	p->style.pad_l = p->style.pad_t = p->style.pad_r = p->style.pad_b = 0;
+	style->pad_l = style->pad_t = style->pad_r = style->pad_b = 0;
 	
-	p->style.resizable = 0;
-	p->style.resize_hitbox_padding = 4;
+	style->resizable = 0;
+	style->resize_hitbox_padding = 4;
 	
 	// Initialize label metadata
-	p->is_label = 0;
-	p->label_text[0] = 0;
-	p->label_color = 0xFFFFFFFF;
+	cold->is_label = 0;
+	cold->label_text = 0;
+	cold->label_color = 0xFFFFFFFF;
+	cold->label_font_style = 0;
+	cold->graph_values = 0;
+	cold->graph_count = 0;
+	
+	s->content[idx].pass = 0;
 
 	return idx;
 }
 
 
+// .............................................................................................
+void
+UI_State_Free(UI_State *s)
+{
+	UI_FREE(s->panels);
+	UI_FREE(s->styles);
+	UI_FREE(s->cold);
+	UI_FREE(s->content);
+	UI_FREE(s->id_index);
+	UI_FREE(s->layout_cache.prev_rects);
+	UI_FREE(s->layout_cache.prev_hashes);
+	UI_FREE(s->layout_cache.prev_index);
+	UI_Arena_Free(&s->frame_arena);
+	UI_MEMSET(s, 0, sizeof(UI_State));
+}
+
+
+// .............................................................................................
+// Copy a label string into the frame arena (clamped to MAX_UI_TEXT_LENGTH - 1 bytes)
+static const char*
+UI_Frame_String(UI_State *s, const char *text)
+{
+	int len = 0;
+	while (len < MAX_UI_TEXT_LENGTH - 1 && text[len]) len++;
+	
+	char *dst = (char *)UI_Arena_Alloc(&s->frame_arena, len + 1);
+	if (!dst) return 0;
+	memcpy(dst, text, len);
+	dst[len] = 0;
+	return dst;
+}
+
+
 // .............................................................................................
 static void UI_Add_Child(UI_State *s, int parent_idx, int child_idx)
 {
@@ -201,193 +696,1361 @@ static void UI_Add_Child(UI_State *s, int parent_idx, int child_idx)
 
 
 // .............................................................................................
-// UI_LayoutRow - Layout children horizontally using flexbox-inspired algorithm
-// 
-// TWO-PASS ALGORITHM:
-// Pass 1: Calculate total fixed width and sum flex-grow factors
-// Pass 2: Distribute remaining space proportionally to flex-grow factors
+// Flex layout kernel (rows and columns)
+//
+// Children are gathered from their sibling list into dense blocks of UI_LAYOUT_BLOCK, so
+// the fixed-size and grow sums and the flex shares run over contiguous ints (SSE2, or
+// AVX2 when the compiler targets it; define UI_LAYOUT_SCALAR to force the plain loops).
+//
+// Flex shares are exact: grow factors are converted to integer units, and child i ends
+// at edge floor(remaining * cum_i / grow_total), cum_i = grow units up to and including
+// child i. Shares are differences of consecutive edges, so they sum to exactly remaining
+// (no pixels lost to truncation) and a one-pixel change of remaining moves one edge by
+// one pixel. The edge is computed in doubles, which is exact here (all operands are
+// integers below 2^53), so every path produces the same pixels.
 //
-// Children fill full height of parent (minus padding)
-// Width is either fixed (pref_w >= 0) or flex-grow proportion of remaining space
-static void UI_Layout_Row(UI_State *s, int panel_idx)
+// Constraints: a child's base size is flex_basis, else pref, else 0 when it grows, else
+// its content size (AUTO children also never shrink below their content). The hypothetical
+// size is the base clamped to [min, max]. When the space left over would take a growing
+// child past a min/max, or the children overflow and some can shrink (flex_shrink, weighted
+// by base size), UI_Layout_Solve runs the clamp-and-redistribute loop instead: distribute,
+// freeze the children that violate their clamps, redistribute what is left to the rest.
+// The cross axis uses pref when set and stretches otherwise, clamped to min/max.
+#if !defined(UI_LAYOUT_SCALAR) && defined(__AVX2__)
+#define UI_LAYOUT_AVX2 1
+#include <immintrin.h>
+#endif
+#if !defined(UI_LAYOUT_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define UI_LAYOUT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#define UI_LAYOUT_BLOCK 512       // Children gathered per block (8 KB of stack arrays)
+#define UI_LAYOUT_GROW_ONE 256    // Grow units per 1.0 of flex_grow (and of flex_shrink)
+#define UI_LAYOUT_GROW_MAX 65536  // Per-child clamp: a block's grow units fit in int32
+#define UI_LAYOUT_SOLVE_ITEMS 128 // Solver items on the stack (more are heap allocated)
+
+// UI_Layout_Block::flags
+#define UI_LAYOUT_CONSTRAINED 1   // A growing child has a main-axis min or max
+#define UI_LAYOUT_SHRINKABLE 2    // A child may shrink below its hypothetical size
+
+struct UI_Layout_Block {
+	int count;
+	int flags;                    // UI_LAYOUT_* of the gathered children
+	int child[UI_LAYOUT_BLOCK];   // Panel indices in sibling order
+	int size[UI_LAYOUT_BLOCK];    // Hypothetical main-axis size (base clamped to min/max)
+	int grow[UI_LAYOUT_BLOCK];    // Grow units; UI_Layout_Edges turns them into end edges
+	int cross[UI_LAYOUT_BLOCK];   // Cross-axis size
+};
+
+// Child of a container laid out by UI_Layout_Solve
+struct UI_Layout_Item {
+	int child;
+	int base;                     // Flex base size
+	int lo, hi;                   // Main-axis clamp (lo wins)
+	int size;                     // Target size (final once frozen)
+	int cross;
+	int violation;                // Clamped minus unclamped target of the last round
+	int frozen;
+	int64_t weight;               // Grow units, or shrink units times base size
+};
+
+// Kernel name for benchmark output
+#if UI_LAYOUT_AVX2
+#define UI_LAYOUT_KERNEL_NAME "avx2"
+#elif UI_LAYOUT_SSE2
+#define UI_LAYOUT_KERNEL_NAME "sse2"
+#else
+#define UI_LAYOUT_KERNEL_NAME "scalar"
+#endif
+
+
+// .............................................................................................
+// flex_grow in integer units (0 = no grow; any positive factor gets at least one unit)
+static inline int
+UI_Layout_Grow_Units(float flex_grow)
 {
-    UI_Panel *p = &s->panels[panel_idx];
+	if (!(flex_grow > 0.0f)) return 0;
+	if (flex_grow >= (float)UI_LAYOUT_GROW_MAX / UI_LAYOUT_GROW_ONE) return UI_LAYOUT_GROW_MAX;
 
-    // Content box inside padding
-    int x0 = p->rect.x + p->style.pad_l;
-    int y0 = p->rect.y + p->style.pad_t;
-    int cw = p->rect.w - (p->style.pad_l + p->style.pad_r);
-    int ch = p->rect.h - (p->style.pad_t + p->style.pad_b);
-    if (cw < 0) cw = 0;
-    if (ch < 0) ch = 0;
+	int units = (int)(flex_grow * UI_LAYOUT_GROW_ONE + 0.5f);
+	return (units > 0) ? units : 1;
+}
 
-    // PASS 1: Count children, sum fixed widths, sum flex grow factors
-    int child_count = 0;
-    int fixed_sum = 0;
-    float grow_sum = 0.0f;
 
-    for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling)
-    {
-        child_count++;
+// .............................................................................................
+static inline int
+UI_Layout_Clamp(int size, int lo, int hi)
+{
+	if (size > hi) size = hi;
+	if (size < lo) size = lo;
+	return size;
+}
 
-        UI_Panel *child = &s->panels[c];
-        int w = (child->style.pref_w >= 0) ? child->style.pref_w : 0;
-        fixed_sum += w;
 
-        if (child->style.flex_grow > 0.0f)
-            grow_sum += child->style.flex_grow;
-    }
+static void UI_Layout_Resolve_Content(UI_State *s, int i);
+
+// .............................................................................................
+// Size child c contributes to its parent's content size on one axis (0 = width)
+static inline int
+UI_Layout_Content_Contribution(UI_State *s, int c, int axis)
+{
+	const UI_Style *cs = &s->styles[c];
+	int pref = axis ? cs->pref_h : cs->pref_w;
+	int size = pref;
+	if (pref < 0) {
+		UI_Layout_Resolve_Content(s, c);
+		size = axis ? s->content[c].h : s->content[c].w;
+	}
+	return UI_Layout_Clamp(size, axis ? cs->min_h : cs->min_w, axis ? cs->max_h : cs->max_w);
+}
 
-    int gaps_total = (child_count > 1) ? (p->style.gap * (child_count - 1)) : 0;
 
-    int remaining = cw - fixed_sum - gaps_total;
-    if (remaining < 0) remaining = 0;
+// .............................................................................................
+// Resolve panel i's AUTO content size once per layout pass: the style's intrinsic size
+// (labels), else its children's sizes along its direction plus gaps and padding. Only
+// AUTO-sized children ask, so trees of fixed and flex panels never pay for it. A parallel
+// layout task only resolves panels inside its own subtree.
+static void
+UI_Layout_Resolve_Content(UI_State *s, int i)
+{
+	UI_Panel_Content *content = &s->content[i];
+	if (content->pass == s->layout_pass) return;
+	
+	const UI_Panel *p = &s->panels[i];	
+	const UI_Style *style = &s->styles[i];
+	int w = style->content_w;
+	int h = style->content_h;
+	
+	if (w == 0 && h == 0 && p->first_child != -1) {
+		int count = 0;
+		for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling, count++) {
+			int cw = UI_Layout_Content_Contribution(s, c, 0);
+			int ch = UI_Layout_Content_Contribution(s, c, 1);
+			if (style->direction == 0) { w += cw; if (ch > h) h = ch; }
+			else if (style->direction == 1) { h += ch; if (cw > w) w = cw; }
+			else { if (cw > w) w = cw; if (ch > h) h = ch; }
+		}
+		
+		int gaps = (count > 1) ? style->gap * (count - 1) : 0;
+		if (style->direction == 0) w += gaps;
+		else if (style->direction == 1) h += gaps;
+		w += style->pad_l + style->pad_r;
+		h += style->pad_t + style->pad_b;
+	}
+	
+	content->w = w;
+	content->h = h;
+	content->pass = s->layout_pass;
+}
 
-    // PASS 2: Assign child rectangles (distribute remaining space)
-    int cursor_x = x0;
 
-    for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling)
-    {
-        UI_Panel *child = &s->panels[c];
+// .............................................................................................
+// Main-axis flex base size of child c and its clamp [lo, hi] (see kernel notes)
+static inline int
+UI_Layout_Flex_Base(UI_State *s, int c, int axis, int *lo, int *hi)
+{
+	const UI_Style *cs = &s->styles[c];
+	int pref = axis ? cs->pref_h : cs->pref_w;
+	*lo = axis ? cs->min_h : cs->min_w;
+	*hi = axis ? cs->max_h : cs->max_w;
+	if (*lo < 0) *lo = 0;
+	
+	if (cs->flex_basis >= 0) return cs->flex_basis;
+	if (pref >= 0) return pref;
+	if (cs->flex_grow > 0.0f) return 0;
+	
+	UI_Layout_Resolve_Content(s, c);
+	int content = axis ? s->content[c].h : s->content[c].w;
+	if (*lo < content) *lo = content;
+	return content;
+}
 
-        int w = (child->style.pref_w >= 0) ? child->style.pref_w : 0;
 
-        if (child->style.flex_grow > 0.0f && grow_sum > 0.0f)
-        {
-            // distribute remaining space proportionally
-            float t = child->style.flex_grow / grow_sum;
-            int flex_w = (int)(t * (float)remaining);
-            w += flex_w;
-        }
+// .............................................................................................
+// Cross-axis size of child c: pref when set, else stretched to extent, clamped to min/max
+static inline int
+UI_Layout_Cross_Size(const UI_Style *cs, int axis, int extent)
+{
+	int pref = axis ? cs->pref_w : cs->pref_h;
+	return UI_Layout_Clamp((pref >= 0) ? pref : extent,
+	                       axis ? cs->min_w : cs->min_h, axis ? cs->max_w : cs->max_h);
+}
 
-        // V1: child fills height
-        child->rect.x = cursor_x;
-        child->rect.y = y0;
-        child->rect.w = w;
-        child->rect.h = ch;
 
-        cursor_x += w + p->style.gap;
-    }
+// .............................................................................................
+// Gather up to UI_LAYOUT_BLOCK children starting at c; returns the next block's first
+// child (-1 at the end of the list)
+static int
+UI_Layout_Gather(UI_State *s, int c, int axis, int cross_extent, UI_Layout_Block *b)
+{
+	int n = 0;
+	int flags = 0;
+	for (; c != -1 && n < UI_LAYOUT_BLOCK; c = s->panels[c].next_sibling, n++) {
+		const UI_Style *cs = &s->styles[c];
+		int lo, hi;
+		int base = UI_Layout_Flex_Base(s, c, axis, &lo, &hi);
+		int size = UI_Layout_Clamp(base, lo, hi);
+		int grow = UI_Layout_Grow_Units(cs->flex_grow);
+		
+		if (grow > 0 && (lo > 0 || hi != INT32_MAX)) flags |= UI_LAYOUT_CONSTRAINED;
+		if (cs->flex_shrink > 0.0f && size > lo) flags |= UI_LAYOUT_SHRINKABLE;
+		
+		b->child[n] = c;
+		b->size[n] = size;
+		b->grow[n] = grow;
+		b->cross[n] = UI_Layout_Cross_Size(cs, axis, cross_extent);
+	}
+	b->count = n;
+	b->flags = flags;
+	return c;
+}
+
+
+// .............................................................................................
+// Write child c's rect from its main-axis and cross-axis position and size
+static inline void
+UI_Layout_Place(UI_State *s, int c, int axis, int main_pos, int main_size, int cross_pos, int cross_size)
+{
+	UI_RectI *r = &s->panels[c].rect;
+	if (axis == 0) {
+		r->x = main_pos;
+		r->y = cross_pos;
+		r->w = main_size;
+		r->h = cross_size;
+	} else {
+		r->x = cross_pos;
+		r->y = main_pos;
+		r->w = cross_size;
+		r->h = main_size;
+	}
+}
+
+
+#if UI_LAYOUT_SSE2
+// .............................................................................................
+static inline int
+UI_Layout_Hsum_SSE2(__m128i v)
+{
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(v);
+}
+#endif
+
+
+// .............................................................................................
+// Sum a block's fixed sizes and grow units
+static void
+UI_Layout_Sum_Block(const UI_Layout_Block *b, int *size_sum, int *grow_sum)
+{
+	int i = 0;
+	int sizes = 0;
+	int grows = 0;
+
+#if UI_LAYOUT_SSE2
+	__m128i vs = _mm_setzero_si128();
+	__m128i vg = _mm_setzero_si128();
+#if UI_LAYOUT_AVX2
+	__m256i ws = _mm256_setzero_si256();
+	__m256i wg = _mm256_setzero_si256();
+	for (; i + 8 <= b->count; i += 8) {
+		ws = _mm256_add_epi32(ws, _mm256_loadu_si256((const __m256i *)&b->size[i]));
+		wg = _mm256_add_epi32(wg, _mm256_loadu_si256((const __m256i *)&b->grow[i]));
+	}
+	vs = _mm_add_epi32(_mm256_castsi256_si128(ws), _mm256_extracti128_si256(ws, 1));
+	vg = _mm_add_epi32(_mm256_castsi256_si128(wg), _mm256_extracti128_si256(wg, 1));
+#endif
+	for (; i + 4 <= b->count; i += 4) {
+		vs = _mm_add_epi32(vs, _mm_loadu_si128((const __m128i *)&b->size[i]));
+		vg = _mm_add_epi32(vg, _mm_loadu_si128((const __m128i *)&b->grow[i]));
+	}
+	sizes = UI_Layout_Hsum_SSE2(vs);
+	grows = UI_Layout_Hsum_SSE2(vg);
+#endif
+
+	for (; i < b->count; i++) {
+		sizes += b->size[i];
+		grows += b->grow[i];
+	}
+
+	*size_sum = sizes;
+	*grow_sum = grows;
+}
+
+
+// .............................................................................................
+// Replace a block's grow units with the children's flex end edges (see kernel notes);
+// carry = grow units of the earlier blocks. Returns this block's grow units.
+static int
+UI_Layout_Edges_Block(UI_Layout_Block *b, double carry, double remaining, double grow_total)
+{
+	int i = 0;
+	int cum = 0;  // Grow units of this block so far
+
+#if UI_LAYOUT_SSE2
+	const __m128d v_carry = _mm_set1_pd(carry);
+	const __m128d v_remaining = _mm_set1_pd(remaining);
+	const __m128d v_total = _mm_set1_pd(grow_total);
+#if UI_LAYOUT_AVX2
+	const __m256d w_carry = _mm256_set1_pd(carry);
+	const __m256d w_remaining = _mm256_set1_pd(remaining);
+	const __m256d w_total = _mm256_set1_pd(grow_total);
+	for (; i + 8 <= b->count; i += 8) {
+		// Inclusive prefix sum of 8 lanes (per 128-bit half, then low half's total to high)
+		__m256i x = _mm256_loadu_si256((const __m256i *)&b->grow[i]);
+		x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+		x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+		x = _mm256_add_epi32(x, _mm256_shuffle_epi32(_mm256_permute2x128_si256(x, x, 0x08), 0xFF));
+		x = _mm256_add_epi32(x, _mm256_set1_epi32(cum));
+
+		__m256d lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(x));
+		__m256d hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1));
+		lo = _mm256_div_pd(_mm256_mul_pd(_mm256_add_pd(lo, w_carry), w_remaining), w_total);
+		hi = _mm256_div_pd(_mm256_mul_pd(_mm256_add_pd(hi, w_carry), w_remaining), w_total);
+
+		cum = _mm_cvtsi128_si32(_mm_shuffle_epi32(_mm256_extracti128_si256(x, 1), 0xFF));
+		__m256i edges = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm256_cvttpd_epi32(lo)),
+		                                        _mm256_cvttpd_epi32(hi), 1);
+		_mm256_storeu_si256((__m256i *)&b->grow[i], edges);
+	}
+#endif
+	for (; i + 4 <= b->count; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i *)&b->grow[i]);
+		x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+		x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+		x = _mm_add_epi32(x, _mm_set1_epi32(cum));
+
+		__m128d lo = _mm_cvtepi32_pd(x);
+		__m128d hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(x, _MM_SHUFFLE(3, 2, 3, 2)));
+		lo = _mm_div_pd(_mm_mul_pd(_mm_add_pd(lo, v_carry), v_remaining), v_total);
+		hi = _mm_div_pd(_mm_mul_pd(_mm_add_pd(hi, v_carry), v_remaining), v_total);
+
+		cum = _mm_cvtsi128_si32(_mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3)));
+		_mm_storeu_si128((__m128i *)&b->grow[i],
+		                 _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi)));
+	}
+#endif
+
+	for (; i < b->count; i++) {
+		cum += b->grow[i];
+		b->grow[i] = (int)(((double)cum + carry) * remaining / grow_total);
+	}
+	return cum;
+}
+
+
+// .............................................................................................
+// Weight of a solver item scaled down by shift (a weight never drops to zero)
+static inline int64_t
+UI_Layout_Scaled_Weight(int64_t weight, int shift)
+{
+	int64_t scaled = weight >> shift;
+	return (scaled > 0) ? scaled : 1;
+}
+
+
+// .............................................................................................
+// UI_Layout_Solve - Resolve the main-axis sizes of n items sharing space (gaps excluded)
+//
+// Clamp-and-redistribute: the free space is distributed over the unfrozen items by
+// weight (exact integer edges, as in the fast path), then the items whose targets violate
+// their clamps are frozen at the clamp - min violations if the total violation is
+// positive, max violations if negative - and the rest is distributed again. A zero total
+// ends the loop. Every round freezes at least one item, so it runs at most n rounds.
+static void
+UI_Layout_Solve(UI_Layout_Item *items, int n, int space, int growing)
+{
+	// Items that cannot flex this way stay at their hypothetical size
+	for (int i = 0; i < n; i++) {
+		UI_Layout_Item *it = &items[i];
+		it->size = UI_Layout_Clamp(it->base, it->lo, it->hi);
+		it->frozen = it->weight <= 0 || (growing ? it->base > it->size : it->base < it->size);
+	}
+	
+	for (;;) {
+		int64_t used = 0;
+		int64_t weight_total = 0;
+		for (int i = 0; i < n; i++) {
+			used += items[i].frozen ? items[i].size : items[i].base;
+			if (!items[i].frozen) weight_total += items[i].weight;
+		}
+		if (weight_total == 0) return;
+		
+		// Free space in the flex direction (none once frozen items took it all)
+		int64_t free_space = growing ? space - used : used - space;
+		if (free_space < 0) free_space = 0;
+		
+		// Keep free_space * cumulative weight inside int64
+		int shift = 0;
+		while ((weight_total >> shift) > INT32_MAX) shift++;
+		int64_t scaled_total = 0;
+		for (int i = 0; i < n; i++) {
+			if (!items[i].frozen) scaled_total += UI_Layout_Scaled_Weight(items[i].weight, shift);
+		}
+		
+		int64_t cum = 0;
+		int64_t prev_edge = 0;
+		int64_t violation = 0;
+		for (int i = 0; i < n; i++) {
+			UI_Layout_Item *it = &items[i];
+			if (it->frozen) continue;
+			
+			cum += UI_Layout_Scaled_Weight(it->weight, shift);
+			int64_t edge = free_space * cum / scaled_total;
+			int share = (int)(edge - prev_edge);
+			prev_edge = edge;
+			
+			int target = growing ? it->base + share : it->base - share;
+			it->size = UI_Layout_Clamp(target, it->lo, it->hi);
+			it->violation = it->size - target;
+			violation += it->violation;
+		}
+		if (violation == 0) return;
+		
+		for (int i = 0; i < n; i++) {
+			UI_Layout_Item *it = &items[i];
+			if (!it->frozen && (violation > 0 ? it->violation > 0 : it->violation < 0)) it->frozen = 1;
+		}
+	}
+}
+
+
+// .............................................................................................
+// Lay out panel_idx's children with UI_Layout_Solve and place them from cursor
+// Returns 0 if the item array could not be allocated (nothing was written).
+static int
+UI_Layout_Solve_Children(UI_State *s, int panel_idx, int axis, int child_count, int space, int growing,
+                         int cursor, int cross_pos, int cross_extent)
+{
+	UI_Layout_Item local[UI_LAYOUT_SOLVE_ITEMS];
+	UI_Layout_Item *items = local;
+	if (child_count > UI_LAYOUT_SOLVE_ITEMS) {
+		items = (UI_Layout_Item *)UI_MALLOC(child_count * sizeof(UI_Layout_Item));
+		if (!items) return 0;
+	}
+	
+	// Growing: weight = grow units; shrinking: shrink units scaled by base size
+	int n = 0;
+	for (int c = s->panels[panel_idx].first_child; c != -1 && n < child_count; c = s->panels[c].next_sibling, n++) {
+		const UI_Style *cs = &s->styles[c];
+		UI_Layout_Item *it = &items[n];
+		it->child = c;
+		it->base = UI_Layout_Flex_Base(s, c, axis, &it->lo, &it->hi);
+		it->cross = UI_Layout_Cross_Size(cs, axis, cross_extent);
+		it->weight = growing ? UI_Layout_Grow_Units(cs->flex_grow)
+		                     : (int64_t)UI_Layout_Grow_Units(cs->flex_shrink) * it->base;
+		
+		// Without a min, a shrinking child that does not clip keeps its content (or its
+		// base size, if smaller) visible
+		int min = axis ? cs->min_h : cs->min_w;
+		if (!growing && min <= 0 && !cs->clip_children) {
+			UI_Layout_Resolve_Content(s, c);
+			int content = axis ? s->content[c].h : s->content[c].w;
+			int auto_min = (content < it->base) ? content : it->base;
+			if (it->lo < auto_min) it->lo = auto_min;
+		}
+	}
+	
+	UI_Layout_Solve(items, n, space, growing);
+	
+	int gap = s->styles[panel_idx].gap;
+	for (int i = 0; i < n; i++) {
+		UI_Layout_Place(s, items[i].child, axis, cursor, items[i].size, cross_pos, items[i].cross);
+		cursor += items[i].size + gap;
+	}
+	
+	if (items != local) UI_FREE(items);
+	return 1;
+}
+
+
+// .............................................................................................
+// UI_Layout_Axis - Layout children along one axis using flexbox-inspired algorithm
+//
+// TWO-PASS ALGORITHM (axis 0 = row, 1 = column):
+// Pass 1: Count children, sum hypothetical main-axis sizes and flex-grow units
+// Pass 2: Distribute remaining space exactly by grow units and assign rects
+// (UI_Layout_Solve instead when min/max or flex_shrink come into play, see kernel notes)
+//
+// Columns shift their content up by scroll_y.
+static void
+UI_Layout_Axis(UI_State *s, int panel_idx, int axis)
+{
+	UI_Panel *p = &s->panels[panel_idx];
+	const UI_Style *ps = &s->styles[panel_idx];
+
+	// Content box inside padding
+	int x0 = p->rect.x + ps->pad_l;
+	int y0 = p->rect.y + ps->pad_t;
+	int cw = p->rect.w - (ps->pad_l + ps->pad_r);
+	int ch = p->rect.h - (ps->pad_t + ps->pad_b);
+	if (cw < 0) cw = 0;
+	if (ch < 0) ch = 0;
+	
+	int cross_pos = axis ? x0 : y0;
+	int cross_extent = axis ? cw : ch;
+
+	// PASS 1: Count children, sum hypothetical sizes and grow units. A list that fits one
+	// block is gathered once; longer lists are gathered again in pass 2.
+	UI_Layout_Block block;
+	int child_count = 0;
+	int fixed_sum = 0;
+	int flags = 0;
+	int64_t grow_total = 0;
+
+	int next = p->first_child;
+	do {
+		next = UI_Layout_Gather(s, next, axis, cross_extent, &block);
+		int sizes, grows;
+		UI_Layout_Sum_Block(&block, &sizes, &grows);
+		child_count += block.count;
+		fixed_sum += sizes;
+		grow_total += grows;
+		flags |= block.flags;
+	} while (next != -1);
+	int single_block = (child_count == block.count);
+
+	int gaps_total = (child_count > 1) ? (ps->gap * (child_count - 1)) : 0;
+	int space = (axis ? ch : cw) - gaps_total;
+	int remaining = space - fixed_sum;
+	int cursor = axis ? (y0 - ps->scroll_y) : x0;
+	
+	// Clamps that growth would hit, or an overflow that children can shrink into
+	int growing = remaining > 0 && grow_total > 0;
+	if ((growing && (flags & UI_LAYOUT_CONSTRAINED)) || (remaining < 0 && (flags & UI_LAYOUT_SHRINKABLE))) {
+		if (UI_Layout_Solve_Children(s, panel_idx, axis, child_count, space, growing,
+		                             cursor, cross_pos, cross_extent)) return;
+	}
+	if (remaining < 0) remaining = 0;
+
+	// PASS 2: Flex end edges per block, then child rects
+	int prev_edge = 0;
+	double carry = 0.0;
+
+	next = p->first_child;
+	for (;;) {
+		if (!single_block) next = UI_Layout_Gather(s, next, axis, cross_extent, &block);
+		int block_units = 0;
+		if (grow_total > 0) {
+			block_units = UI_Layout_Edges_Block(&block, carry, (double)remaining, (double)grow_total);
+		}
+
+		for (int i = 0; i < block.count; i++) {
+			int size = block.size[i];
+			if (grow_total > 0) {
+				size += block.grow[i] - prev_edge;
+				prev_edge = block.grow[i];
+			}
+			
+			UI_Layout_Place(s, block.child[i], axis, cursor, size, cross_pos, block.cross[i]);
+			cursor += size + ps->gap;
+		}
+
+		carry += block_units;
+		if (single_block || next == -1) break;
+	}
+}
+
+
+// .............................................................................................
+// Hash panel i's layout inputs together with its children's hashes (which must already be
+// set) and set its subtree size; returns the size
+static int
+UI_Layout_Hash_Panel(UI_State *s, int i)
+{
+	UI_Panel *p = &s->panels[i];
+	const UI_Style *style = &s->styles[i];
+	
+	// Word-wise FNV step (this runs for every panel every frame)
+	uint32_t grow_bits, shrink_bits;
+	memcpy(&grow_bits, &style->flex_grow, sizeof(float));
+	memcpy(&shrink_bits, &style->flex_shrink, sizeof(float));
+	uint32_t words[20] = { (uint32_t)p->id, (uint32_t)style->pref_w, (uint32_t)style->pref_h,
+	                       (uint32_t)style->pad_l, (uint32_t)style->pad_t, (uint32_t)style->pad_r,
+	                       (uint32_t)style->pad_b, grow_bits, (uint32_t)style->gap,
+	                       (uint32_t)style->direction | ((uint32_t)s->cold[i].is_label << 8) |
+	                       ((uint32_t)s->cold[i].label_font_style << 16),
+	                       (uint32_t)style->scroll_y,
+	                       (uint32_t)style->min_w, (uint32_t)style->max_w,
+	                       (uint32_t)style->min_h, (uint32_t)style->max_h,
+	                       shrink_bits, (uint32_t)style->flex_basis,
+	                       (uint32_t)style->content_w, (uint32_t)style->content_h,
+	                       // Hitbox inputs: unchanged hash also means an unchanged hit grid
+	                       ((uint32_t)style->resize_hitbox_padding << 2) | ((uint32_t)style->resizable << 1) |
+	                       (uint32_t)style->clip_children };
+	uint32_t h = 2166136261u;
+	for (int w = 0; w < 20; w++) h = (h ^ words[w]) * 16777619u;
+	
+	int size = 1;
+	for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling) {
+		h = (h ^ s->panels[c].subtree_hash) * 16777619u;
+		size += s->panels[c].subtree_size;
+	}
+	
+	p->subtree_hash = h;
+	p->subtree_size = size;
+	return size;
+}
+
+
+// .............................................................................................
+// Set panel i's subtree size from its children's (no hash; the parallel fork split only
+// needs sizes) and return it
+static int
+UI_Layout_Size_Panel(UI_State *s, int i)
+{
+	int size = 1;
+	for (int c = s->panels[i].first_child; c != -1; c = s->panels[c].next_sibling) {
+		size += s->panels[c].subtree_size;
+	}
+	s->panels[i].subtree_size = size;
+	return size;
+}
+
+
+// .............................................................................................
+// Hash every panel (children have larger indices than their parent, so one backward pass
+// sees children first). Only needed for trees not built through UI_End_Panel.
+static void
+UI_Layout_Hash_Subtrees(UI_State *s)
+{
+	for (int i = s->panel_count - 1; i >= 0; i--) UI_Layout_Hash_Panel(s, i);
+	s->panels_hashed = s->panel_count;
+	s->panels_sized = s->panel_count;
+}
+
+
+// .............................................................................................
+// Size every panel without hashing, for the same trees
+static void
+UI_Layout_Size_Subtrees(UI_State *s)
+{
+	for (int i = s->panel_count - 1; i >= 0; i--) UI_Layout_Size_Panel(s, i);
+	s->panels_sized = s->panel_count;
+}
+
+
+// Layout statistics of one thread's share of the tree (parallel tasks count separately
+// and are summed in fork order, so the totals match the serial path)
+struct UI_Layout_Counts {
+	int subtree_hits;
+	int panels_reused;
+	int panels_laid_out;
+	int parallel_tasks;
+};
+
+
+// .............................................................................................
+// Reuse last frame's descendant rects if this subtree and its incoming rect are unchanged
+static int
+UI_Layout_Try_Cached(UI_State *s, int panel_idx, UI_Layout_Counts *counts)
+{
+	UI_Layout_Cache *cache = &s->layout_cache;
+	UI_Panel *p = &s->panels[panel_idx];
+	
+	int prev = UI_Index_Find(cache->prev_index, cache->prev_index_capacity, cache->prev_index_generation, p->id);
+	if (prev < 0 || prev + p->subtree_size > cache->prev_count) return 0;
+	if (cache->prev_hashes[prev] != p->subtree_hash) return 0;
+	
+	UI_RectI a = cache->prev_rects[prev];
+	if (a.x != p->rect.x || a.y != p->rect.y || a.w != p->rect.w || a.h != p->rect.h) return 0;
+	
+	// Same hash -> same shape, so pre-order offsets inside the subtree correspond
+	for (int k = 1; k < p->subtree_size; k++) {
+		s->panels[panel_idx + k].rect = cache->prev_rects[prev + k];
+	}
+	
+	counts->subtree_hits++;
+	counts->panels_reused += p->subtree_size - 1;
+	return 1;
+}
+
+
+static void UI_Layout_Subtree(UI_State *s, int panel_idx, int use_cache, UI_Layout_Counts *counts);
+
+// Run of sibling subtrees [first_child, stop_child) laid out as one pool task
+struct UI_Layout_Job {
+	UI_State *s;
+	int first_child;
+	int stop_child;
+	int use_cache;
+	UI_Layout_Counts counts;
+};
+
+
+// .............................................................................................
+static void
+UI_Layout_Job_Run(void *arg)
+{
+	UI_Layout_Job *job = (UI_Layout_Job *)arg;
+	for (int c = job->first_child; c != job->stop_child; c = job->s->panels[c].next_sibling) {
+		UI_Layout_Subtree(job->s, c, job->use_cache, &job->counts);
+	}
+}
+
+
+// .............................................................................................
+// Lay out the child subtrees of panel_idx (whose children already have rects) on the pool.
+// Each child subtree only writes its own contiguous range of rects, so runs of siblings
+// of about UI_PARALLEL_LAYOUT_MIN_PANELS panels are forked as tasks; the last run is
+// done by this thread while the others are in flight.
+static void
+UI_Layout_Children_Parallel(UI_State *s, int panel_idx, int use_cache, UI_Layout_Counts *counts)
+{
+	UI_Layout_Job jobs[UI_PARALLEL_LAYOUT_MAX_FORKS];
+	int job_count = 0;
+	Task_Group group = {0};
+	
+	int c = s->panels[panel_idx].first_child;
+	while (c != -1 && job_count < UI_PARALLEL_LAYOUT_MAX_FORKS) {
+		int run_first = c;
+		int run_size = 0;
+		while (c != -1 && run_size < UI_PARALLEL_LAYOUT_MIN_PANELS) {
+			run_size += s->panels[c].subtree_size;
+			c = s->panels[c].next_sibling;
+		}
+		
+		// Last run stays on this thread
+		if (c == -1) {
+			c = run_first;
+			break;
+		}
+		
+		UI_Layout_Job *job = &jobs[job_count++];
+		job->s = s;
+		job->first_child = run_first;
+		job->stop_child = c;
+		job->use_cache = use_cache;
+		UI_MEMSET(&job->counts, 0, sizeof(UI_Layout_Counts));
+		Task_Pool_Spawn(s->layout_pool, &group, UI_Layout_Job_Run, job);
+	}
+	
+	for (; c != -1; c = s->panels[c].next_sibling) {
+		UI_Layout_Subtree(s, c, use_cache, counts);
+	}
+	
+	Task_Pool_Wait(s->layout_pool, &group);
+	
+	for (int j = 0; j < job_count; j++) {
+		counts->subtree_hits += jobs[j].counts.subtree_hits;
+		counts->panels_reused += jobs[j].counts.panels_reused;
+		counts->panels_laid_out += jobs[j].counts.panels_laid_out;
+		counts->parallel_tasks += jobs[j].counts.parallel_tasks;
+	}
+	counts->parallel_tasks += job_count;
+}
+
+
+// .............................................................................................
+static void UI_Layout_Subtree(UI_State *s, int panel_idx, int use_cache, UI_Layout_Counts *counts)
+{
+    UI_Panel *p = &s->panels[panel_idx];
+
+    // Layout this container's children based on its direction
+    if (p->first_child != -1)
+    {
+        if (use_cache && UI_Layout_Try_Cached(s, panel_idx, counts)) return;
+        
+        int direction = s->styles[panel_idx].direction;
+        if (direction == 0 || direction == 1) UI_Layout_Axis(s, panel_idx, direction);
+        counts->panels_laid_out++;
+
+        // Recurse into children (large subtrees fork onto the layout pool)
+        if (s->layout_pool && p->subtree_size >= UI_PARALLEL_LAYOUT_MIN_PANELS) {
+            UI_Layout_Children_Parallel(s, panel_idx, use_cache, counts);
+            return;
+        }
+        
+        for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling)
+            UI_Layout_Subtree(s, c, use_cache, counts);
+    }
+}
+
+
+// .............................................................................................
+// Save this frame's rects, hashes and ID index for the next frame's cache lookups
+static void
+UI_Layout_Cache_Store(UI_State *s)
+{
+	UI_Layout_Cache *cache = &s->layout_cache;
+	cache->valid = 0;
+	
+	int rect_capacity = cache->prev_capacity, hash_capacity = cache->prev_capacity;
+	if (!UI_Grow_Array((void **)&cache->prev_rects, &rect_capacity, s->panel_count, sizeof(UI_RectI), UI_MAX_PANELS)) return;
+	if (!UI_Grow_Array((void **)&cache->prev_hashes, &hash_capacity, s->panel_count, sizeof(uint32_t), UI_MAX_PANELS)) return;
+	cache->prev_capacity = rect_capacity;
+	
+	if (cache->prev_index_capacity != s->id_index_capacity) {
+		UI_Panel_Index_Slot *index = (UI_Panel_Index_Slot *)UI_REALLOC(cache->prev_index,
+		                             s->id_index_capacity * sizeof(UI_Panel_Index_Slot));
+		if (!index) return;
+		cache->prev_index = index;
+		cache->prev_index_capacity = s->id_index_capacity;
+	}
+	if (s->id_index_capacity) {
+		memcpy(cache->prev_index, s->id_index, s->id_index_capacity * sizeof(UI_Panel_Index_Slot));
+	}
+	cache->prev_index_generation = s->id_index_generation;
+	
+	for (int i = 0; i < s->panel_count; i++) {
+		cache->prev_rects[i] = s->panels[i].rect;
+		cache->prev_hashes[i] = s->panels[i].subtree_hash;
+	}
+	cache->prev_count = s->panel_count;
+	cache->valid = 1;
+}
+
+
+// .............................................................................................
+// UI_Layout_Panel_Tree - Lay out the subtree rooted at panel_idx (its rect must be set)
+// Subtrees whose layout inputs and incoming rect match the previous frame reuse the
+// previous frame's rects, so a divider drag only recomputes the panels it affects.
+// With UI_State::layout_pool set, large subtrees are laid out in parallel; the rects
+// and statistics are identical to the serial path.
+static void UI_Layout_Panel_Tree(UI_State *s, int panel_idx)
+{
+	UI_Layout_Cache *cache = &s->layout_cache;
+	UI_Layout_Counts counts;
+	UI_MEMSET(&counts, 0, sizeof(UI_Layout_Counts));
+	
+	// UI_End_Panel hashes (or with the cache disabled, only sizes) every panel while
+	// building; trees built otherwise (snapshot panels, unbalanced ends) get a full pass.
+	// The parallel path only needs subtree sizes to pick its forks.
+	if (!cache->disabled) {
+		if (s->panels_hashed != s->panel_count) UI_Layout_Hash_Subtrees(s);
+	} else if (s->layout_pool && s->panels_sized != s->panel_count) {
+		UI_Layout_Size_Subtrees(s);
+	}
+	if (++s->layout_pass == 0) s->layout_pass = 1;  // 0 = never resolved
+	UI_Layout_Subtree(s, panel_idx, cache->valid && !cache->disabled, &counts);
+	
+	cache->subtree_hits = counts.subtree_hits;
+	cache->panels_reused = counts.panels_reused;
+	cache->panels_laid_out = counts.panels_laid_out;
+	cache->parallel_tasks = counts.parallel_tasks;
+	if (cache->disabled) {
+		s->rects_generation++;
+		return;
+	}
+	
+	// Whole tree reused: same shape, IDs, rects and hitbox flags, so the stored frame
+	// (and the hit grid built from it) is still exact
+	int whole_tree_reused = cache->subtree_hits == 1 && cache->panels_laid_out == 0 &&
+	                        panel_idx == 0 && s->panels[0].subtree_size == s->panel_count &&
+	                        cache->prev_count == s->panel_count;
+	if (!whole_tree_reused) {
+		UI_Layout_Cache_Store(s);
+		s->rects_generation++;
+	}
+}
+
+
+// .............................................................................................
+static uint32_t
+UI_Hash_Text_Primitive(uint32_t h, const UI_Text *t, const UI_RectI *clip)
+{
+	if (clip) h = UI_Hash_Bytes(h, clip, sizeof(UI_RectI));
+	
+	int fields[9] = { t->x, t->y, t->w, t->h, (int)t->color, 
+	                  t->font_size, t->font_style, t->align_h, t->align_v };
+	h = UI_Hash_Bytes(h, fields, sizeof(fields));
+	
+	return UI_Hash_Bytes(h, t->text, t->text_length);
+}
+
+
+// .............................................................................................
+static void
+UI_Union_Rect(UI_RectI *acc, int *has_acc, int l, int t, int r, int b)
+{
+	if (r <= l || b <= t) return;
+	
+	if (!*has_acc) {
+		acc->x = l; acc->y = t; acc->w = r - l; acc->h = b - t;
+		*has_acc = 1;
+		return;
+	}
+	
+	int al = acc->x, at = acc->y, ar = acc->x + acc->w, ab = acc->y + acc->h;
+	if (l < al) al = l;
+	if (t < at) at = t;
+	if (r > ar) ar = r;
+	if (b > ab) ab = b;
+	acc->x = al; acc->y = at; acc->w = ar - al; acc->h = ab - at;
+}
+
+
+// .............................................................................................
+// Open a cache group at the current end of the render list (-1 if none could be added)
+static int
+UI_Begin_Cache_Group(UI_Id id)
+{
+	if (!g_render_list) return -1;
+	if (!UI_Grow_Array((void **)&g_render_list->cache_groups, &g_render_list->cache_group_capacity,
+	                   g_render_list->cache_group_count + 1, sizeof(UI_Cache_Group), UI_MAX_CACHE_GROUPS)) {
+		return -1;  // Subtree is still emitted, just not cacheable
+	}
+	
+	UI_Cache_Group *group = &g_render_list->cache_groups[g_render_list->cache_group_count++];
+	UI_MEMSET(group, 0, sizeof(UI_Cache_Group));
+	group->id = id;
+	group->rect_begin = g_render_list->rect_count;
+	group->text_begin = g_render_list->text_count;
+	return g_render_list->cache_group_count - 1;
+}
+
+
+// .............................................................................................
+// Close a cache group: compute its bounds and the origin-relative content hash
+static void
+UI_End_Cache_Group(int group_idx)
+{
+	UI_Render_List *list = g_render_list;
+	UI_Cache_Group *group = &list->cache_groups[group_idx];
+	group->rect_end = list->rect_count;
+	group->text_end = list->text_count;
+	
+	UI_RectI bounds = {0, 0, 0, 0};
+	int has_bounds = 0;
+	for (int i = group->rect_begin; i < group->rect_end; i++) {
+		const UI_Rectangle *r = &list->rectangles[i];
+		UI_Union_Rect(&bounds, &has_bounds, r->left, r->top, r->right, r->bottom);
+	}
+	for (int i = group->text_begin; i < group->text_end; i++) {
+		const UI_Text *t = &list->texts[i];
+		UI_Union_Rect(&bounds, &has_bounds, t->x, t->y, t->x + t->w, t->y + t->h);
+	}
+	
+	if (!has_bounds) {
+		list->cache_group_count--;  // Nothing visible: drop the group (it is the last one)
+		return;
+	}
+	
+	// Pad for glyph overhang and antialiased edges
+	group->x = bounds.x - 2;
+	group->y = bounds.y - 2;
+	group->w = bounds.w + 4;
+	group->h = bounds.h + 4;
+	
+	uint32_t h = 2166136261u;
+	int header[4] = { group->w, group->h, group->rect_end - group->rect_begin, group->text_end - group->text_begin };
+	h = UI_Hash_Bytes(h, header, sizeof(header));
+	
+	for (int i = group->rect_begin; i < group->rect_end; i++) {
+		const UI_Rectangle *r = &list->rectangles[i];
+		int fields[5] = { r->left - group->x, r->top - group->y, r->right - group->x, 
+		                  r->bottom - group->y, (int)r->color };
+		h = UI_Hash_Bytes(h, fields, sizeof(fields));
+	}
+	
+	for (int i = group->text_begin; i < group->text_end; i++) {
+		UI_Text t = list->texts[i];
+		t.x -= group->x;
+		t.y -= group->y;
+		UI_RectI clip;
+		if (t.clip >= 0) {
+			clip = list->clip_rects[t.clip];
+			clip.x -= group->x;
+			clip.y -= group->y;
+		}
+		h = UI_Hash_Text_Primitive(h, &t, t.clip >= 0 ? &clip : 0);
+	}
+	
+	group->content_hash = h;
+}
+
+
+// .............................................................................................
+static int g_emit_in_cache_group = 0;  // Cache groups are not nested (outermost panel wins)
+
+// Visible area while emitting: the window (top-level panel rect) intersected with clips
+static UI_RectI g_emit_visible;
+static int g_emit_has_visible = 0;
+
+// UI_Emit_Panels - Append the subtree's primitives to the render list
+// A panel whose rect lies entirely outside the visible area emits nothing itself. If it
+// clips its children the whole subtree is culled unvisited; otherwise its children are
+// still visited, so panels that overflow a non-clipping parent are still drawn.
+static void UI_Emit_Panels(UI_State *s, int panel_idx)
+{
+    UI_Panel *p = &s->panels[panel_idx];
+    const UI_Style *ps = &s->styles[panel_idx];
+    const UI_Panel_Cold *cold = &s->cold[panel_idx];
+    
+    UI_RectI saved_visible = g_emit_visible;
+    int saved_has_visible = g_emit_has_visible;
+    int self_visible = 1;
+    if (panel_idx == 0) s->panels_culled = 0;  // Stats of the last emit (shown next frame)
+    if (p->parent < 0) {
+        g_emit_visible = p->rect;  // Top-level panels cover the window
+        g_emit_has_visible = 1;
+    } else if (g_emit_has_visible) {
+        const UI_RectI *v = &g_emit_visible;
+        if (p->rect.x >= v->x + v->w || p->rect.y >= v->y + v->h ||
+            p->rect.x + p->rect.w <= v->x || p->rect.y + p->rect.h <= v->y) {
+            if (ps->clip_children) {
+                s->panels_culled += p->subtree_size > 0 ? p->subtree_size : 1;
+                return;
+            }
+            self_visible = 0;  // Children may still overflow into view
+            s->panels_culled++;
+        }
+    }
+    
+    int group_idx = -1;
+    if (self_visible && ps->cache_bitmap && !g_emit_in_cache_group) {
+        group_idx = UI_Begin_Cache_Group(p->id);
+        if (group_idx >= 0) g_emit_in_cache_group = 1;
+    }
+
+    // Emit this panel's rect (skip if transparent and is label)
+    if (self_visible && !(cold->is_label && ps->color == 0x00000000)) {
+        UI_Add_Rectangle(
+            p->rect.x,
+            p->rect.y,
+            p->rect.x + p->rect.w,
+            p->rect.y + p->rect.h,
+            ps->color
+        );
+    }
+    
+    // Emit label text if this is a label panel
+    if (self_visible && cold->is_label && cold->label_text && cold->label_text[0] != 0) {
+        UI_Add_Text(
+            p->rect.x,
+            p->rect.y,
+            p->rect.w,
+            p->rect.h,
+            cold->label_text,
+            cold->label_color,
+            14,
+            cold->label_font_style,
+            UI_ALIGN_START,
+            UI_ALIGN_CENTER
+        );
+    }
+
+    // Emit graph bars (bottom-aligned, scaled to graph_max)
+    if (self_visible && cold->graph_count > 0 && cold->graph_values && cold->graph_max > 0.0f) {
+        int n = cold->graph_count;
+        for (int i = 0; i < n; i++) {
+            float t = cold->graph_values[i] / cold->graph_max;
+            if (t > 1.0f) t = 1.0f;
+            if (t <= 0.0f) continue;
+            
+            int l = p->rect.x + (int)((int64_t)i * p->rect.w / n);
+            int r = p->rect.x + (int)((int64_t)(i + 1) * p->rect.w / n);
+            if (r <= l) r = l + 1;
+            int bottom = p->rect.y + p->rect.h;
+            UI_Add_Rectangle(l, bottom - (int)(t * (float)p->rect.h + 0.5f), r, bottom, cold->graph_color);
+        }
+    }
+
+    // Push a clip for the descendants (nested clips intersect)
+    int saved_clip = g_emit_clip;
+    int children_visible = 1;
+    if (ps->clip_children && g_render_list) {
+        UI_RectI clip = p->rect;
+        if (saved_clip >= 0) clip = UI_Intersect_Rect(clip, g_render_list->clip_rects[saved_clip]);
+        
+        if (clip.w <= 0 || clip.h <= 0) {
+            children_visible = 0;  // Nothing of an empty clip is visible
+            s->panels_culled += p->subtree_size > 1 ? p->subtree_size - 1 : 0;
+        } else if (UI_Grow_Array((void **)&g_render_list->clip_rects, &g_render_list->clip_capacity,
+                                 g_render_list->clip_count + 1, sizeof(UI_RectI), UI_MAX_CLIP_RECTS)) {
+            g_render_list->clip_rects[g_render_list->clip_count] = clip;
+            g_emit_clip = g_render_list->clip_count++;
+            g_emit_visible = g_emit_has_visible ? UI_Intersect_Rect(g_emit_visible, clip) : clip;
+            g_emit_has_visible = 1;
+        }
+    }
+    
+    // Emit children
+    if (children_visible) {
+        for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling)
+            UI_Emit_Panels(s, c);
+    }
+    
+    // Pop
+    g_emit_clip = saved_clip;
+    g_emit_visible = saved_visible;
+    g_emit_has_visible = saved_has_visible;
+    
+    if (group_idx >= 0) {
+        UI_End_Cache_Group(group_idx);
+        g_emit_in_cache_group = 0;
+    }
+}
+
+
+// .............................................................................................
+uint32_t
+UI_Render_List_Hash(const UI_Render_List *list)
+{
+	uint32_t h = 2166136261u;
+	h = UI_Hash_Bytes(h, &list->rect_count, sizeof(int));
+	h = UI_Hash_Bytes(h, &list->text_count, sizeof(int));
+	
+	for (int i = 0; i < list->rect_count; i++) {
+		const UI_Rectangle *r = &list->rectangles[i];
+		int fields[5] = { r->left, r->top, r->right, r->bottom, (int)r->color };
+		h = UI_Hash_Bytes(h, fields, sizeof(fields));
+	}
+	
+	for (int i = 0; i < list->text_count; i++) {
+		const UI_Text *t = &list->texts[i];
+		h = UI_Hash_Text_Primitive(h, t, t->clip >= 0 ? &list->clip_rects[t->clip] : 0);
+	}
+	
+	return h;
+}
+
+
+// .............................................................................................
+static int
+UI_Text_Primitive_Equal(const UI_Render_List *list_a, const UI_Text *a, 
+                        const UI_Render_List *list_b, const UI_Text *b)
+{
+	if ((a->clip >= 0) != (b->clip >= 0)) return 0;
+	if (a->clip >= 0 && memcmp(&list_a->clip_rects[a->clip], &list_b->clip_rects[b->clip], sizeof(UI_RectI))) return 0;
+	if (a->x != b->x || a->y != b->y || a->w != b->w || a->h != b->h) return 0;
+	if (a->color != b->color || a->font_size != b->font_size || a->font_style != b->font_style) return 0;
+	if (a->align_h != b->align_h || a->align_v != b->align_v) return 0;
+	if (a->text_length != b->text_length) return 0;
+	return memcmp(a->text, b->text, a->text_length) == 0;
+}
+
+
+// .............................................................................................
+// UI_Render_List_Diff - Compare two render lists primitive by primitive
+//
+// Primitives are matched by index, so this only works when both lists have the same
+// rectangle and text counts (the common case: a static tree where only colors or strings
+// change). The dirty rect is the union of old and new bounds of every changed primitive,
+// so redrawing everything inside it reproduces the new frame exactly.
+int
+UI_Render_List_Diff(const UI_Render_List *prev, const UI_Render_List *cur, UI_RectI *out_dirty)
+{
+	UI_RectI dirty = {0, 0, 0, 0};
+	int has_dirty = 0;
+	
+	if (prev->rect_count != cur->rect_count || prev->text_count != cur->text_count) {
+		if (out_dirty) *out_dirty = dirty;
+		return UI_RENDER_LIST_CHANGED;
+	}
+	
+	for (int i = 0; i < cur->rect_count; i++) {
+		const UI_Rectangle *a = &prev->rectangles[i];
+		const UI_Rectangle *b = &cur->rectangles[i];
+		if (a->left == b->left && a->top == b->top && a->right == b->right && 
+		    a->bottom == b->bottom && a->color == b->color) continue;
+		
+		UI_Union_Rect(&dirty, &has_dirty, a->left, a->top, a->right, a->bottom);
+		UI_Union_Rect(&dirty, &has_dirty, b->left, b->top, b->right, b->bottom);
+	}
+	
+	for (int i = 0; i < cur->text_count; i++) {
+		const UI_Text *a = &prev->texts[i];
+		const UI_Text *b = &cur->texts[i];
+		if (UI_Text_Primitive_Equal(prev, a, cur, b)) continue;
+		
+		UI_Union_Rect(&dirty, &has_dirty, a->x, a->y, a->x + a->w, a->y + a->h);
+		UI_Union_Rect(&dirty, &has_dirty, b->x, b->y, b->x + b->w, b->y + b->h);
+	}
+	
+	if (out_dirty) *out_dirty = dirty;
+	if (!has_dirty) return UI_RENDER_LIST_UNCHANGED;
+	return UI_RENDER_LIST_PARTIAL;
 }
 
 
 // .............................................................................................
-// UI_LayoutColumn - Layout children vertically using flexbox-inspired algorithm
-// Same as UI_LayoutRow but in vertical direction (children fill full width, height varies)
-static void UI_Layout_Column(UI_State *s, int panel_idx)
+void
+UI_Context_Free(UI_Context *ui)
 {
-    UI_Panel *p = &s->panels[panel_idx];
-
-    // Content box inside padding
-    int x0 = p->rect.x + p->style.pad_l;
-    int y0 = p->rect.y + p->style.pad_t;
-    int cw = p->rect.w - (p->style.pad_l + p->style.pad_r);
-    int ch = p->rect.h - (p->style.pad_t + p->style.pad_b);
-    if (cw < 0) cw = 0;
-    if (ch < 0) ch = 0;
-
-    // First pass: count children, sum fixed heights, sum flex grow
-    int child_count = 0;
-    int fixed_sum = 0;
-    float grow_sum = 0.0f;
-
-    for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling)
-    {
-        child_count++;
-
-        UI_Panel *child = &s->panels[c];
-        int h = (child->style.pref_h >= 0) ? child->style.pref_h : 0;
-        fixed_sum += h;
-
-        if (child->style.flex_grow > 0.0f)
-            grow_sum += child->style.flex_grow;
-    }
-
-    int gaps_total = (child_count > 1) ? (p->style.gap * (child_count - 1)) : 0;
-
-    int remaining = ch - fixed_sum - gaps_total;
-    if (remaining < 0) remaining = 0;
-
-    // Second pass: assign child rects
-    int cursor_y = y0;
-
-    for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling)
-    {
-        UI_Panel *child = &s->panels[c];
+	UI_State_Free(&ui->state);
+	for (int i = 0; i < ui->retained_block_count; i++) {
+		UI_FREE(ui->retained_blocks[i].panels);
+		UI_FREE(ui->retained_blocks[i].strings);
+	}
+	UI_MEMSET(ui->retained_blocks, 0, sizeof(ui->retained_blocks));
+	ui->retained_block_count = 0;
+	UI_FREE(ui->hit_grid.cell_start);
+	UI_FREE(ui->hit_grid.cell_fill);
+	UI_FREE(ui->hit_grid.entries);
+	UI_MEMSET(&ui->hit_grid, 0, sizeof(UI_Hit_Grid));
+	UI_FREE(ui->size_overrides);
+	ui->size_overrides = 0;
+	ui->size_override_count = 0;
+	ui->size_override_capacity = 0;
+	UI_FREE(ui->list_states);
+	ui->list_states = 0;
+	ui->list_state_count = 0;
+	ui->list_state_capacity = 0;
+	
+	for (int i = 0; i < ui->interned.capacity; i++) {
+		UI_FREE((void *)ui->interned.slots[i].str);
+	}
+	UI_FREE(ui->interned.slots);
+	UI_MEMSET(&ui->interned, 0, sizeof(UI_String_Table));
+#ifdef UI_COMPACT_CONTEXT
+	ui->last_button_clicked = 0;
+	UI_FREE(ui->id_table);
+	ui->id_table = 0;
+	ui->id_table_capacity = 0;
+	UI_FREE(ui->intrinsic_cache);
+	ui->intrinsic_cache = 0;
+	ui->intrinsic_capacity = 0;
+	UI_FREE(ui->frame_stats.samples);
+	ui->frame_stats.samples = 0;
+	ui->frame_stats.next = 0;
+	ui->frame_stats.count = 0;
+#endif
+}
 
-        int h = (child->style.pref_h >= 0) ? child->style.pref_h : 0;
 
-        if (child->style.flex_grow > 0.0f && grow_sum > 0.0f)
-        {
-            float t = child->style.flex_grow / grow_sum;
-            int flex_h = (int)(t * (float)remaining);
-            h += flex_h;
-        }
+// .............................................................................................
+// UI_Intern_String - Stable copy of str, shared by every call with an equal string
+// (kept until UI_Context_Free, so meant for a bounded set such as widget labels)
+const char *
+UI_Intern_String(UI_Context *ui, const char *str)
+{
+	if (!str) return 0;
+	
+	UI_String_Table *t = &ui->interned;
+	if ((t->count + 1) * 2 > t->capacity) {
+		int capacity = t->capacity ? t->capacity * 2 : UI_STRING_TABLE_INITIAL;
+		UI_String_Slot *slots = (UI_String_Slot *)UI_CALLOC(capacity, sizeof(UI_String_Slot));
+		if (!slots) return 0;
+		
+		for (int i = 0; i < t->capacity; i++) {
+			if (!t->slots[i].str) continue;
+			uint32_t slot = t->slots[i].hash & (capacity - 1);
+			while (slots[slot].str) slot = (slot + 1) & (capacity - 1);
+			slots[slot] = t->slots[i];
+		}
+		UI_FREE(t->slots);
+		t->slots = slots;
+		t->capacity = capacity;
+	}
+	
+	uint32_t hash = (uint32_t)UI_Hash_String_Seeded(5381, str);
+	uint32_t mask = (uint32_t)t->capacity - 1;
+	uint32_t slot = hash & mask;
+	while (t->slots[slot].str) {
+		if (t->slots[slot].hash == hash && strcmp(t->slots[slot].str, str) == 0) return t->slots[slot].str;
+		slot = (slot + 1) & mask;
+	}
+	
+	size_t size = strlen(str) + 1;
+	char *copy = (char *)UI_MALLOC(size);
+	if (!copy) return 0;
+	memcpy(copy, str, size);
+	t->slots[slot].hash = hash;
+	t->slots[slot].str = copy;
+	t->count++;
+	t->string_bytes += size;
+	return copy;
+}
 
-        // V1: child fills width
-        child->rect.x = x0;
-        child->rect.y = cursor_y;
-        child->rect.w = cw;
-        child->rect.h = h;
 
-        cursor_y += h + p->style.gap;
-    }
+// .............................................................................................
+size_t
+UI_Render_List_Bytes(const UI_Render_List *list)
+{
+	return (size_t)list->rect_capacity * sizeof(UI_Rectangle) +
+	       (size_t)list->text_capacity * sizeof(UI_Text) +
+	       (size_t)list->cache_group_capacity * sizeof(UI_Cache_Group) +
+	       (size_t)list->clip_capacity * sizeof(UI_RectI) +
+	       (size_t)list->strings.reserved;
 }
 
 
 // .............................................................................................
-static void UI_Layout_Panel_Tree(UI_State *s, int panel_idx)
+const char *
+UI_Memory_Subsystem_Name(int subsystem)
 {
-    UI_Panel *p = &s->panels[panel_idx];
+	static const char *names[UI_MEMORY_COUNT] = {
+		"context", "panels", "frame_arena", "layout_cache", "ids", "input",
+		"hit_grid", "retained", "persistent", "intrinsic", "strings", "frame_stats"
+	};
+	return (subsystem >= 0 && subsystem < UI_MEMORY_COUNT) ? names[subsystem] : "unknown";
+}
 
-    // Layout this container's children based on its direction
-    if (p->first_child != -1)
-    {
-        if (p->style.direction == 0)      UI_Layout_Row(s, panel_idx);
-		else if (p->style.direction == 1) UI_Layout_Column(s, panel_idx);
 
-        // Recurse into children
-        for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling)
-            UI_Layout_Panel_Tree(s, c);
-    }
+// .............................................................................................
+// Bytes held per subsystem now; inline tables count with their subsystem, so the totals
+// include sizeof(UI_Context). Peaks are raised here and at every UI_Begin_Frame (storage
+// only grows between frees, so sampling then catches every growth).
+static void
+UI_Memory_Current(UI_Context *ui, size_t *current)
+{
+	const UI_State *s = &ui->state;
+	const UI_Layout_Cache *cache = &s->layout_cache;
+	UI_MEMSET(current, 0, UI_MEMORY_COUNT * sizeof(size_t));
+	
+	current[UI_MEMORY_PANELS] = (size_t)s->panel_capacity * (sizeof(UI_Panel) + sizeof(UI_Style) + sizeof(UI_Panel_Cold) + sizeof(UI_Panel_Content)) +
+	                            (size_t)s->id_index_capacity * sizeof(UI_Panel_Index_Slot);
+	current[UI_MEMORY_FRAME_ARENA] = (size_t)s->frame_arena.reserved;
+	current[UI_MEMORY_LAYOUT_CACHE] = (size_t)cache->prev_capacity * (sizeof(UI_RectI) + sizeof(uint32_t)) +
+	                                  (size_t)cache->prev_index_capacity * sizeof(UI_Panel_Index_Slot);
+	current[UI_MEMORY_INPUT] = sizeof(ui->input) + sizeof(ui->input_prev) + sizeof(ui->input_queue);
+	current[UI_MEMORY_HIT_GRID] = (size_t)(ui->hit_grid.cell_capacity + ui->hit_grid.fill_capacity +
+	                                       ui->hit_grid.entry_capacity) * sizeof(int);
+	
+	current[UI_MEMORY_RETAINED] = sizeof(ui->retained_blocks);
+	for (int i = 0; i < ui->retained_block_count; i++) {
+		const UI_Retained_Block *b = &ui->retained_blocks[i];
+		current[UI_MEMORY_RETAINED] += (size_t)b->panel_capacity * sizeof(UI_Retained_Panel) + (size_t)b->string_capacity;
+	}
+	
+	current[UI_MEMORY_PERSISTENT] = (size_t)ui->size_override_capacity * sizeof(UI_Size_Override) +
+	                                (size_t)ui->list_state_capacity * sizeof(UI_List_State);
+	current[UI_MEMORY_STRINGS] = (size_t)ui->interned.capacity * sizeof(UI_String_Slot) + ui->interned.string_bytes;
+#ifdef UI_COMPACT_CONTEXT
+	current[UI_MEMORY_IDS] = (size_t)ui->id_table_capacity * sizeof(UI_Id_Slot);
+	current[UI_MEMORY_INTRINSIC] = (size_t)ui->intrinsic_capacity * sizeof(UI_Intrinsic_Slot);
+	current[UI_MEMORY_FRAME_STATS] = ui->frame_stats.samples ? UI_FRAME_STATS_HISTORY * sizeof(UI_Frame_Sample) : 0;
+	size_t inline_bytes = 0;
+#else
+	current[UI_MEMORY_IDS] = sizeof(ui->id_table);
+	current[UI_MEMORY_INTRINSIC] = sizeof(ui->intrinsic_cache);
+	current[UI_MEMORY_FRAME_STATS] = sizeof(ui->frame_stats.samples);
+	size_t inline_bytes = sizeof(ui->id_table) + sizeof(ui->intrinsic_cache) + sizeof(ui->frame_stats.samples);
+#endif
+	inline_bytes += sizeof(ui->input) + sizeof(ui->input_prev) + sizeof(ui->input_queue) + sizeof(ui->retained_blocks);
+	current[UI_MEMORY_CONTEXT] = sizeof(UI_Context) - inline_bytes;
 }
 
 
 // .............................................................................................
-static void UI_Emit_Panels(UI_State *s, int panel_idx)
+static void
+UI_Memory_Sample(UI_Context *ui, size_t *current)
 {
-    UI_Panel *p = &s->panels[panel_idx];
+	UI_Memory_Current(ui, current);
+	size_t total = 0;
+	for (int i = 0; i < UI_MEMORY_COUNT; i++) {
+		if (current[i] > ui->memory_peak[i]) ui->memory_peak[i] = current[i];
+		total += current[i];
+	}
+	if (total > ui->memory_total_peak) ui->memory_total_peak = total;
+}
 
-    // Emit this panel's rect (skip if transparent and is label)
-    if (!(p->is_label && p->style.color == 0x00000000)) {
-        UI_Add_Rectangle(
-            p->rect.x,
-            p->rect.y,
-            p->rect.x + p->rect.w,
-            p->rect.y + p->rect.h,
-            p->style.color
-        );
-    }
-    
-    // Emit label text if this is a label panel
-    if (p->is_label && p->label_text[0] != 0) {
-        UI_Add_Text(
-            p->rect.x,
-            p->rect.y,
-            p->rect.w,
-            p->rect.h,
-            p->label_text,
-            p->label_color,
-            14,
-            p->label_font_style,
-            UI_ALIGN_START,
-            UI_ALIGN_CENTER
-        );
-    }
 
-    // Emit children
-    for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling)
-        UI_Emit_Panels(s, c);
+// .............................................................................................
+// UI_Memory_Stats_Get - Current and peak bytes per subsystem (render lists are separate,
+// see UI_Render_List_Bytes)
+void
+UI_Memory_Stats_Get(UI_Context *ui, UI_Memory_Stats *out)
+{
+	UI_Memory_Sample(ui, out->current);
+	out->total = 0;
+	for (int i = 0; i < UI_MEMORY_COUNT; i++) {
+		out->peak[i] = ui->memory_peak[i];
+		out->total += out->current[i];
+	}
+	out->total_peak = ui->memory_total_peak;
 }
 
 
@@ -399,6 +2062,27 @@ UI_Begin_Frame(UI_Context *ui, UI_Render_List *out_list, int w, int h)
 }
 
 
+// .............................................................................................
+// Empty the panel tree (keeps panel storage and arena pages)
+static void
+UI_State_Reset(UI_State *s)
+{
+	s->panel_count = 0;
+	s->panels_hashed = 0;
+	s->panels_sized = 0;
+	UI_Arena_Reset(&s->frame_arena);
+	
+	// Clear the panel ID index by generation (full clear only when the counter wraps)
+	s->id_index_generation++;
+	if (s->id_index_generation == 0) {
+		if (s->id_index) {
+			UI_MEMSET(s->id_index, 0, s->id_index_capacity * sizeof(UI_Panel_Index_Slot));
+		}
+		s->id_index_generation = 1;
+	}
+}
+
+
 // .............................................................................................
 void
 UI_Begin_Frame_With_Time(UI_Context *ui, UI_Render_List *out_list, int w, int h, float delta_time_ms)
@@ -411,19 +2095,43 @@ UI_Begin_Frame_With_Time(UI_Context *ui, UI_Render_List *out_list, int w, int h,
 	ui->frame_number++;
 	ui->delta_time_ms = delta_time_ms;
 	
+	size_t memory[UI_MEMORY_COUNT];
+	UI_Memory_Sample(ui, memory);
+	
 	ui->screen_w = w;
 	ui->screen_h = h;
 
-	// reset UI state for this frame
-    ui->state.panel_count = 0;
+	// reset UI state for this frame (keeps panel storage and arena pages)
+	UI_State_Reset(&ui->state);
 
-	// reset render list for this frame
-	memset(out_list, 0, sizeof(UI_Render_List));
+	// reset render list for this frame (keeps its storage)
+	UI_Render_List_Reset(out_list);
 	g_render_list = out_list;
 	
 	// Reset immediate-mode state
 	ui->parent_stack_count = 0;
+	ui->id_scope_count = 0;
+	ui->cached_depth = 0;
+	ui->cached_overflow = 0;
+	ui->list_depth = 0;
+	g_emit_clip = -1;
+	g_emit_has_visible = 0;
+	ui->retained_hits = 0;
+	ui->retained_misses = 0;
+	ui->intrinsic_hits = 0;
+	ui->intrinsic_misses = 0;
+	
+	// Clear the ID dedup table by generation (full clear only when the counter wraps)
 	ui->used_id_count = 0;
+	ui->id_generation++;
+	if (ui->id_generation == 0) {
+#ifdef UI_COMPACT_CONTEXT
+		if (ui->id_table) UI_MEMSET(ui->id_table, 0, ui->id_table_capacity * sizeof(UI_Id_Slot));
+#else
+		UI_MEMSET(ui->id_table, 0, sizeof(ui->id_table));
+#endif
+		ui->id_generation = 1;
+	}
 	
 	// Process input for new frame
 	UI_Input_NewFrame(ui);
@@ -435,7 +2143,7 @@ UI_Panel_Style
 UI_Default_Panel_Style(void)
 {
 	UI_Panel_Style s;
-	memset(&s, 0, sizeof(UI_Panel_Style));
+	UI_MEMSET(&s, 0, sizeof(UI_Panel_Style));
 	s.color = 0xFF222222;
 	s.min_w = 0;
 	s.max_w = INT32_MAX;
@@ -516,18 +2224,214 @@ UI_Begin_Panel_Ex(UI_Context *ctx, const char *id_str, UI_Panel_Style *style)
 	
 	if (ctx->parent_stack_count > 0) {
 		int panel_idx = ctx->parent_stack[ctx->parent_stack_count - 1];
-		ctx->state.panels[panel_idx].style = *style;
+		ctx->state.styles[panel_idx] = *style;
 	}
 }
 
 
 // .............................................................................................
+// Its descendants are final once a panel closes, so the subtree size (and with the layout
+// cache enabled, its hash) is computed here while the style is still in cache. A subtree
+// that is not [idx, panel_count) (unbalanced End calls, exhausted parent stack) is not
+// counted, so layout falls back to its own pass.
 void
 UI_End_Panel(UI_Context *ctx)
 {
 	if (ctx->parent_stack_count > 0) {
-		ctx->parent_stack_count--;
+		int idx = ctx->parent_stack[--ctx->parent_stack_count];
+		UI_State *s = &ctx->state;
+		if (s->layout_cache.disabled) {
+			if (UI_Layout_Size_Panel(s, idx) == s->panel_count - idx) s->panels_sized++;
+		} else if (UI_Layout_Hash_Panel(s, idx) == s->panel_count - idx) {
+			s->panels_hashed++;
+			s->panels_sized++;
+		}
+	}
+}
+
+
+// .............................................................................................
+// Find a retained block by scope ID, or take a free/least recently used slot for it
+static int
+UI_Retained_Block_Slot(UI_Context *ui, UI_Id id, int *found)
+{
+	*found = 0;
+	int oldest = -1;
+	for (int i = 0; i < ui->retained_block_count; i++) {
+		if (ui->retained_blocks[i].id == id) {
+			*found = 1;
+			return i;
+		}
+		if (oldest < 0 || ui->retained_blocks[i].last_used_frame < ui->retained_blocks[oldest].last_used_frame) {
+			oldest = i;
+		}
+	}
+	
+	if (ui->retained_block_count < UI_MAX_RETAINED_BLOCKS) return ui->retained_block_count++;
+	if (ui->retained_blocks[oldest].last_used_frame == ui->frame_number) return -1;  // All in use this frame
+	return oldest;
+}
+
+
+// .............................................................................................
+// Append a recorded block under the current parent (same panels, IDs, styles and labels)
+static void
+UI_Retained_Block_Replay(UI_Context *ui, UI_Retained_Block *block)
+{
+	UI_State *s = &ui->state;
+	int parent_idx = (ui->parent_stack_count > 0) ? ui->parent_stack[ui->parent_stack_count - 1] : -1;
+	int base = s->panel_count;
+	
+	for (int k = 0; k < block->panel_count; k++) {
+		const UI_Retained_Panel *src = &block->panels[k];
+		int idx = UI_New_Panel(s, src->id);
+		if (idx < 0) return;
+		
+		s->styles[idx] = src->style;
+		s->cold[idx] = src->cold;
+		s->cold[idx].label_text = (src->label_offset >= 0) ? block->strings + src->label_offset : 0;
+		
+		// Pre-order: parents precede children, so links rebuild in the recorded order
+		if (src->parent_rel >= 0) {
+			UI_Add_Child(s, base + src->parent_rel, idx);
+		} else if (parent_idx >= 0) {
+			UI_Add_Child(s, parent_idx, idx);
+		} else {
+			s->panels[idx].rect.x = 0;
+			s->panels[idx].rect.y = 0;
+			s->panels[idx].rect.w = ui->screen_w;
+			s->panels[idx].rect.h = ui->screen_h;
+		}
+	}
+	
+	// No UI_End_Panel ran for these: hash (or size) them as one complete range
+	int disabled = s->layout_cache.disabled;
+	for (int i = s->panel_count - 1; i >= base; i--) {
+		if (disabled) UI_Layout_Size_Panel(s, i);
+		else UI_Layout_Hash_Panel(s, i);
+	}
+	if (!disabled) s->panels_hashed += s->panel_count - base;
+	s->panels_sized += s->panel_count - base;
+}
+
+
+// .............................................................................................
+// Copy the panels built this frame in [start, panel_count) into the block
+static int
+UI_Retained_Block_Record(UI_Context *ui, UI_Retained_Block *block, int start)
+{
+	UI_State *s = &ui->state;
+	int count = s->panel_count - start;
+	
+	block->valid = 0;
+	block->panel_count = 0;
+	block->string_size = 0;
+	if (!UI_Grow_Array((void **)&block->panels, &block->panel_capacity, count,
+	                   sizeof(UI_Retained_Panel), 16)) return 0;
+	
+	for (int k = 0; k < count; k++) {
+		int idx = start + k;
+		UI_Retained_Panel *dst = &block->panels[k];
+		int parent = s->panels[idx].parent;
+		
+		dst->id = s->panels[idx].id;
+		dst->parent_rel = (parent >= start) ? parent - start : -1;
+		dst->style = s->styles[idx];
+		dst->cold = s->cold[idx];
+		dst->cold.label_text = 0;
+		dst->cold.graph_values = 0;  // Frame arena data, graphs replay empty
+		dst->cold.graph_count = 0;
+		dst->label_offset = -1;
+		
+		const char *text = s->cold[idx].label_text;
+		if (text) {
+			int len = (int)strlen(text);
+			if (!UI_Grow_Array((void **)&block->strings, &block->string_capacity,
+			                   block->string_size + len + 1, 1, 256)) return 0;
+			memcpy(block->strings + block->string_size, text, len + 1);
+			dst->label_offset = block->string_size;
+			block->string_size += len + 1;
+		}
+	}
+	
+	block->panel_count = count;
+	block->valid = 1;
+	return 1;
+}
+
+
+// .............................................................................................
+// UI_Begin_Cached - Start a retained block (see ui.h)
+//
+// The block's panels are recorded at UI_End_Cached. Later frames with the same id and
+// version re-create those panels directly (no widget calls, no text measurement), and the
+// layout cache then usually reuses their rects as well.
+int
+UI_Begin_Cached(UI_Context *ui, const char *id, uint32_t version)
+{
+	// The block ID is deduplicated like a widget ID (repeated names get distinct blocks)
+	// and becomes the ID scope of the contents
+	UI_Id block_id = UI_Generate_Id(ui, id);
+	
+	// Past the nesting limit nothing is pushed (contents are built uncached, unscoped);
+	// the matching UI_End_Cached only drops the overflow count
+	assert(ui->cached_depth < UI_MAX_CACHED_DEPTH && "UI_Begin_Cached nested too deeply");
+	if (ui->cached_depth >= UI_MAX_CACHED_DEPTH) {
+		ui->cached_overflow++;
+		return 1;
+	}
+	
+	UI_Cached_Scope *scope = &ui->cached_stack[ui->cached_depth++];
+	scope->start = ui->state.panel_count;
+	scope->parent_depth = ui->parent_stack_count;
+	scope->replaying = 0;
+	
+	assert(ui->id_scope_count < UI_MAX_ID_SCOPE_DEPTH && "ID scope stack overflow");
+	scope->pushed_id = ui->id_scope_count < UI_MAX_ID_SCOPE_DEPTH;
+	if (scope->pushed_id) ui->id_scope_stack[ui->id_scope_count++] = block_id;
+	
+	int found;
+	scope->block = UI_Retained_Block_Slot(ui, block_id, &found);
+	if (scope->block < 0) return 1;
+	
+	UI_Retained_Block *block = &ui->retained_blocks[scope->block];
+	if (found && block->valid && block->version == version && block->last_used_frame != ui->frame_number) {
+		block->last_used_frame = ui->frame_number;
+		UI_Retained_Block_Replay(ui, block);
+		scope->replaying = 1;
+		ui->retained_hits++;
+		return 0;
+	}
+	
+	block->id = block_id;
+	block->version = version;
+	block->valid = 0;
+	block->last_used_frame = ui->frame_number;
+	ui->retained_misses++;
+	return 1;
+}
+
+
+// .............................................................................................
+void
+UI_End_Cached(UI_Context *ui)
+{
+	if (ui->cached_overflow > 0) {
+		ui->cached_overflow--;
+		return;
+	}
+	
+	assert(ui->cached_depth > 0 && "UI_End_Cached without matching UI_Begin_Cached");
+	if (ui->cached_depth == 0) return;
+	
+	// Undo exactly what UI_Begin_Cached pushed
+	UI_Cached_Scope *scope = &ui->cached_stack[--ui->cached_depth];
+	assert(ui->parent_stack_count == scope->parent_depth && "Unbalanced panels inside cached block");
+	
+	if (!scope->replaying && scope->block >= 0 && ui->parent_stack_count == scope->parent_depth) {
+		UI_Retained_Block_Record(ui, &ui->retained_blocks[scope->block], scope->start);
 	}
+	if (scope->pushed_id) UI_Pop_Id(ui);
 }
 
 
@@ -537,7 +2441,7 @@ UI_Panel_Set_Color(UI_Context *ui, uint32_t color)
 {
 	if (ui->parent_stack_count == 0) return;
 	int idx = ui->parent_stack[ui->parent_stack_count - 1];
-	ui->state.panels[idx].style.color = color;
+	ui->state.styles[idx].color = color;
 }
 
 
@@ -547,8 +2451,8 @@ UI_Panel_Set_Size(UI_Context *ui, int width, int height)
 {
 	if (ui->parent_stack_count == 0) return;
 	int idx = ui->parent_stack[ui->parent_stack_count - 1];
-	ui->state.panels[idx].style.pref_w = width;
-	ui->state.panels[idx].style.pref_h = height;
+	ui->state.styles[idx].pref_w = width;
+	ui->state.styles[idx].pref_h = height;
 }
 
 
@@ -558,11 +2462,11 @@ UI_Panel_Set_Padding(UI_Context *ui, int l, int t, int r, int b)
 {
 	if (ui->parent_stack_count == 0) return;
 	int idx = ui->parent_stack[ui->parent_stack_count - 1];
-	UI_Panel *p = &ui->state.panels[idx];
-	p->style.pad_l = l;
-	p->style.pad_t = t;
-	p->style.pad_r = r;
-	p->style.pad_b = b;
+	UI_Style *style = &ui->state.styles[idx];
+	style->pad_l = l;
+	style->pad_t = t;
+	style->pad_r = r;
+	style->pad_b = b;
 }
 
 
@@ -572,7 +2476,7 @@ UI_Panel_Set_Direction(UI_Context *ui, UI_Direction dir)
 {
 	if (ui->parent_stack_count == 0) return;
 	int idx = ui->parent_stack[ui->parent_stack_count - 1];
-	ui->state.panels[idx].style.direction = dir;
+	ui->state.styles[idx].direction = dir;
 }
 
 
@@ -582,7 +2486,7 @@ UI_Panel_Set_Gap(UI_Context *ui, int gap)
 {
 	if (ui->parent_stack_count == 0) return;
 	int idx = ui->parent_stack[ui->parent_stack_count - 1];
-	ui->state.panels[idx].style.gap = gap;
+	ui->state.styles[idx].gap = gap;
 }
 
 
@@ -592,7 +2496,62 @@ UI_Panel_Set_Grow(UI_Context *ui, float grow)
 {
 	if (ui->parent_stack_count == 0) return;
 	int idx = ui->parent_stack[ui->parent_stack_count - 1];
-	ui->state.panels[idx].style.flex_grow = grow;
+	ui->state.styles[idx].flex_grow = grow;
+}
+
+
+// .............................................................................................
+void
+UI_Panel_Set_Shrink(UI_Context *ui, float shrink)
+{
+	if (ui->parent_stack_count == 0) return;
+	int idx = ui->parent_stack[ui->parent_stack_count - 1];
+	ui->state.styles[idx].flex_shrink = shrink;
+}
+
+
+// .............................................................................................
+void
+UI_Panel_Set_Basis(UI_Context *ui, int basis)
+{
+	if (ui->parent_stack_count == 0) return;
+	int idx = ui->parent_stack[ui->parent_stack_count - 1];
+	ui->state.styles[idx].flex_basis = basis;
+}
+
+
+// .............................................................................................
+void
+UI_Panel_Set_Min_Size(UI_Context *ui, int min_w, int min_h)
+{
+	if (ui->parent_stack_count == 0) return;
+	int idx = ui->parent_stack[ui->parent_stack_count - 1];
+	ui->state.styles[idx].min_w = min_w;
+	ui->state.styles[idx].min_h = min_h;
+}
+
+
+// .............................................................................................
+void
+UI_Panel_Set_Max_Size(UI_Context *ui, int max_w, int max_h)
+{
+	if (ui->parent_stack_count == 0) return;
+	int idx = ui->parent_stack[ui->parent_stack_count - 1];
+	ui->state.styles[idx].max_w = max_w;
+	ui->state.styles[idx].max_h = max_h;
+}
+
+
+// .............................................................................................
+// UI_Panel_Set_Content_Size - Intrinsic size used when pref_w/pref_h is AUTO (-1); a
+// panel without one is sized from its children
+void
+UI_Panel_Set_Content_Size(UI_Context *ui, int w, int h)
+{
+	if (ui->parent_stack_count == 0) return;
+	int idx = ui->parent_stack[ui->parent_stack_count - 1];
+	ui->state.styles[idx].content_w = w;
+	ui->state.styles[idx].content_h = h;
 }
 
 
@@ -610,8 +2569,31 @@ UI_Panel_Set_Resizable(UI_Context *ui, int resizable, int hitbox_padding)
 {
 	if (ui->parent_stack_count == 0) return;
 	int idx = ui->parent_stack[ui->parent_stack_count - 1];
-	ui->state.panels[idx].style.resizable = resizable;
-	ui->state.panels[idx].style.resize_hitbox_padding = hitbox_padding;
+	ui->state.styles[idx].resizable = resizable;
+	ui->state.styles[idx].resize_hitbox_padding = hitbox_padding;
+}
+
+
+// .............................................................................................
+// UI_Panel_Set_Cache_Bitmap - Let the renderer draw this panel's subtree from a cached
+// offscreen bitmap. Only worth it for panels whose content rarely changes.
+void
+UI_Panel_Set_Cache_Bitmap(UI_Context *ui, int enabled)
+{
+	if (ui->parent_stack_count == 0) return;
+	int idx = ui->parent_stack[ui->parent_stack_count - 1];
+	ui->state.styles[idx].cache_bitmap = enabled;
+}
+
+
+// .............................................................................................
+// UI_Panel_Set_Clip - Clip descendants to this panel's rect when drawing and hit testing
+void
+UI_Panel_Set_Clip(UI_Context *ui, int enabled)
+{
+	if (ui->parent_stack_count == 0) return;
+	int idx = ui->parent_stack[ui->parent_stack_count - 1];
+	ui->state.styles[idx].clip_children = enabled;
 }
 
 
@@ -642,15 +2624,17 @@ UI_BeginPanel(UI_Context *ui, const char *id, int direction, int w, int h,
 
 
 // .............................................................................................
-void
-UI_Panel_Resizable(UI_Context *ui, const char *id, int direction, 
-                   int default_w, int default_h, int padding, int gap, uint32_t color)
+// Size the current panel from its divider override, else from the defaults (-2 = flex-grow)
+static void
+UI_Apply_Resizable_Size(UI_Context *ui, int default_w, int default_h)
 {
-	UI_Begin_Panel(ui, id);
-	UI_Panel_Set_Direction(ui, (UI_Direction)direction);
+	if (ui->parent_stack_count == 0) return;
+	
+	int panel_idx = ui->parent_stack[ui->parent_stack_count - 1];
 	
 	// Check for size overrides (from user resizing via dividers)
-	UI_Id panel_id = UI_HashString(id);
+	// Keyed by the panel's generated ID (includes ID scope and dedup)
+	UI_Id panel_id = ui->state.panels[panel_idx].id;
 	int w = UI_Get_Size_Override_W(ui, panel_id);
 	int h = UI_Get_Size_Override_H(ui, panel_id);
 	
@@ -680,6 +2664,19 @@ UI_Panel_Resizable(UI_Context *ui, const char *id, int direction,
 		// At least one dimension is fixed
 		UI_Panel_Set_Size(ui, w, h);
 	}
+}
+
+
+// .............................................................................................
+void
+UI_Panel_Resizable(UI_Context *ui, const char *id, int direction, 
+                   int default_w, int default_h, int padding, int gap, uint32_t color)
+{
+	UI_Begin_Panel(ui, id);
+	UI_Panel_Set_Direction(ui, (UI_Direction)direction);
+	if (ui->parent_stack_count == 0) return;
+	
+	UI_Apply_Resizable_Size(ui, default_w, default_h);
 	
 	if (padding > 0) {
 		UI_Panel_Set_Padding_Uniform(ui, padding);
@@ -689,8 +2686,50 @@ UI_Panel_Resizable(UI_Context *ui, const char *id, int direction,
 		UI_Panel_Set_Gap(ui, gap);
 	}
 	
-	if (color != 0) {
-		UI_Panel_Set_Color(ui, color);
+	if (color != 0) {
+		UI_Panel_Set_Color(ui, color);
+	}
+}
+
+
+// .............................................................................................
+// UI_Build_Static - Build a compile-time layout (see UI_Static_Panel), calling fill for slots
+void
+UI_Build_Static(UI_Context *ui, const UI_Static_Panel *layout, int count, UI_Static_Fill_Func *fill, void *user)
+{
+	int open = 0;  // Panels of this layout still on the parent stack
+	
+	for (int i = 0; i < count; i++) {
+		const UI_Static_Panel *e = &layout[i];
+		
+		while (open > e->depth) {
+			UI_End_Panel(ui);
+			open--;
+		}
+		
+		if (e->kind == UI_STATIC_SLOT) {
+			if (fill) fill(ui, e->slot, user);
+			continue;
+		}
+		
+		int depth = ui->parent_stack_count;
+		UI_Begin_Panel_With_Id(ui, UI_Claim_Id(ui, e->id), e->name);
+		if (ui->parent_stack_count == depth) {
+			// Panel or parent stack exhausted: skip the entry's whole subtree
+			while (i + 1 < count && layout[i + 1].depth > e->depth) i++;
+			continue;
+		}
+		
+		ui->state.styles[ui->parent_stack[depth]] = e->style;
+		if (e->kind == UI_STATIC_RESIZABLE) UI_Apply_Resizable_Size(ui, e->default_w, e->default_h);
+		
+		if (e->kind == UI_STATIC_DIVIDER) UI_End_Panel(ui);
+		else open++;
+	}
+	
+	while (open > 0) {
+		UI_End_Panel(ui);
+		open--;
 	}
 }
 
@@ -719,37 +2758,120 @@ UI_Divider_Ex(UI_Context *ui, const char *id, int orientation, uint32_t color, i
 	
 	UI_Panel_Set_Color(ui, color);
 	UI_Panel_Set_Resizable(ui, 1, hitbox_padding);
+	UI_Panel_Set_Shrink(ui, 0.0f);  // Stays a 1px line when its siblings overflow
 	
 	UI_End_Panel(ui);
 }
 
 
+#ifdef UI_COMPACT_CONTEXT
+// .............................................................................................
+// Compact contexts keep about two slots per panel: double the heap cache (re-slotting the
+// kept sizes) while it is smaller than that, up to UI_INTRINSIC_CACHE_CAPACITY
+static void
+UI_Intrinsic_Cache_Reserve(UI_Context *ui)
+{
+	int wanted = ui->state.panel_count * 2;
+	if (wanted > UI_INTRINSIC_CACHE_CAPACITY) wanted = UI_INTRINSIC_CACHE_CAPACITY;
+	if (ui->intrinsic_capacity >= wanted && ui->intrinsic_cache) return;
+	
+	int capacity = ui->intrinsic_capacity ? ui->intrinsic_capacity : UI_INTRINSIC_CACHE_INITIAL;
+	while (capacity < wanted) capacity *= 2;
+	UI_Intrinsic_Slot *cache = (UI_Intrinsic_Slot *)UI_CALLOC(capacity, sizeof(UI_Intrinsic_Slot));
+	if (!cache) return;
+	
+	for (int i = 0; i < ui->intrinsic_capacity; i++) {
+		const UI_Intrinsic_Slot *old = &ui->intrinsic_cache[i];
+		if (old->id) cache[(uint32_t)old->id & (capacity - 1)] = *old;
+	}
+	UI_FREE(ui->intrinsic_cache);
+	ui->intrinsic_cache = cache;
+	ui->intrinsic_capacity = capacity;
+}
+#endif
+
+
+// .............................................................................................
+// Text size of label panel id, measured only when the slot holds another panel or the
+// content (text, font size, font style) differs in length or hash from last time. The
+// hash is FNV-1a rather than the ID's djb2, which equal-length edits collide trivially.
+static UI_RectI
+UI_Intrinsic_Text_Size(UI_Context *ui, UI_Id id, const char *text, int font_size, int font_style)
+{
+	int length = (int)strlen(text);
+	uint32_t content_hash = UI_Hash_Bytes(2166136261u, text, length);
+	content_hash = (content_hash ^ (uint32_t)font_size) * 16777619u;
+	content_hash = (content_hash ^ (uint32_t)font_style) * 16777619u;
+	
+#ifdef UI_COMPACT_CONTEXT
+	UI_Intrinsic_Cache_Reserve(ui);
+	if (!ui->intrinsic_cache) {
+		ui->intrinsic_misses++;
+		return ui->measure_text(text, font_size, font_style);
+	}
+	uint32_t mask = (uint32_t)ui->intrinsic_capacity - 1;
+#else
+	uint32_t mask = UI_INTRINSIC_CACHE_CAPACITY - 1;
+#endif
+	UI_Intrinsic_Slot *slot = &ui->intrinsic_cache[(uint32_t)id & mask];
+	UI_RectI size = {0, 0, slot->w, slot->h};
+	if (slot->id == id && slot->length == length && slot->content_hash == content_hash) {
+		ui->intrinsic_hits++;
+		return size;
+	}
+	
+	size = ui->measure_text(text, font_size, font_style);
+	slot->id = id;
+	slot->content_hash = content_hash;
+	slot->length = length;
+	slot->w = size.w;
+	slot->h = size.h;
+	ui->intrinsic_misses++;
+	return size;
+}
+
+
+// .............................................................................................
+void
+UI_Intrinsic_Cache_Clear(UI_Context *ui)
+{
+#ifdef UI_COMPACT_CONTEXT
+	if (ui->intrinsic_cache) UI_MEMSET(ui->intrinsic_cache, 0, ui->intrinsic_capacity * sizeof(UI_Intrinsic_Slot));
+#else
+	UI_MEMSET(ui->intrinsic_cache, 0, sizeof(ui->intrinsic_cache));
+#endif
+}
+
+
 // .............................................................................................
 void
 UI_Label(UI_Context *ui, const char *text, uint32_t color)
+{
+	UI_Label_Styled(ui, text, color, 0);
+}
+
+
+// .............................................................................................
+void
+UI_Label_Styled(UI_Context *ui, const char *text, uint32_t color, int font_style)
 {
 	if (!text || !ui->measure_text) return;
 	
-	UI_RectI text_size = ui->measure_text(text, 14);
-	
 	UI_Begin_Panel(ui, text);
-	UI_Panel_Set_Size(ui, text_size.w + 2, text_size.h);
 	
 	if (ui->parent_stack_count > 0) {
 		int panel_idx = ui->parent_stack[ui->parent_stack_count - 1];
-		UI_Panel *panel = &ui->state.panels[panel_idx];
+		UI_Panel_Cold *cold = &ui->state.cold[panel_idx];
 		
-		panel->style.color = 0x00000000;
-		panel->is_label = 1;
-		panel->label_color = color;
-		panel->label_font_style = 0;  // Default font
+		// AUTO-sized from the text (measured only when the text or font changes)
+		UI_RectI text_size = UI_Intrinsic_Text_Size(ui, ui->state.panels[panel_idx].id, text, 14, font_style);
+		UI_Panel_Set_Content_Size(ui, text_size.w + 2, text_size.h);
 		
-		int len = 0;
-		while (len < MAX_UI_TEXT_LENGTH - 1 && text[len]) {
-			panel->label_text[len] = text[len];
-			len++;
-		}
-		panel->label_text[len] = 0;
+		ui->state.styles[panel_idx].color = 0x00000000;
+		cold->is_label = 1;
+		cold->label_color = color;
+		cold->label_font_style = font_style;
+		cold->label_text = UI_Frame_String(&ui->state, text);
 	}
 	
 	UI_End_Panel(ui);
@@ -771,34 +2893,82 @@ UI_Label_Monospace(UI_Context *ui, const char *text, uint32_t color)
 	int approx_height = 20;              // 14pt ~ 19-20px tall
 	
 	UI_Begin_Panel(ui, text);
-	UI_Panel_Set_Size(ui, approx_width + 2, approx_height);
+	UI_Panel_Set_Content_Size(ui, approx_width + 2, approx_height);
 	
 	if (ui->parent_stack_count > 0) {
 		int panel_idx = ui->parent_stack[ui->parent_stack_count - 1];
-		UI_Panel *panel = &ui->state.panels[panel_idx];
+		UI_Panel_Cold *cold = &ui->state.cold[panel_idx];
 		
-		panel->style.color = 0x00000000;
-		panel->is_label = 1;
-		panel->label_color = color;
-		panel->label_font_style = 1;  // Monospace
+		ui->state.styles[panel_idx].color = 0x00000000;
+		cold->is_label = 1;
+		cold->label_color = color;
+		cold->label_font_style = UI_FONT_MONOSPACE;
+		cold->label_text = UI_Frame_String(&ui->state, text);
+	}
+	
+	UI_End_Panel(ui);
+}
+
+
+// .............................................................................................
+// UI_Graph - Bar graph, one bar per value left to right, 0..max_value mapped to the
+// panel height (48px tall, full width in a column). Values are copied into the frame arena.
+void
+UI_Graph(UI_Context *ui, const char *id, const float *values, int count, float max_value, uint32_t color)
+{
+	UI_Begin_Panel(ui, id);
+	UI_Panel_Set_Size(ui, -1, 48);
+	
+	if (ui->parent_stack_count > 0 && values && count > 0) {
+		int panel_idx = ui->parent_stack[ui->parent_stack_count - 1];
+		UI_Panel_Cold *cold = &ui->state.cold[panel_idx];
 		
-		int len = 0;
-		while (len < MAX_UI_TEXT_LENGTH - 1 && text[len]) {
-			panel->label_text[len] = text[len];
-			len++;
+		float *copy = (float *)UI_Arena_Alloc(&ui->state.frame_arena, count * (int)sizeof(float));
+		if (copy) {
+			memcpy(copy, values, count * sizeof(float));
+			cold->graph_values = copy;
+			cold->graph_count = count;
+			cold->graph_max = max_value;
+			cold->graph_color = color;
 		}
-		panel->label_text[len] = 0;
 	}
 	
 	UI_End_Panel(ui);
 }
 
 
+// .............................................................................................
+// UI_Key_Get / UI_Key_Set - One key of a UI_Key_State (bitset in a compact context)
+static inline int
+UI_Key_Get(const UI_Key_State keys, int vk_code)
+{
+#ifdef UI_COMPACT_CONTEXT
+	return (int)((keys[vk_code >> 5] >> (vk_code & 31)) & 1u);
+#else
+	return keys[vk_code];
+#endif
+}
+
+
+// .............................................................................................
+static inline void
+UI_Key_Set(UI_Key_State keys, int vk_code, int down)
+{
+#ifdef UI_COMPACT_CONTEXT
+	uint32_t bit = 1u << (vk_code & 31);
+	if (down) keys[vk_code >> 5] |= bit;
+	else keys[vk_code >> 5] &= ~bit;
+#else
+	keys[vk_code] = down;
+#endif
+}
+
+
 // .............................................................................................
 void
 UI_Input_Init(UI_Input *input)
 {
-	memset(input, 0, sizeof(UI_Input));
+	UI_MEMSET(input, 0, sizeof(UI_Input));
 	input->mouse_x = 0;
 	input->mouse_y = 0;
 	input->mouse_x_prev = 0;
@@ -807,10 +2977,111 @@ UI_Input_Init(UI_Input *input)
 }
 
 
+// .............................................................................................
+uint32_t
+UI_Input_Queue_Pending(UI_Input_Queue *q)
+{
+	return q->head - q->tail;
+}
+
+
+// .............................................................................................
+// Producer side: the slot is written before head publishes it
+static void
+UI_Input_Queue_Push(UI_Input_Queue *q, int type, int a, int b, float wheel)
+{
+	uint32_t head = q->head;
+	if (head - q->tail >= UI_INPUT_QUEUE_CAPACITY) {
+		q->dropped++;
+		return;
+	}
+	
+	UI_Input_Event *e = &q->events[head & (UI_INPUT_QUEUE_CAPACITY - 1)];
+	e->type = type;
+	e->a = a;
+	e->b = b;
+	e->wheel = wheel;
+	e->time = q->clock ? q->clock() : 0;
+	
+	UI_MEMORY_BARRIER();
+	q->head = head + 1;
+}
+
+
+// .............................................................................................
+// Consumer side: apply queued events to ui->input, oldest first
+// Stops before a second transition of one button or key (it belongs to the next frame)
+// and when the character buffer is full.
+static void
+UI_Input_Drain(UI_Context *ui)
+{
+	UI_Input_Queue *q = &ui->input_queue;
+	UI_Input *in = &ui->input;
+	
+	uint32_t tail = q->tail;
+	uint32_t head = q->head;
+	UI_MEMORY_BARRIER();
+	
+	q->oldest_age_ms = 0.0f;
+	if (head != tail && q->clock && q->clock_frequency > 0) {
+		int64_t oldest = q->events[tail & (UI_INPUT_QUEUE_CAPACITY - 1)].time;
+		q->oldest_age_ms = (float)((double)(q->clock() - oldest) * 1000.0 / (double)q->clock_frequency);
+	}
+	
+	// Transitions already applied this frame (one bit per button / key)
+	uint32_t buttons_changed = 0;
+	uint32_t keys_changed[UI_KEY_COUNT / 32] = {0};
+	
+	int drained = 0;
+	int moves = 0;
+	while (tail != head) {
+		const UI_Input_Event *e = &q->events[tail & (UI_INPUT_QUEUE_CAPACITY - 1)];
+		
+		if (e->type == UI_INPUT_EVENT_MOUSE_MOVE) {
+			in->mouse_x = e->a;
+			in->mouse_y = e->b;
+			moves++;
+		} else if (e->type == UI_INPUT_EVENT_MOUSE_BUTTON) {
+			if (in->mouse_down[e->a] != e->b) {
+				uint32_t bit = 1u << e->a;
+				if (buttons_changed & bit) break;
+				buttons_changed |= bit;
+				in->mouse_down[e->a] = e->b;
+			}
+		} else if (e->type == UI_INPUT_EVENT_MOUSE_WHEEL) {
+			in->mouse_wheel_delta += e->wheel;
+		} else if (e->type == UI_INPUT_EVENT_KEY) {
+			if (UI_Key_Get(in->key_down, e->a) != e->b) {
+				uint32_t bit = 1u << (e->a & 31);
+				if (keys_changed[e->a >> 5] & bit) break;
+				keys_changed[e->a >> 5] |= bit;
+				UI_Key_Set(in->key_down, e->a, e->b);
+			}
+		} else if (e->type == UI_INPUT_EVENT_CHAR) {
+			if (in->char_count >= UI_MAX_CHAR_BUFFER) break;
+			in->char_buffer[in->char_count++] = (char)e->a;
+			in->last_char = (char)e->a;
+		}
+		
+		drained++;
+		tail++;
+	}
+	
+	UI_MEMORY_BARRIER();
+	q->tail = tail;
+	
+	q->drained = drained;
+	q->moves_coalesced = (moves > 1) ? moves - 1 : 0;
+	q->deferred = (int)(head - tail);
+}
+
+
 // .............................................................................................
 void
 UI_Input_NewFrame(UI_Context *ui)
 {
+	UI_Input_Drain(ui);
+	
 	// Calculate mouse delta (input_prev set by UI_Input_EndFrame from last frame)
 	ui->input.mouse_dx = ui->input.mouse_x - ui->input_prev.mouse_x;
 	ui->input.mouse_dy = ui->input.mouse_y - ui->input_prev.mouse_y;
@@ -821,19 +3092,22 @@ UI_Input_NewFrame(UI_Context *ui)
 		ui->input.mouse_released[i] = !ui->input.mouse_down[i] && ui->input_prev.mouse_down[i];
 	}
 	
+#ifdef UI_COMPACT_CONTEXT
+	for (int i = 0; i < UI_KEY_COUNT / 32; i++) {
+		ui->input.key_pressed[i] = ui->input.key_down[i] & ~ui->input_prev.key_down[i];
+		ui->input.key_released[i] = ~ui->input.key_down[i] & ui->input_prev.key_down[i];
+	}
+#else
 	for (int i = 0; i < UI_KEY_COUNT; i++) {
 		ui->input.key_pressed[i] = ui->input.key_down[i] && !ui->input_prev.key_down[i];
 		ui->input.key_released[i] = !ui->input.key_down[i] && ui->input_prev.key_down[i];
 	}
-	
-	// Clear per-frame data
-	ui->input.char_count = 0;
-	ui->input.mouse_wheel_delta = 0.0f;
+#endif
 	
 	// Update modifier keys (VK_CONTROL, VK_SHIFT, VK_MENU are Windows constants)
-	ui->input.ctrl = ui->input.key_down[0x11];   // VK_CONTROL
-	ui->input.shift = ui->input.key_down[0x10];  // VK_SHIFT
-	ui->input.alt = ui->input.key_down[0x12];    // VK_MENU (Alt)
+	ui->input.ctrl = UI_Key_Get(ui->input.key_down, 0x11);   // VK_CONTROL
+	ui->input.shift = UI_Key_Get(ui->input.key_down, 0x10);  // VK_SHIFT
+	ui->input.alt = UI_Key_Get(ui->input.key_down, 0x12);    // VK_MENU (Alt)
 }
 
 
@@ -843,6 +3117,10 @@ UI_Input_EndFrame(UI_Context *ui)
 {
 	// Copy current state to previous for next frame's edge detection
 	ui->input_prev = ui->input;
+	
+	// Clear per-frame data (accumulated by the message handlers until the next frame)
+	ui->input.char_count = 0;
+	ui->input.mouse_wheel_delta = 0.0f;
 }
 
 
@@ -850,8 +3128,7 @@ UI_Input_EndFrame(UI_Context *ui)
 void
 UI_Input_ProcessMouseMove(UI_Context *ui, int x, int y)
 {
-	ui->input.mouse_x = x;
-	ui->input.mouse_y = y;
+	UI_Input_Queue_Push(&ui->input_queue, UI_INPUT_EVENT_MOUSE_MOVE, x, y, 0.0f);
 }
 
 
@@ -860,7 +3137,7 @@ void
 UI_Input_ProcessMouseButton(UI_Context *ui, UI_Mouse_Button button, int down)
 {
 	if (button >= 0 && button < UI_MOUSE_BUTTON_COUNT) {
-		ui->input.mouse_down[button] = down;
+		UI_Input_Queue_Push(&ui->input_queue, UI_INPUT_EVENT_MOUSE_BUTTON, button, down ? 1 : 0, 0.0f);
 	}
 }
 
@@ -869,7 +3146,7 @@ UI_Input_ProcessMouseButton(UI_Context *ui, UI_Mouse_Button button, int down)
 void
 UI_Input_ProcessMouseWheel(UI_Context *ui, float delta)
 {
-	ui->input.mouse_wheel_delta += delta;
+	UI_Input_Queue_Push(&ui->input_queue, UI_INPUT_EVENT_MOUSE_WHEEL, 0, 0, delta);
 }
 
 
@@ -878,7 +3155,7 @@ void
 UI_Input_ProcessKey(UI_Context *ui, int vk_code, int down)
 {
 	if (vk_code >= 0 && vk_code < UI_KEY_COUNT) {
-		ui->input.key_down[vk_code] = down;
+		UI_Input_Queue_Push(&ui->input_queue, UI_INPUT_EVENT_KEY, vk_code, down ? 1 : 0, 0.0f);
 	}
 }
 
@@ -887,10 +3164,7 @@ UI_Input_ProcessKey(UI_Context *ui, int vk_code, int down)
 void
 UI_Input_ProcessChar(UI_Context *ui, char c)
 {
-	if (ui->input.char_count < UI_MAX_CHAR_BUFFER) {
-		ui->input.char_buffer[ui->input.char_count++] = c;
-	}
-	ui->input.last_char = c;
+	UI_Input_Queue_Push(&ui->input_queue, UI_INPUT_EVENT_CHAR, (unsigned char)c, 0, 0.0f);
 }
 
 
@@ -925,178 +3199,738 @@ UI_Is_Mouse_Released(UI_Context *ui, UI_Mouse_Button button)
 
 
 // .............................................................................................
-int
-UI_Is_Key_Down(UI_Context *ui, int vk_code)
+int
+UI_Is_Key_Down(UI_Context *ui, int vk_code)
+{
+	return (vk_code >= 0 && vk_code < UI_KEY_COUNT) 
+	       ? UI_Key_Get(ui->input.key_down, vk_code) 
+	       : 0;
+}
+
+
+// .............................................................................................
+int
+UI_Is_Key_Pressed(UI_Context *ui, int vk_code)
+{
+	return (vk_code >= 0 && vk_code < UI_KEY_COUNT) 
+	       ? UI_Key_Get(ui->input.key_pressed, vk_code) 
+	       : 0;
+}
+
+
+// .............................................................................................
+int
+UI_Is_Key_Released(UI_Context *ui, int vk_code)
+{
+	return (vk_code >= 0 && vk_code < UI_KEY_COUNT) 
+	       ? UI_Key_Get(ui->input.key_released, vk_code) 
+	       : 0;
+}
+
+
+// .............................................................................................
+void
+UI_Get_Mouse_Pos(UI_Context *ui, int *out_x, int *out_y)
+{
+	if (out_x) *out_x = ui->input.mouse_x;
+	if (out_y) *out_y = ui->input.mouse_y;
+}
+
+
+// .............................................................................................
+void
+UI_Get_Mouse_Delta(UI_Context *ui, int *out_dx, int *out_dy)
+{
+	if (out_dx) *out_dx = ui->input.mouse_dx;
+	if (out_dy) *out_dy = ui->input.mouse_dy;
+}
+
+
+// .............................................................................................
+float
+UI_Get_Mouse_Wheel(UI_Context *ui)
+{
+	return ui->input.mouse_wheel_delta;
+}
+
+
+// .............................................................................................
+int
+UI_Is_Point_In_Rect(int x, int y, UI_RectI rect)
+{
+	return x >= rect.x && x < (rect.x + rect.w) &&
+	       y >= rect.y && y < (rect.y + rect.h);
+}
+
+
+// .............................................................................................
+int
+UI_Is_Hovered(UI_Context *ui, UI_RectI rect)
+{
+	return UI_Is_Point_In_Rect(ui->input.mouse_x, ui->input.mouse_y, rect);
+}
+
+
+// .............................................................................................
+int
+UI_Is_Widget_Hot(UI_Context *ui, UI_Id id)
+{
+	return ui->interaction.hot_widget == id;
+}
+
+
+// .............................................................................................
+int
+UI_Is_Widget_Active(UI_Context *ui, UI_Id id)
+{
+	return ui->interaction.active_widget == id;
+}
+
+
+// .............................................................................................
+void
+UI_Set_Hot_Widget(UI_Context *ui, UI_Id id)
+{
+	ui->interaction.hot_widget = id;
+}
+
+
+// .............................................................................................
+void
+UI_Set_Active_Widget(UI_Context *ui, UI_Id id)
+{
+	ui->interaction.active_widget = id;
+}
+
+
+// .............................................................................................
+void
+UI_Clear_Active_Widget(UI_Context *ui)
+{
+	ui->interaction.active_widget = 0;
+}
+
+
+// .............................................................................................
+// Find the slot for panel_id (matching, or the empty slot where it would go)
+static UI_Size_Override*
+UI_Size_Override_Slot(UI_Size_Override *table, int capacity, UI_Id panel_id)
+{
+	uint32_t mask = (uint32_t)capacity - 1;
+	uint32_t slot = UI_Id_Mix(panel_id, 0) & mask;
+	while (table[slot].panel_id != 0 && table[slot].panel_id != panel_id) {
+		slot = (slot + 1) & mask;
+	}
+	return &table[slot];
+}
+
+
+// .............................................................................................
+static const UI_Size_Override*
+UI_Find_Size_Override(UI_Context *ui, UI_Id panel_id)
+{
+	if (!ui->size_overrides || panel_id == 0) return 0;
+	UI_Size_Override *o = UI_Size_Override_Slot(ui->size_overrides, ui->size_override_capacity, panel_id);
+	return o->panel_id == panel_id ? o : 0;
+}
+
+
+// .............................................................................................
+// Double the override table (load factor stays <= 1/2, so probing always terminates)
+static int
+UI_Grow_Size_Overrides(UI_Context *ui)
+{
+	int capacity = ui->size_override_capacity ? ui->size_override_capacity * 2 : UI_MAX_SIZE_OVERRIDES;
+	UI_Size_Override *table = (UI_Size_Override *)UI_CALLOC(capacity, sizeof(UI_Size_Override));
+	if (!table) return 0;
+	
+	for (int i = 0; i < ui->size_override_capacity; i++) {
+		UI_Size_Override *o = &ui->size_overrides[i];
+		if (o->panel_id != 0) *UI_Size_Override_Slot(table, capacity, o->panel_id) = *o;
+	}
+	
+	UI_FREE(ui->size_overrides);
+	ui->size_overrides = table;
+	ui->size_override_capacity = capacity;
+	return 1;
+}
+
+
+// .............................................................................................
+void
+UI_Set_Size_Override(UI_Context *ui, UI_Id panel_id, int pref_w, int pref_h)
+{
+	if (panel_id == 0) return;
+	
+	if ((ui->size_override_count + 1) * 2 > ui->size_override_capacity) {
+		if (!UI_Grow_Size_Overrides(ui)) return;
+	}
+	
+	UI_Size_Override *o = UI_Size_Override_Slot(ui->size_overrides, ui->size_override_capacity, panel_id);
+	if (o->panel_id == panel_id) {
+		// Update existing override
+		if (pref_w >= 0) o->pref_w = pref_w;
+		if (pref_h >= 0) o->pref_h = pref_h;
+		return;
+	}
+	
+	// Add new override
+	o->panel_id = panel_id;
+	o->pref_w = pref_w;
+	o->pref_h = pref_h;
+	ui->size_override_count++;
+}
+
+
+// .............................................................................................
+int
+UI_Get_Size_Override_W(UI_Context *ui, UI_Id panel_id)
+{
+	const UI_Size_Override *o = UI_Find_Size_Override(ui, panel_id);
+	return o ? o->pref_w : -1;  // -1 = no override found
+}
+
+
+// .............................................................................................
+int
+UI_Get_Size_Override_H(UI_Context *ui, UI_Id panel_id)
+{
+	const UI_Size_Override *o = UI_Find_Size_Override(ui, panel_id);
+	return o ? o->pref_h : -1;  // -1 = no override found
+}
+
+
+// .............................................................................................
+// Find the slot for list_id (matching, or the empty slot where it would go)
+static UI_List_State*
+UI_List_State_Slot(UI_List_State *table, int capacity, UI_Id list_id)
 {
-	return (vk_code >= 0 && vk_code < UI_KEY_COUNT) 
-	       ? ui->input.key_down[vk_code] 
-	       : 0;
+	uint32_t mask = (uint32_t)capacity - 1;
+	uint32_t slot = UI_Id_Mix(list_id, 0) & mask;
+	while (table[slot].list_id != 0 && table[slot].list_id != list_id) {
+		slot = (slot + 1) & mask;
+	}
+	return &table[slot];
 }
 
 
 // .............................................................................................
-int
-UI_Is_Key_Pressed(UI_Context *ui, int vk_code)
+// Find or add the scroll state of a list (table doubles at load factor 1/2)
+static UI_List_State*
+UI_Get_List_State(UI_Context *ui, UI_Id list_id)
 {
-	return (vk_code >= 0 && vk_code < UI_KEY_COUNT) 
-	       ? ui->input.key_pressed[vk_code] 
-	       : 0;
+	if (list_id == 0) return 0;
+	
+	if ((ui->list_state_count + 1) * 2 > ui->list_state_capacity) {
+		int capacity = ui->list_state_capacity ? ui->list_state_capacity * 2 : UI_MAX_LIST_STATES;
+		UI_List_State *table = (UI_List_State *)UI_CALLOC(capacity, sizeof(UI_List_State));
+		if (!table) return 0;
+		
+		for (int i = 0; i < ui->list_state_capacity; i++) {
+			UI_List_State *st = &ui->list_states[i];
+			if (st->list_id != 0) *UI_List_State_Slot(table, capacity, st->list_id) = *st;
+		}
+		
+		UI_FREE(ui->list_states);
+		ui->list_states = table;
+		ui->list_state_capacity = capacity;
+	}
+	
+	UI_List_State *st = UI_List_State_Slot(ui->list_states, ui->list_state_capacity, list_id);
+	if (st->list_id != list_id) {
+		UI_MEMSET(st, 0, sizeof(UI_List_State));
+		st->list_id = list_id;
+		ui->list_state_count++;
+	}
+	return st;
 }
 
 
 // .............................................................................................
-int
-UI_Is_Key_Released(UI_Context *ui, int vk_code)
+// Snapshot writer: counts every byte, copies only while it fits
+struct UI_Snapshot_Writer {
+	unsigned char *dst;
+	int capacity;
+	int size;
+	int section_count;
+	int section_start;   // Offset of the open section's header
+};
+
+
+// .............................................................................................
+static void
+UI_Snapshot_Put(UI_Snapshot_Writer *w, const void *src, int size)
 {
-	return (vk_code >= 0 && vk_code < UI_KEY_COUNT) 
-	       ? ui->input.key_released[vk_code] 
-	       : 0;
+	if (w->dst && size > 0 && w->size + size <= w->capacity) memcpy(w->dst + w->size, src, size);
+	w->size += size;
 }
 
 
 // .............................................................................................
-void
-UI_Get_Mouse_Pos(UI_Context *ui, int *out_x, int *out_y)
+static void
+UI_Snapshot_Begin_Section(UI_Snapshot_Writer *w, uint32_t tag)
 {
-	if (out_x) *out_x = ui->input.mouse_x;
-	if (out_y) *out_y = ui->input.mouse_y;
+	UI_Snapshot_Section section = { tag, 0 };
+	w->section_start = w->size;
+	UI_Snapshot_Put(w, &section, sizeof(section));
 }
 
 
 // .............................................................................................
-void
-UI_Get_Mouse_Delta(UI_Context *ui, int *out_dx, int *out_dy)
+// Patch the section size, pad to 8 bytes
+static void
+UI_Snapshot_End_Section(UI_Snapshot_Writer *w)
 {
-	if (out_dx) *out_dx = ui->input.mouse_dx;
-	if (out_dy) *out_dy = ui->input.mouse_dy;
+	uint32_t payload = (uint32_t)(w->size - w->section_start - (int)sizeof(UI_Snapshot_Section));
+	if (w->dst && w->size <= w->capacity) {
+		memcpy(w->dst + w->section_start + offsetof(UI_Snapshot_Section, size), &payload, sizeof(payload));
+	}
+	
+	static const unsigned char zeros[8] = {0};
+	UI_Snapshot_Put(w, zeros, (8 - (w->size & 7)) & 7);
+	w->section_count++;
 }
 
 
 // .............................................................................................
-float
-UI_Get_Mouse_Wheel(UI_Context *ui)
+int
+UI_Snapshot_Write(UI_Context *ui, uint32_t app_key, const UI_Snapshot_Measure *measures,
+                  const char *const *measure_texts, int measure_count, void *dst, int capacity)
 {
-	return ui->input.mouse_wheel_delta;
+	UI_State *s = &ui->state;
+	UI_Snapshot_Writer w;
+	UI_MEMSET(&w, 0, sizeof(w));
+	w.dst = (unsigned char *)dst;
+	w.capacity = dst ? capacity : 0;
+	
+	UI_Snapshot_Header header;
+	UI_MEMSET(&header, 0, sizeof(header));
+	UI_Snapshot_Put(&w, &header, sizeof(header));
+	
+	// Panels: links, rects and hashes, styles, label metadata, then the label strings
+	int32_t count = s->panel_count;
+	int32_t strings_size = 0;
+	for (int i = 0; i < count; i++) {
+		if (s->cold[i].label_text) strings_size += (int32_t)strlen(s->cold[i].label_text) + 1;
+	}
+	UI_Snapshot_Begin_Section(&w, UI_SNAPSHOT_PANELS);
+	UI_Snapshot_Put(&w, &count, sizeof(count));
+	UI_Snapshot_Put(&w, &strings_size, sizeof(strings_size));
+	UI_Snapshot_Put(&w, s->panels, count * (int)sizeof(UI_Panel));
+	UI_Snapshot_Put(&w, s->styles, count * (int)sizeof(UI_Style));
+	int32_t offset = 0;
+	for (int i = 0; i < count; i++) {
+		const UI_Panel_Cold *cold = &s->cold[i];
+		UI_Snapshot_Label label = { cold->label_text ? offset : -1, cold->label_color,
+		                            cold->label_font_style, cold->is_label };
+		UI_Snapshot_Put(&w, &label, sizeof(label));
+		if (cold->label_text) offset += (int32_t)strlen(cold->label_text) + 1;
+	}
+	for (int i = 0; i < count; i++) {
+		const char *text = s->cold[i].label_text;
+		if (text) UI_Snapshot_Put(&w, text, (int)strlen(text) + 1);
+	}
+	UI_Snapshot_End_Section(&w);
+	
+	// Size overrides (occupied table slots)
+	int32_t override_count = ui->size_override_count;
+	UI_Snapshot_Begin_Section(&w, UI_SNAPSHOT_OVERRIDES);
+	UI_Snapshot_Put(&w, &override_count, sizeof(override_count));
+	for (int i = 0; i < ui->size_override_capacity; i++) {
+		if (ui->size_overrides[i].panel_id != 0) {
+			UI_Snapshot_Put(&w, &ui->size_overrides[i], sizeof(UI_Size_Override));
+		}
+	}
+	UI_Snapshot_End_Section(&w);
+	
+	// List scroll offsets and viewports (the first frame builds the same rows)
+	int32_t list_count = ui->list_state_count;
+	UI_Snapshot_Begin_Section(&w, UI_SNAPSHOT_LISTS);
+	UI_Snapshot_Put(&w, &list_count, sizeof(list_count));
+	for (int i = 0; i < ui->list_state_capacity; i++) {
+		if (ui->list_states[i].list_id != 0) {
+			UI_Snapshot_Put(&w, &ui->list_states[i], sizeof(UI_List_State));
+		}
+	}
+	UI_Snapshot_End_Section(&w);
+	
+	if (measures && measure_count > 0) {
+		int32_t n = measure_count;
+		int32_t measure_strings_size = 0;
+		for (int i = 0; i < measure_count; i++) measure_strings_size += measures[i].length + 1;
+		UI_Snapshot_Begin_Section(&w, UI_SNAPSHOT_MEASURES);
+		UI_Snapshot_Put(&w, &n, sizeof(n));
+		UI_Snapshot_Put(&w, &measure_strings_size, sizeof(measure_strings_size));
+		UI_Snapshot_Put(&w, measures, measure_count * (int)sizeof(UI_Snapshot_Measure));
+		static const char nul = 0;
+		for (int i = 0; i < measure_count; i++) {
+			UI_Snapshot_Put(&w, measure_texts[i], measures[i].length);
+			UI_Snapshot_Put(&w, &nul, 1);
+		}
+		UI_Snapshot_End_Section(&w);
+	}
+	
+	if (!w.dst || w.size > w.capacity) return w.size;
+	
+	header.magic = UI_SNAPSHOT_MAGIC;
+	header.version = UI_SNAPSHOT_VERSION;
+	header.size = (uint32_t)w.size;
+	header.section_count = (uint32_t)w.section_count;
+	header.panel_size = sizeof(UI_Panel);
+	header.style_size = sizeof(UI_Style);
+	header.app_key = app_key;
+	header.screen_w = ui->screen_w;
+	header.screen_h = ui->screen_h;
+	memcpy(w.dst, &header, sizeof(header));
+	return w.size;
 }
 
 
 // .............................................................................................
 int
-UI_Is_Point_In_Rect(int x, int y, UI_RectI rect)
+UI_Snapshot_Validate(const void *data, int size)
 {
-	return x >= rect.x && x < (rect.x + rect.w) &&
-	       y >= rect.y && y < (rect.y + rect.h);
+	if (!data || size < (int)sizeof(UI_Snapshot_Header)) return 0;
+	
+	UI_Snapshot_Header header;
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != UI_SNAPSHOT_MAGIC || header.version != UI_SNAPSHOT_VERSION) return 0;
+	if (header.panel_size != sizeof(UI_Panel) || header.style_size != sizeof(UI_Style)) return 0;
+	if (header.size > (uint32_t)size || header.size < sizeof(UI_Snapshot_Header)) return 0;
+	
+	// Every section header and payload inside the snapshot
+	const unsigned char *bytes = (const unsigned char *)data;
+	uint32_t at = sizeof(UI_Snapshot_Header);
+	for (uint32_t i = 0; i < header.section_count; i++) {
+		if (header.size - at < sizeof(UI_Snapshot_Section)) return 0;
+		UI_Snapshot_Section section;
+		memcpy(&section, bytes + at, sizeof(section));
+		at += sizeof(UI_Snapshot_Section);
+		if (section.size > header.size - at) return 0;
+		at += section.size;
+		at += (8 - (at & 7)) & 7;
+		if (at > header.size) return 0;
+	}
+	return 1;
 }
 
 
 // .............................................................................................
-int
-UI_Is_Hovered(UI_Context *ui, UI_RectI rect)
+// Sections are only walked after UI_Snapshot_Validate accepted the snapshot
+const void*
+UI_Snapshot_Find(const void *data, int size, uint32_t tag, int *out_size)
 {
-	return UI_Is_Point_In_Rect(ui->input.mouse_x, ui->input.mouse_y, rect);
+	*out_size = 0;
+	if (!UI_Snapshot_Validate(data, size)) return 0;
+	
+	const unsigned char *bytes = (const unsigned char *)data;
+	UI_Snapshot_Header header;
+	memcpy(&header, data, sizeof(header));
+	
+	uint32_t at = sizeof(UI_Snapshot_Header);
+	for (uint32_t i = 0; i < header.section_count; i++) {
+		UI_Snapshot_Section section;
+		memcpy(&section, bytes + at, sizeof(section));
+		at += sizeof(UI_Snapshot_Section);
+		if (section.tag == tag) {
+			*out_size = (int)section.size;
+			return bytes + at;
+		}
+		at += section.size;
+		at += (8 - (at & 7)) & 7;
+	}
+	return 0;
 }
 
 
 // .............................................................................................
-int
-UI_Is_Widget_Hot(UI_Context *ui, UI_Id id)
+// Links must point forward in pre-order (parent before child), so a bad file cannot make
+// the layout walk loop or index out of range
+static int
+UI_Snapshot_Links_Valid(const UI_Panel *p, int i, int count)
 {
-	return ui->interaction.hot_widget == id;
+	if (i == 0 ? p->parent != -1 : (p->parent < 0 || p->parent >= i)) return 0;
+	
+	int links[3] = { p->first_child, p->last_child, p->next_sibling };
+	for (int k = 0; k < 3; k++) {
+		if (links[k] != -1 && (links[k] <= i || links[k] >= count)) return 0;
+	}
+	return 1;
 }
 
 
 // .............................................................................................
-int
-UI_Is_Widget_Active(UI_Context *ui, UI_Id id)
+// Panel section checks (sizes, strings, links); nothing is applied
+static int
+UI_Snapshot_Panels_Valid(const unsigned char *payload, int section_size)
 {
-	return ui->interaction.active_widget == id;
+	if (!payload || section_size < 8) return 0;
+	
+	int32_t count, strings_size;
+	memcpy(&count, payload, sizeof(count));
+	memcpy(&strings_size, payload + 4, sizeof(strings_size));
+	if (count < 0 || strings_size < 0) return 0;
+	
+	int64_t per_panel = sizeof(UI_Panel) + sizeof(UI_Style) + sizeof(UI_Snapshot_Label);
+	if (8 + (int64_t)count * per_panel + strings_size != section_size) return 0;
+	
+	const unsigned char *panels = payload + 8;
+	const unsigned char *styles = panels + count * sizeof(UI_Panel);
+	const unsigned char *labels = styles + count * sizeof(UI_Style);
+	const char *strings = (const char *)(labels + count * sizeof(UI_Snapshot_Label));
+	if (strings_size > 0 && strings[strings_size - 1] != 0) return 0;
+	
+	for (int i = 0; i < count; i++) {
+		UI_Panel p;
+		UI_Snapshot_Label label;
+		memcpy(&p, panels + i * sizeof(UI_Panel), sizeof(p));
+		memcpy(&label, labels + i * sizeof(UI_Snapshot_Label), sizeof(label));
+		if (!UI_Snapshot_Links_Valid(&p, i, count)) return 0;
+		if (label.text_offset < -1 || label.text_offset >= strings_size) return 0;
+	}
+	return 1;
 }
 
 
 // .............................................................................................
-void
-UI_Set_Hot_Widget(UI_Context *ui, UI_Id id)
+// Fixed-size record section ("count, record[]"): absent is fine, present must be exact
+static int
+UI_Snapshot_Records_Valid(const void *data, int size, uint32_t tag, int record_size)
 {
-	ui->interaction.hot_widget = id;
+	int section_size;
+	const unsigned char *payload = (const unsigned char *)UI_Snapshot_Find(data, size, tag, &section_size);
+	if (!payload) return 1;
+	if (section_size < 4) return 0;
+	
+	int32_t count;
+	memcpy(&count, payload, sizeof(count));
+	return count >= 0 && 4 + (int64_t)count * record_size == (int64_t)section_size;
 }
 
 
 // .............................................................................................
-void
-UI_Set_Active_Widget(UI_Context *ui, UI_Id id)
+int
+UI_Snapshot_Load_Panels(UI_Context *ui, const void *data, int size)
 {
-	ui->interaction.active_widget = id;
+	int section_size;
+	const unsigned char *payload = (const unsigned char *)UI_Snapshot_Find(data, size, UI_SNAPSHOT_PANELS, &section_size);
+	if (!UI_Snapshot_Panels_Valid(payload, section_size)) return 0;
+	
+	int32_t count, strings_size;
+	memcpy(&count, payload, sizeof(count));
+	memcpy(&strings_size, payload + 4, sizeof(strings_size));
+	const unsigned char *panels = payload + 8;
+	const unsigned char *styles = panels + count * sizeof(UI_Panel);
+	const unsigned char *labels = styles + count * sizeof(UI_Style);
+	const char *strings = (const char *)(labels + count * sizeof(UI_Snapshot_Label));
+	
+	UI_State *s = &ui->state;
+	UI_State_Reset(s);
+	for (int i = 0; i < count; i++) {
+		UI_Panel p;
+		memcpy(&p, panels + i * sizeof(UI_Panel), sizeof(p));
+		
+		int idx = UI_New_Panel(s, p.id);
+		if (idx < 0) return 0;
+		s->panels[idx] = p;
+		memcpy(&s->styles[idx], styles + i * sizeof(UI_Style), sizeof(UI_Style));
+		
+		UI_Snapshot_Label label;
+		memcpy(&label, labels + i * sizeof(UI_Snapshot_Label), sizeof(label));
+		UI_Panel_Cold *cold = &s->cold[idx];
+		cold->label_color = label.color;
+		cold->label_font_style = label.font_style;
+		cold->is_label = label.is_label;
+		cold->label_text = (label.text_offset >= 0) ? UI_Frame_String(s, strings + label.text_offset) : 0;
+	}
+	return 1;
 }
 
 
 // .............................................................................................
-void
-UI_Clear_Active_Widget(UI_Context *ui)
+// Every section is checked before anything is applied, so a rejected snapshot leaves the
+// context untouched
+int
+UI_Snapshot_Load(UI_Context *ui, const void *data, int size)
 {
-	ui->interaction.active_widget = 0;
+	if (!UI_Snapshot_Validate(data, size)) return 0;
+	if (!UI_Snapshot_Records_Valid(data, size, UI_SNAPSHOT_OVERRIDES, sizeof(UI_Size_Override))) return 0;
+	if (!UI_Snapshot_Records_Valid(data, size, UI_SNAPSHOT_LISTS, sizeof(UI_List_State))) return 0;
+	
+	int section_size;
+	const unsigned char *payload = (const unsigned char *)UI_Snapshot_Find(data, size, UI_SNAPSHOT_PANELS, &section_size);
+	if (!UI_Snapshot_Panels_Valid(payload, section_size)) return 0;
+	
+	int32_t count = 0;
+	payload = (const unsigned char *)UI_Snapshot_Find(data, size, UI_SNAPSHOT_OVERRIDES, &section_size);
+	if (payload) memcpy(&count, payload, sizeof(count));
+	for (int i = 0; payload && i < count; i++) {
+		UI_Size_Override o;
+		memcpy(&o, payload + 4 + i * sizeof(UI_Size_Override), sizeof(o));
+		UI_Set_Size_Override(ui, o.panel_id, o.pref_w, o.pref_h);
+	}
+	
+	count = 0;
+	payload = (const unsigned char *)UI_Snapshot_Find(data, size, UI_SNAPSHOT_LISTS, &section_size);
+	if (payload) memcpy(&count, payload, sizeof(count));
+	for (int i = 0; payload && i < count; i++) {
+		UI_List_State saved;
+		memcpy(&saved, payload + 4 + i * sizeof(UI_List_State), sizeof(saved));
+		UI_List_State *st = UI_Get_List_State(ui, saved.list_id);
+		if (!st) continue;
+		st->scroll_y = saved.scroll_y;
+		st->rect = saved.rect;
+		st->view_h = saved.view_h;
+	}
+	
+	if (!UI_Snapshot_Load_Panels(ui, data, size)) return 0;
+	
+	// The stored frame becomes "last frame" for the layout cache (hashes recomputed in
+	// case the writer ran with the cache disabled)
+	UI_State *s = &ui->state;
+	if (s->panel_count > 0) {
+		UI_Layout_Hash_Subtrees(s);
+		UI_Layout_Cache_Store(s);
+	}
+	s->rects_generation++;
+	return 1;
 }
 
 
 // .............................................................................................
+// UI_Begin_List - Open a virtualized list panel (see ui.h)
+//
+// Visible rows come from last frame's viewport and the persistent scroll offset: rows
+// [first, end) get panels, and the column's scroll_y places row 'first' at the right
+// offset, so no spacer panels are needed and the panel count is independent of row_count.
 void
-UI_Set_Size_Override(UI_Context *ui, UI_Id panel_id, int pref_w, int pref_h)
+UI_Begin_List(UI_Context *ui, const char *id, int row_count, int row_height)
 {
-	// Check if override already exists
-	for (int i = 0; i < ui->size_override_count; i++) {
-		if (ui->size_overrides[i].panel_id == panel_id) {
-			// Update existing override
-			if (pref_w >= 0) ui->size_overrides[i].pref_w = pref_w;
-			if (pref_h >= 0) ui->size_overrides[i].pref_h = pref_h;
-			return;
-		}
-	}
+	UI_Begin_Panel(ui, id);
+	if (ui->parent_stack_count == 0) return;
 	
-	// Add new override
-	if (ui->size_override_count < UI_MAX_SIZE_OVERRIDES) {
-		ui->size_overrides[ui->size_override_count].panel_id = panel_id;
-		ui->size_overrides[ui->size_override_count].pref_w = pref_w;
-		ui->size_overrides[ui->size_override_count].pref_h = pref_h;
-		ui->size_override_count++;
+	int panel_idx = ui->parent_stack[ui->parent_stack_count - 1];
+	UI_Id list_id = ui->state.panels[panel_idx].id;
+	UI_Style *style = &ui->state.styles[panel_idx];
+	style->color = 0x00000000;
+	style->direction = UI_DIRECTION_COLUMN;
+	style->flex_grow = 1.0f;
+	style->clip_children = 1;
+	
+	// Rows are ID-scoped by the list, then by row index
+	assert(ui->id_scope_count < UI_MAX_ID_SCOPE_DEPTH && "ID scope stack overflow");
+	if (ui->id_scope_count < UI_MAX_ID_SCOPE_DEPTH) ui->id_scope_stack[ui->id_scope_count++] = list_id;
+	
+	assert(ui->list_depth < UI_MAX_LIST_DEPTH && "UI_Begin_List nested too deeply");
+	if (ui->list_depth >= UI_MAX_LIST_DEPTH) return;
+	
+	UI_List_Scope *scope = &ui->list_stack[ui->list_depth++];
+	if (row_height < 1) row_height = 1;
+	if (row_count < 0) row_count = 0;
+	scope->list_id = list_id;
+	scope->row_height = row_height;
+	scope->row = -1;
+	scope->row_end = 0;
+	scope->row_open = 0;
+	
+	UI_List_State *st = UI_Get_List_State(ui, list_id);
+	if (!st) return;
+	st->last_frame = ui->frame_number;
+	
+	// Not laid out yet: assume the list may cover the whole window
+	int laid_out = st->rect.w > 0;
+	int view_h = laid_out ? st->view_h : ui->screen_h;
+	
+	// Mouse wheel scrolls the hovered list (consumed, so enclosing lists do not also scroll)
+	if (laid_out && ui->input.mouse_wheel_delta != 0.0f &&
+	    UI_Is_Point_In_Rect(ui->input.mouse_x, ui->input.mouse_y, st->rect)) {
+		st->scroll_y -= (int)(ui->input.mouse_wheel_delta * (float)(row_height * UI_LIST_WHEEL_ROWS));
+		ui->input.mouse_wheel_delta = 0.0f;
 	}
+	
+	// Clamp (also after the row count or viewport shrank)
+	int64_t content_h = (int64_t)row_count * row_height;
+	int64_t max_scroll = content_h - view_h;
+	if (max_scroll < 0) max_scroll = 0;
+	if (st->scroll_y > max_scroll) st->scroll_y = (int)max_scroll;
+	if (st->scroll_y < 0) st->scroll_y = 0;
+	
+	int first = st->scroll_y / row_height;
+	int64_t end = ((int64_t)st->scroll_y + view_h + row_height - 1) / row_height;
+	if (end > row_count) end = row_count;
+	
+	style->scroll_y = st->scroll_y - first * row_height;
+	scope->row = first - 1;
+	scope->row_end = (int)end;
 }
 
 
 // .............................................................................................
+// UI_List_Row - Advance to the next visible row; returns 0 (and closes the last row) at the end
+// Each row is a fixed-height row-direction panel with its own ID scope.
 int
-UI_Get_Size_Override_W(UI_Context *ui, UI_Id panel_id)
+UI_List_Row(UI_Context *ui, int *out_row)
 {
-	for (int i = 0; i < ui->size_override_count; i++) {
-		if (ui->size_overrides[i].panel_id == panel_id) {
-			return ui->size_overrides[i].pref_w;
-		}
+	if (ui->list_depth == 0) return 0;
+	UI_List_Scope *scope = &ui->list_stack[ui->list_depth - 1];
+	
+	if (scope->row_open) {
+		UI_End_Panel(ui);
+		UI_Pop_Id(ui);
+		scope->row_open = 0;
 	}
-	return -1;  // No override found
+	
+	if (scope->row + 1 >= scope->row_end) return 0;
+	scope->row++;
+	
+	UI_Push_Id_Int(ui, scope->row);
+	UI_Begin_Panel(ui, "row");
+	UI_Panel_Set_Color(ui, 0x00000000);
+	UI_Panel_Set_Direction(ui, UI_DIRECTION_ROW);
+	UI_Panel_Set_Size(ui, -1, scope->row_height);
+	UI_Panel_Set_Shrink(ui, 0.0f);  // Rows overflow the viewport on purpose (scroll_y)
+	scope->row_open = 1;
+	
+	if (out_row) *out_row = scope->row;
+	return 1;
 }
 
 
 // .............................................................................................
-int
-UI_Get_Size_Override_H(UI_Context *ui, UI_Id panel_id)
+void
+UI_End_List(UI_Context *ui)
 {
-	for (int i = 0; i < ui->size_override_count; i++) {
-		if (ui->size_overrides[i].panel_id == panel_id) {
-			return ui->size_overrides[i].pref_h;
+	assert(ui->list_depth > 0 && "UI_End_List without matching UI_Begin_List");
+	if (ui->list_depth > 0) {
+		UI_List_Scope *scope = &ui->list_stack[--ui->list_depth];
+		if (scope->row_open) {
+			UI_End_Panel(ui);
+			UI_Pop_Id(ui);
 		}
 	}
-	return -1;  // No override found
+	
+	UI_Pop_Id(ui);
+	UI_End_Panel(ui);
 }
 
 
 // .............................................................................................
-static int
-UI_Find_Panel_By_Id(UI_State *s, UI_Id id)
+// Record the laid-out rect of every list built this frame (next frame's viewport)
+static void
+UI_Update_List_Viewports(UI_Context *ui)
 {
-	for (int i = 0; i < s->panel_count; i++) {
-		if (s->panels[i].id == id) {
-			return i;
-		}
+	for (int i = 0; i < ui->list_state_capacity; i++) {
+		UI_List_State *st = &ui->list_states[i];
+		if (st->list_id == 0 || st->last_frame != ui->frame_number) continue;
+		
+		int idx = UI_Find_Panel_By_Id(&ui->state, st->list_id);
+		if (idx < 0) continue;
+		
+		const UI_Style *style = &ui->state.styles[idx];
+		st->rect = ui->state.panels[idx].rect;
+		st->view_h = st->rect.h - style->pad_t - style->pad_b;
+		if (st->view_h < 0) st->view_h = 0;
 	}
-	return -1;
 }
 
 
@@ -1109,12 +3943,10 @@ UI_Get_Resize_Direction(UI_State *s, int panel_idx)
 	// If no parent, cannot resize
 	if (p->parent < 0) return -1;
 	
-	UI_Panel *parent = &s->panels[p->parent];
-	
 	// Resize direction is perpendicular to parent's layout direction
 	// If parent is ROW (horizontal), dividers resize horizontally (0)
 	// If parent is COLUMN (vertical), dividers resize vertically (1)
-	return parent->style.direction;
+	return s->styles[p->parent].direction;
 }
 
 
@@ -1165,6 +3997,15 @@ UI_Find_Next_Panel(UI_State *s, int divider_idx)
 }
 
 
+// .............................................................................................
+// Smallest size a divider drag may leave a panel: its layout min, else UI_RESIZABLE_MIN_SIZE
+static int
+UI_Drag_Min_Size(int layout_min)
+{
+	return (layout_min > 0) ? layout_min : UI_RESIZABLE_MIN_SIZE;
+}
+
+
 // .............................................................................................
 // UI_Update_Divider_Resize - Handle resizable divider dragging with zero-sum constraint-aware resizing
 //
@@ -1216,9 +4057,9 @@ UI_Update_Divider_Resize(UI_Context *ui)
 	
 	// Apply left panel constraints and recalculate delta if needed
 	if (left_idx >= 0) {
-		UI_Panel *left = &ui->state.panels[left_idx];
-		int min = (resize_dir == 0) ? left->style.min_w : left->style.min_h;
-		int max = (resize_dir == 0) ? left->style.max_w : left->style.max_h;
+		const UI_Style *left = &ui->state.styles[left_idx];
+		int min = UI_Drag_Min_Size((resize_dir == 0) ? left->min_w : left->min_h);
+		int max = (resize_dir == 0) ? left->max_w : left->max_h;
 		
 		if (new_left_size < min) {
 			// Left panel hit minimum - recalculate delta
@@ -1235,9 +4076,9 @@ UI_Update_Divider_Resize(UI_Context *ui)
 	
 	// Apply right panel constraints and recalculate delta if needed
 	if (right_idx >= 0) {
-		UI_Panel *right = &ui->state.panels[right_idx];
-		int min = (resize_dir == 0) ? right->style.min_w : right->style.min_h;
-		int max = (resize_dir == 0) ? right->style.max_w : right->style.max_h;
+		const UI_Style *right = &ui->state.styles[right_idx];
+		int min = UI_Drag_Min_Size((resize_dir == 0) ? right->min_w : right->min_h);
+		int max = (resize_dir == 0) ? right->max_w : right->max_h;
 		
 		if (new_right_size < min) {
 			// Right panel hit minimum - recalculate delta from right's perspective
@@ -1256,74 +4097,201 @@ UI_Update_Divider_Resize(UI_Context *ui)
 	if (resize_dir == 0) {
 		// Horizontal resize
 		if (left_idx >= 0) {
-			UI_Panel *left = &ui->state.panels[left_idx];
+			UI_Style *left = &ui->state.styles[left_idx];
 			UI_Set_Size_Override(ui, ui->interaction.resize_target_left_id, new_left_size, -1);
-			left->style.pref_w = new_left_size;
-			left->style.flex_grow = 0.0f;  // Convert from flex to fixed
+			left->pref_w = new_left_size;
+			left->flex_grow = 0.0f;  // Convert from flex to fixed
 		}
 		if (right_idx >= 0) {
-			UI_Panel *right = &ui->state.panels[right_idx];
+			UI_Style *right = &ui->state.styles[right_idx];
 			UI_Set_Size_Override(ui, ui->interaction.resize_target_right_id, new_right_size, -1);
-			right->style.pref_w = new_right_size;
-			right->style.flex_grow = 0.0f;  // Convert from flex to fixed
+			right->pref_w = new_right_size;
+			right->flex_grow = 0.0f;  // Convert from flex to fixed
 		}
 	} else {
 		// Vertical resize
 		if (left_idx >= 0) {
-			UI_Panel *left = &ui->state.panels[left_idx];
+			UI_Style *left = &ui->state.styles[left_idx];
 			UI_Set_Size_Override(ui, ui->interaction.resize_target_left_id, -1, new_left_size);
-			left->style.pref_h = new_left_size;
-			left->style.flex_grow = 0.0f;  // Convert from flex to fixed
+			left->pref_h = new_left_size;
+			left->flex_grow = 0.0f;  // Convert from flex to fixed
 		}
 		if (right_idx >= 0) {
-			UI_Panel *right = &ui->state.panels[right_idx];
+			UI_Style *right = &ui->state.styles[right_idx];
 			UI_Set_Size_Override(ui, ui->interaction.resize_target_right_id, -1, new_right_size);
-			right->style.pref_h = new_right_size;
-			right->style.flex_grow = 0.0f;  // Convert from flex to fixed
+			right->pref_h = new_right_size;
+			right->flex_grow = 0.0f;  // Convert from flex to fixed
 		}
 	}
 }
 
 
 // .............................................................................................
-static void
-UI_Update_Panel_Interaction_NonResizable(UI_Context *ui, UI_State *s, int panel_idx)
+// Hitbox used for hover tests (dividers get an expanded rect); 0 if never hot
+static int
+UI_Panel_Hitbox(UI_State *s, int panel_idx, UI_RectI *out)
 {
-	UI_Panel *p = &s->panels[panel_idx];
+	if (s->cold[panel_idx].is_label) return 0;
 	
-	// Check non-resizable panels only (skip labels and resizable dividers)
-	if (!p->is_label && !p->style.resizable) {
-		if (UI_Is_Hovered(ui, p->rect)) {
-			UI_Set_Hot_Widget(ui, p->id);
-		}
+	const UI_Style *style = &s->styles[panel_idx];
+	UI_RectI r = style->resizable
+	           ? UI_Get_Expanded_Rect(s->panels[panel_idx].rect, style->resize_hitbox_padding)
+	           : s->panels[panel_idx].rect;
+	
+	// Clipped by ancestors (scrolled lists): only the visible part can be hovered
+	for (int a = s->panels[panel_idx].parent; a >= 0; a = s->panels[a].parent) {
+		if (s->styles[a].clip_children) r = UI_Intersect_Rect(r, s->panels[a].rect);
 	}
 	
-	// Recurse into children
-	for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling) {
-		UI_Update_Panel_Interaction_NonResizable(ui, s, c);
+	*out = r;
+	return out->w > 0 && out->h > 0;
+}
+
+
+// .............................................................................................
+// End of the root's subtree (pre-order: contiguous from 0 up to the next top-level panel)
+static int
+UI_Root_Subtree_End(UI_State *s)
+{
+	for (int i = 1; i < s->panel_count; i++) {
+		if (s->panels[i].parent < 0) return i;
 	}
+	return s->panel_count;
 }
 
 
 // .............................................................................................
-static void
-UI_Update_Panel_Interaction_Resizable(UI_Context *ui, UI_State *s, int panel_idx)
+// Cell range covered by a hitbox (0 if entirely outside the grid)
+static int
+UI_Hit_Grid_Cells(UI_Hit_Grid *g, UI_RectI r, int *x0, int *y0, int *x1, int *y1)
 {
-	UI_Panel *p = &s->panels[panel_idx];
+	int right = r.x + r.w, bottom = r.y + r.h;
+	int grid_w = g->cells_x * UI_HIT_GRID_CELL_SIZE, grid_h = g->cells_y * UI_HIT_GRID_CELL_SIZE;
+	if (right <= 0 || bottom <= 0 || r.x >= grid_w || r.y >= grid_h) return 0;
 	
-	// Check resizable panels with expanded hitbox (highest priority)
-	if (!p->is_label && p->style.resizable) {
-		UI_RectI check_rect = UI_Get_Expanded_Rect(p->rect, p->style.resize_hitbox_padding);
-		
-		if (UI_Is_Hovered(ui, check_rect)) {
-			UI_Set_Hot_Widget(ui, p->id);
+	*x0 = r.x > 0 ? r.x / UI_HIT_GRID_CELL_SIZE : 0;
+	*y0 = r.y > 0 ? r.y / UI_HIT_GRID_CELL_SIZE : 0;
+	*x1 = (right - 1) / UI_HIT_GRID_CELL_SIZE;
+	*y1 = (bottom - 1) / UI_HIT_GRID_CELL_SIZE;
+	if (*x1 >= g->cells_x) *x1 = g->cells_x - 1;
+	if (*y1 >= g->cells_y) *y1 = g->cells_y - 1;
+	return 1;
+}
+
+
+// .............................................................................................
+// Build the grid with a counting sort: count entries per cell, prefix-sum, then fill in
+// ascending panel order (so each cell's list is in pre-order)
+static int
+UI_Hit_Grid_Build(UI_Context *ui)
+{
+	UI_Hit_Grid *g = &ui->hit_grid;
+	UI_State *s = &ui->state;
+	int panel_end = UI_Root_Subtree_End(s);
+	
+	g->valid = 0;
+	g->cells_x = (ui->screen_w + UI_HIT_GRID_CELL_SIZE - 1) / UI_HIT_GRID_CELL_SIZE;
+	g->cells_y = (ui->screen_h + UI_HIT_GRID_CELL_SIZE - 1) / UI_HIT_GRID_CELL_SIZE;
+	if (g->cells_x < 1) g->cells_x = 1;
+	if (g->cells_y < 1) g->cells_y = 1;
+	int cell_count = g->cells_x * g->cells_y;
+	
+	if (!UI_Grow_Array((void **)&g->cell_start, &g->cell_capacity, cell_count + 1, sizeof(int), 256)) return 0;
+	if (!UI_Grow_Array((void **)&g->cell_fill, &g->fill_capacity, cell_count, sizeof(int), 256)) return 0;
+	UI_MEMSET(g->cell_start, 0, (cell_count + 1) * sizeof(int));
+	
+	// Count
+	UI_RectI r;
+	int x0, y0, x1, y1;
+	for (int i = 0; i < panel_end; i++) {
+		if (!UI_Panel_Hitbox(s, i, &r) || !UI_Hit_Grid_Cells(g, r, &x0, &y0, &x1, &y1)) continue;
+		for (int cy = y0; cy <= y1; cy++)
+			for (int cx = x0; cx <= x1; cx++)
+				g->cell_start[cy * g->cells_x + cx + 1]++;
+	}
+	
+	// Prefix sum
+	for (int c = 0; c < cell_count; c++) {
+		g->cell_start[c + 1] += g->cell_start[c];
+		g->cell_fill[c] = g->cell_start[c];
+	}
+	
+	// Fill
+	if (!UI_Grow_Array((void **)&g->entries, &g->entry_capacity, g->cell_start[cell_count], sizeof(int), 1024)) return 0;
+	for (int i = 0; i < panel_end; i++) {
+		if (!UI_Panel_Hitbox(s, i, &r) || !UI_Hit_Grid_Cells(g, r, &x0, &y0, &x1, &y1)) continue;
+		for (int cy = y0; cy <= y1; cy++)
+			for (int cx = x0; cx <= x1; cx++)
+				g->entries[g->cell_fill[cy * g->cells_x + cx]++] = i;
+	}
+	
+	g->panel_end = panel_end;
+	g->rects_generation = s->rects_generation;
+	g->screen_w = ui->screen_w;
+	g->screen_h = ui->screen_h;
+	g->valid = 1;
+	g->rebuilds++;
+	return 1;
+}
+
+
+// .............................................................................................
+// UI_Hit_Test - ID of the panel that becomes hot at (x, y), or 0
+//
+// Priority rules (same as walking the tree twice):
+// - Any divider (resizable panel, expanded hitbox) beats any other panel
+// - Within a class, the panel latest in pre-order (deepest/last drawn) wins
+// Panel indices are in pre-order, so "latest" is simply the largest index.
+static UI_Id
+UI_Hit_Test(UI_Context *ui, int x, int y)
+{
+	UI_State *s = &ui->state;
+	UI_Hit_Grid *g = &ui->hit_grid;
+	
+	// Layout bumps rects_generation whenever rects change, so checking it is O(1)
+	if (g->valid && g->rects_generation == s->rects_generation &&
+	    g->screen_w == ui->screen_w && g->screen_h == ui->screen_h) {
+		if (x == g->last_mouse_x && y == g->last_mouse_y) {
+			g->quick_rejects++;
+			return g->last_hot;
 		}
+	} else if (!UI_Hit_Grid_Build(ui)) {
+		return 0;
 	}
+	g->queries++;
+	g->last_mouse_x = x;
+	g->last_mouse_y = y;
+	g->last_hot = 0;
 	
-	// Recurse into children
-	for (int c = p->first_child; c != -1; c = s->panels[c].next_sibling) {
-		UI_Update_Panel_Interaction_Resizable(ui, s, c);
+	// Hitboxes are clipped to the grid (the window), so nothing is hot off it
+	int grid_w = g->cells_x * UI_HIT_GRID_CELL_SIZE, grid_h = g->cells_y * UI_HIT_GRID_CELL_SIZE;
+	if (x < 0 || y < 0 || x >= grid_w || y >= grid_h) return 0;
+	
+	int cell = (y / UI_HIT_GRID_CELL_SIZE) * g->cells_x + (x / UI_HIT_GRID_CELL_SIZE);
+	const int *candidates = g->entries + g->cell_start[cell];
+	int count = g->cell_start[cell + 1] - g->cell_start[cell];
+	
+	// Walk from the latest panel back; the first divider hit wins outright, otherwise
+	// the first (latest) regular hit
+	UI_Id hot = 0;
+	int found_regular = 0;
+	for (int k = count - 1; k >= 0; k--) {
+		int i = candidates[k];
+		UI_RectI r;
+		if (!UI_Panel_Hitbox(s, i, &r) || !UI_Is_Point_In_Rect(x, y, r)) continue;
+		
+		if (s->styles[i].resizable) {
+			hot = s->panels[i].id;
+			break;
+		}
+		if (!found_regular) {
+			hot = s->panels[i].id;
+			found_regular = 1;
+		}
 	}
+	
+	g->last_hot = hot;
+	return hot;
 }
 
 
@@ -1331,20 +4299,18 @@ UI_Update_Panel_Interaction_Resizable(UI_Context *ui, UI_State *s, int panel_idx
 void
 UI_Update_Interaction(UI_Context *ui)
 {
+	// Viewports for next frame's list virtualization
+	UI_Update_List_Viewports(ui);
+	
 	// Update divider resize if dragging
 	UI_Update_Divider_Resize(ui);
 	
 	// Clear hot widget
 	ui->interaction.hot_widget = 0;
 	
-	// Two-pass system: check all non-resizable panels first, then all resizable panels
-	// This ensures resizable dividers always have highest priority when their expanded hitbox is hovered
+	// Hit test through the grid (resizable dividers win conflicts with their expanded hitbox)
 	if (ui->state.panel_count > 0) {
-		// PASS 1: Check all non-resizable panels (buttons, sidebars, content areas)
-		UI_Update_Panel_Interaction_NonResizable(ui, &ui->state, 0);
-		
-		// PASS 2: Check all resizable panels with expanded hitbox (dividers win conflicts)
-		UI_Update_Panel_Interaction_Resizable(ui, &ui->state, 0);
+		UI_Set_Hot_Widget(ui, UI_Hit_Test(ui, ui->input.mouse_x, ui->input.mouse_y));
 	}
 	
 	// Handle drag start
@@ -1352,7 +4318,7 @@ UI_Update_Interaction(UI_Context *ui)
 		if (ui->interaction.hot_widget != 0) {
 			// Check if hot widget is a resizable divider
 			int hot_idx = UI_Find_Panel_By_Id(&ui->state, ui->interaction.hot_widget);
-			if (hot_idx >= 0 && ui->state.panels[hot_idx].style.resizable) {
+			if (hot_idx >= 0 && ui->state.styles[hot_idx].resizable) {
 				// Start dragging divider
 				ui->interaction.dragging_divider = ui->interaction.hot_widget;
 				
@@ -1436,12 +4402,16 @@ UI_Button(UI_Context *ui, const char *text)
 			clicked = 1;
 			
 			// Track last button clicked
+#ifdef UI_COMPACT_CONTEXT
+			ui->last_button_clicked = UI_Intern_String(ui, text);
+#else
 			int len = 0;
 			while (len < MAX_UI_TEXT_LENGTH - 1 && text[len]) {
 				ui->last_button_clicked[len] = text[len];
 				len++;
 			}
 			ui->last_button_clicked[len] = 0;
+#endif
 		}
 	}
 	
@@ -1480,10 +4450,13 @@ UI_Debug_Mouse_Overlay(UI_Context *ui)
 	// Build line 1 - input & timing state
 	char line1[512];
 	snprintf(line1, sizeof(line1), 
-	         "Frame:%6d %6.2fms | %3d FPS | Mouse:(%4d,%4d) | Down L:%d R:%d M:%d | Press L:%d R:%d M:%d | Release L:%d R:%d M:%d | Char:'%c'",
+	         "Frame:%6d %6.2fms | %3d FPS Jit:%5.2fms Lat:%5.2fms Queue:%5.2fms | Mouse:(%4d,%4d) | Down L:%d R:%d M:%d | Press L:%d R:%d M:%d | Release L:%d R:%d M:%d | Char:'%c'",
 	         ui->frame_number,
 	         ui->delta_time_ms,
 	         ui->current_fps,
+	         ui->frame_jitter_ms,
+	         ui->input_latency_ms,
+	         ui->input_queue.oldest_age_ms,
 	         ui->input.mouse_x, ui->input.mouse_y,
 	         ui->input.mouse_down[UI_MOUSE_LEFT],
 	         ui->input.mouse_down[UI_MOUSE_RIGHT],
@@ -1498,9 +4471,12 @@ UI_Debug_Mouse_Overlay(UI_Context *ui)
 	);
 	
 	// Build line 2 - widget interaction state
+	UI_Memory_Stats memory;
+	UI_Memory_Stats_Get(ui, &memory);
+	const char *last_clicked = ui->last_button_clicked;  // Array, or interned pointer (compact)
 	char line2[512];
 	snprintf(line2, sizeof(line2), 
-	         "Hot:%d Active:%d | Drag:%d | L:%d(sz:%d) R:%d(sz:%d) Pos:%d | Last:\"%s\"",
+	         "Hot:%d Active:%d | Drag:%d | L:%d(sz:%d) R:%d(sz:%d) Pos:%d | Panels:%d/%d Arena:%dB Mem:%dK/%dK Reuse:%d Tasks:%d Retained:%d/%d Cull:%d | Last:\"%s\"",
 	         ui->interaction.hot_widget,
 	         ui->interaction.active_widget,
 	         ui->interaction.dragging_divider,
@@ -1509,27 +4485,171 @@ UI_Debug_Mouse_Overlay(UI_Context *ui)
 	         ui->interaction.resize_target_right_id,
 	         ui->interaction.drag_start_size_right,
 	         ui->interaction.drag_start_pos,
-	         ui->last_button_clicked[0] ? ui->last_button_clicked : "None"
+	         ui->state.panel_count,
+	         ui->state.panel_high_water,
+	         ui->state.frame_arena.high_water,
+	         (int)(memory.total / 1024),
+	         (int)(memory.total_peak / 1024),
+	         ui->state.layout_cache.panels_reused,
+	         ui->state.layout_cache.parallel_tasks,
+	         ui->retained_hits,
+	         ui->retained_hits + ui->retained_misses,
+	         ui->state.panels_culled,
+	         (last_clicked && last_clicked[0]) ? last_clicked : "None"
 	);
 	
-	// Measure both lines
-	UI_RectI fallback_size = {0, 0, 800, 20};
-	UI_RectI size1 = ui->measure_text ? ui->measure_text(line1, 14) : fallback_size;
-	UI_RectI size2 = ui->measure_text ? ui->measure_text(line2, 14) : fallback_size;
+	// Create debug overlay panel (COLUMN direction for vertical stacking, AUTO height from the lines)
+	UI_Begin_Panel(ui, "##debug_overlay");
+	UI_Panel_Set_Color(ui, 0xEE000000);
+	UI_Panel_Set_Padding(ui, 8, 4, 8, 4);
+	UI_Panel_Set_Direction(ui, UI_DIRECTION_COLUMN);
+	UI_Panel_Set_Gap(ui, 2);
+		UI_Label_Monospace(ui, line1, 0xFF00FF00);
+		UI_Label_Monospace(ui, line2, 0xFF00FF00);
+	UI_End_Panel(ui);
+}
+
+
+// .............................................................................................
+// UI_Frame_Stats_Push - Append a sample, overwriting the oldest once the ring is full
+void
+UI_Frame_Stats_Push(UI_Frame_Stats *stats, const UI_Frame_Sample *sample)
+{
+#ifdef UI_COMPACT_CONTEXT
+	if (!stats->samples) {
+		stats->samples = (UI_Frame_Sample *)UI_MALLOC(UI_FRAME_STATS_HISTORY * sizeof(UI_Frame_Sample));
+		if (!stats->samples) return;
+	}
+#endif
+	stats->samples[stats->next] = *sample;
+	stats->next = (stats->next + 1) % UI_FRAME_STATS_HISTORY;
+	if (stats->count < UI_FRAME_STATS_HISTORY) stats->count++;
+}
+
+
+// .............................................................................................
+// UI_Frame_Stats_Copy - Copy up to max_samples of the newest samples, oldest first
+// Returns the number copied (for telemetry export).
+int
+UI_Frame_Stats_Copy(const UI_Frame_Stats *stats, UI_Frame_Sample *out, int max_samples)
+{
+	int n = stats->count < max_samples ? stats->count : max_samples;
+	int first = stats->next - n;
+	if (first < 0) first += UI_FRAME_STATS_HISTORY;
+	
+	for (int i = 0; i < n; i++) {
+		out[i] = stats->samples[(first + i) % UI_FRAME_STATS_HISTORY];
+	}
+	return n < 0 ? 0 : n;
+}
+
+
+// .............................................................................................
+static int
+UI_Compare_Float(const void *a, const void *b)
+{
+	float fa = *(const float *)a, fb = *(const float *)b;
+	return (fa > fb) - (fa < fb);
+}
+
+
+// .............................................................................................
+// Nearest-rank percentile of a sorted array
+static float
+UI_Percentile(const float *sorted, int n, int percent)
+{
+	if (n <= 0) return 0.0f;
+	int rank = (n * percent + 99) / 100;  // ceil(n * p / 100)
+	if (rank < 1) rank = 1;
+	return sorted[rank - 1];
+}
+
+
+// .............................................................................................
+// UI_Frame_Stats_Summarize - p50/p99/max frame and CPU times, averages over the ring
+void
+UI_Frame_Stats_Summarize(const UI_Frame_Stats *stats, UI_Frame_Stats_Summary *out)
+{
+	UI_MEMSET(out, 0, sizeof(UI_Frame_Stats_Summary));
+	int n = stats->count;
+	out->frames = n;
+	out->measure_hit_rate = 1.0f;
+	if (n == 0) return;
+	
+	float frame_ms[UI_FRAME_STATS_HISTORY];
+	float cpu_ms[UI_FRAME_STATS_HISTORY];
+	int64_t hits = 0, lookups = 0;
 	
-	// Use max width for panel
-	int max_width = (size1.w > size2.w) ? size1.w : size2.w;
-	int total_height = size1.h + size2.h + 2;  // +2 for gap between lines
+	for (int i = 0; i < n; i++) {
+		const UI_Frame_Sample *f = &stats->samples[i];
+		frame_ms[i] = f->frame_ms;
+		cpu_ms[i] = f->cpu_ms;
+		for (int ph = 0; ph < UI_PHASE_COUNT; ph++) out->phase_avg_ms[ph] += f->phase_ms[ph];
+		out->avg_panels += (float)f->panels;
+		out->avg_rectangles += (float)f->rectangles;
+		out->avg_texts += (float)f->texts;
+		hits += f->measure_hits;
+		lookups += f->measure_hits + f->measure_misses;
+	}
 	
-	// Create debug overlay panel (COLUMN direction for vertical stacking)
-	UI_Begin_Panel(ui, "##debug_overlay");
-	UI_Panel_Set_Size(ui, 1100, total_height + 8);
+	qsort(frame_ms, n, sizeof(float), UI_Compare_Float);
+	qsort(cpu_ms, n, sizeof(float), UI_Compare_Float);
+	out->frame_p50_ms = UI_Percentile(frame_ms, n, 50);
+	out->frame_p99_ms = UI_Percentile(frame_ms, n, 99);
+	out->frame_max_ms = frame_ms[n - 1];
+	out->cpu_p50_ms = UI_Percentile(cpu_ms, n, 50);
+	out->cpu_p99_ms = UI_Percentile(cpu_ms, n, 99);
+	out->cpu_max_ms = cpu_ms[n - 1];
+	
+	float inv = 1.0f / (float)n;
+	for (int ph = 0; ph < UI_PHASE_COUNT; ph++) out->phase_avg_ms[ph] *= inv;
+	out->avg_panels *= inv;
+	out->avg_rectangles *= inv;
+	out->avg_texts *= inv;
+	if (lookups > 0) out->measure_hit_rate = (float)hits / (float)lookups;
+}
+
+
+// .............................................................................................
+// UI_Frame_Stats_Overlay - Summary lines and a CPU time graph of the last frames
+// (bars are scaled to the window's max; the frame budget is the p50 frame time)
+void
+UI_Frame_Stats_Overlay(UI_Context *ui)
+{
+	const UI_Frame_Stats *stats = &ui->frame_stats;
+	UI_Frame_Stats_Summary sum;
+	UI_Frame_Stats_Summarize(stats, &sum);
+	
+	char line1[256], line2[256], line3[256];
+	snprintf(line1, sizeof(line1),
+	         "Frame p50:%6.2f p99:%6.2f max:%6.2f ms | CPU p50:%6.2f p99:%6.2f max:%6.2f ms | %d frames",
+	         sum.frame_p50_ms, sum.frame_p99_ms, sum.frame_max_ms,
+	         sum.cpu_p50_ms, sum.cpu_p99_ms, sum.cpu_max_ms, sum.frames);
+	snprintf(line2, sizeof(line2),
+	         "Avg ms  build:%5.2f layout:%5.2f interaction:%5.2f emit:%5.2f draw:%5.2f",
+	         sum.phase_avg_ms[UI_PHASE_BUILD], sum.phase_avg_ms[UI_PHASE_LAYOUT],
+	         sum.phase_avg_ms[UI_PHASE_INTERACTION], sum.phase_avg_ms[UI_PHASE_EMIT],
+	         sum.phase_avg_ms[UI_PHASE_DRAW]);
+	snprintf(line3, sizeof(line3),
+	         "Avg panels:%6.0f rects:%6.0f texts:%5.0f | Measure cache hit rate:%6.2f%%",
+	         sum.avg_panels, sum.avg_rectangles, sum.avg_texts, sum.measure_hit_rate * 100.0f);
+	
+	// Graph values straight from the ring, oldest first (no shared scratch copy)
+	float cpu_ms[UI_FRAME_STATS_HISTORY];
+	int n = stats->count;
+	int first = stats->next - n;
+	if (first < 0) first += UI_FRAME_STATS_HISTORY;
+	for (int i = 0; i < n; i++) cpu_ms[i] = stats->samples[(first + i) % UI_FRAME_STATS_HISTORY].cpu_ms;
+	
+	UI_Begin_Panel(ui, "##frame_stats");
 	UI_Panel_Set_Color(ui, 0xEE000000);
 	UI_Panel_Set_Padding(ui, 8, 4, 8, 4);
 	UI_Panel_Set_Direction(ui, UI_DIRECTION_COLUMN);
 	UI_Panel_Set_Gap(ui, 2);
 		UI_Label_Monospace(ui, line1, 0xFF00FF00);
 		UI_Label_Monospace(ui, line2, 0xFF00FF00);
+		UI_Label_Monospace(ui, line3, 0xFF00FF00);
+		UI_Graph(ui, "##frame_stats_graph", cpu_ms, n, sum.cpu_max_ms > 0.0f ? sum.cpu_max_ms : 1.0f, 0xFF00C0FF);
 	UI_End_Panel(ui);
 }
 
@@ -17,7 +17,8 @@
 //   * UI_SIZE_FLEX (-2): Flex-grow to fill available space
 //   * Fixed pixels (>= 0): Explicit size with optional size overrides
 // - Size Overrides: Persistent sizing across frame rebuilds (enables resizable dividers)
-// - Flexbox Layout: Two-pass algorithm (fixed sizes first, then distribute remaining space to flex-grow)
+// - Flexbox Layout: Two-pass algorithm (fixed sizes first, then distribute remaining space to flex-grow),
+//   with min/max clamping, flex_shrink on overflow and flex_basis
 //
 // USAGE PATTERN:
 //   UI_Begin_Frame(&ctx, &render_list, width, height);
@@ -34,25 +35,125 @@
 //
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
 
 // UI system capacity limits
-#define UI_MAX_PANELS 1024
+#ifdef UI_COMPACT_CONTEXT
+#define UI_MAX_PANELS 64           // Initial panel capacity (grows on demand)
+#else
+#define UI_MAX_PANELS 1024         // Initial panel capacity (grows on demand)
+#endif
 #define UI_MAX_PARENT_STACK_DEPTH 32
-#define UI_MAX_RECTANGLES 256
-#define UI_MAX_TEXTS 256
-#define UI_MAX_TEXT_LENGTH 256
-#define UI_MAX_USED_IDS 1024
-#define UI_MAX_SIZE_OVERRIDES 32
+#define UI_MAX_RECTANGLES 256      // Initial render list capacity (grows on demand)
+#define UI_MAX_TEXTS 256           // Initial render list capacity (grows on demand)
+#define UI_MAX_CACHE_GROUPS 16     // Initial render list capacity (grows on demand)
+#define UI_MAX_CLIP_RECTS 16       // Initial render list capacity (grows on demand)
+#define UI_MAX_TEXT_LENGTH 256     // Longest string stored per text primitive (bytes incl. NUL)
+#define UI_ARENA_PAGE_SIZE (16 * 1024)
+#define UI_MAX_USED_IDS 4096       // Distinct IDs tracked for dedup per frame
+#define UI_ID_TABLE_SIZE (UI_MAX_USED_IDS * 2)  // Open-addressing slots (power of two)
+#define UI_MAX_ID_SCOPE_DEPTH 32
+#define UI_HIT_GRID_CELL_SIZE 64   // Pixels per hit-test grid cell
+#define UI_MAX_RETAINED_BLOCKS 32  // UI_Begin_Cached blocks kept (LRU)
+#define UI_MAX_CACHED_DEPTH 8      // Nesting depth of UI_Begin_Cached
+#define UI_MAX_SIZE_OVERRIDES 32   // Initial size override table capacity (grows on demand)
+#define UI_MAX_LIST_STATES 16      // Initial list scroll state table capacity (grows on demand)
+#define UI_MAX_LIST_DEPTH 4        // Nesting depth of UI_Begin_List
+#define UI_LIST_WHEEL_ROWS 3       // Rows scrolled per mouse wheel notch
+#ifndef UI_PARALLEL_LAYOUT_MIN_PANELS
+#define UI_PARALLEL_LAYOUT_MIN_PANELS 512  // Subtree size that forks, and panels per forked task
+                                           // (~10 us of layout at ~20 ns/panel, well above a spawn)
+#endif
+#define UI_PARALLEL_LAYOUT_MAX_FORKS 64    // Tasks forked per container (rest runs inline)
+#define UI_FRAME_STATS_HISTORY 256  // Frames kept in UI_Frame_Stats (ring)
 #define UI_MAX_CHAR_BUFFER 32
 #define UI_KEY_COUNT 256
 #define UI_MOUSE_BUTTON_COUNT 3
+#ifndef UI_INPUT_QUEUE_CAPACITY
+#ifdef UI_COMPACT_CONTEXT
+#define UI_INPUT_QUEUE_CAPACITY 256   // Power of two; events pushed into a full queue are dropped
+#else
+#define UI_INPUT_QUEUE_CAPACITY 1024  // Power of two; events pushed into a full queue are dropped
+#endif
+#endif
+#ifndef UI_INTRINSIC_CACHE_CAPACITY
+#define UI_INTRINSIC_CACHE_CAPACITY 1024  // Power of two; label text sizes kept per panel ID
+#endif
+#define UI_RESIZABLE_MIN_SIZE 200  // Divider drags stop here for panels without a min (layout ignores it)
+
+// Compact context (define UI_COMPACT_CONTEXT before including ui.h, or /D at build time)
+// For applications embedding many contexts: key state is kept as bitsets, the ID dedup
+// table, label size cache and frame stats ring move to the heap and grow on demand
+// (allocated on first use), last_button_clicked is an interned string, and panel storage
+// starts at 64 panels and the input queue at 256 events. Lookups gain an indirection,
+// results are the same.
+#define UI_ID_TABLE_INITIAL 256         // First heap ID table size (compact, power of two)
+#define UI_INTRINSIC_CACHE_INITIAL 64   // First heap label size cache size (compact, power of two)
+#define UI_STRING_TABLE_INITIAL 64      // First interned string table size (power of two)
+
+// Font style bits (UI_Text::font_style, UI_Panel_Cold::label_font_style)
+// 0 = Segoe UI regular; combine one family with an optional weight and UI_FONT_ITALIC.
+#define UI_FONT_MONOSPACE 0x0001       // Consolas (Courier New if missing)
+#define UI_FONT_FAMILY_MASK 0x00FF
+#define UI_FONT_WEIGHT_SHIFT 8
+#define UI_FONT_WEIGHT_MASK 0x0F00     // Weight / 100 (1..9), 0 = regular (400)
+#define UI_FONT_ITALIC 0x1000
+#define UI_FONT_WEIGHT(w) ((((w) / 100) << UI_FONT_WEIGHT_SHIFT) & UI_FONT_WEIGHT_MASK)
+#define UI_FONT_LIGHT UI_FONT_WEIGHT(300)
+#define UI_FONT_SEMIBOLD UI_FONT_WEIGHT(600)
+#define UI_FONT_BOLD UI_FONT_WEIGHT(700)
 
 // Size sentinel values (for UI_Panel_Set_Size and helper functions)
 #define UI_SIZE_AUTO -1        // Auto-size based on content
 #define UI_SIZE_FLEX -2        // Flex-grow to fill available space
 
-// Text format cache capacity (application-specific)
-#define APP_MAX_TEXT_FORMATS 16
+// Text format cache: open-addressing table, grows without limit (application-specific)
+#define APP_TEXT_FORMAT_CACHE_INITIAL 64   // First table size (power of two)
+
+// Text measurement cache capacity (application-specific, override with /D at build time)
+#ifndef APP_TEXT_MEASURE_CACHE_CAPACITY
+#define APP_TEXT_MEASURE_CACHE_CAPACITY 1024
+#endif
+#define APP_TEXT_MEASURE_CACHE_BUCKETS (APP_TEXT_MEASURE_CACHE_CAPACITY * 2)
+
+// Retained text layout cache (application-specific)
+#ifndef APP_TEXT_LAYOUT_CACHE_CAPACITY
+#define APP_TEXT_LAYOUT_CACHE_CAPACITY 1024
+#endif
+#define APP_TEXT_LAYOUT_CACHE_BUCKETS (APP_TEXT_LAYOUT_CACHE_CAPACITY * 2)
+
+// Glyph atlas text backend, --text=atlas (application-specific)
+#define APP_GLYPH_ATLAS_FIRST 32       // First codepoint in every atlas (printable ASCII)
+#define APP_GLYPH_ATLAS_GLYPHS 95      // Codepoints 32..126
+#define APP_GLYPH_ATLAS_WIDTH 512      // Atlas width in DIPs (rows added as needed)
+#define APP_MAX_GLYPH_ATLASES 32       // Distinct (family, size, weight, italic) atlases
+// Batched rectangle rendering (application-specific)
+#define APP_MAX_COLOR_BRUSHES 64       // One cached brush per distinct ARGB color
+#define APP_RECT_BATCH_LOOKBACK 32     // Batches searched backward when merging same-color rects
+
+// Offscreen bitmap cache for UI_Panel_Set_Cache_Bitmap panels (application-specific)
+#define APP_MAX_CACHED_BITMAPS 16
+#ifndef APP_BITMAP_CACHE_BUDGET
+#define APP_BITMAP_CACHE_BUDGET (16 * 1024 * 1024)  // Bytes of cached bitmaps (4 per pixel)
+#endif
+
+// Input-to-present latency stats (application-specific)
+#define APP_LATENCY_WINDOW_FRAMES 60   // Frames averaged per published latency value
+
+// Flip-model swap chain backend, --present=flip (application-specific)
+#define APP_SWAP_CHAIN_BUFFERS 2        // Back buffers (flip model needs at least 2)
+#define APP_SWAP_CHAIN_MAX_LATENCY 1    // Frames queued before the latency waitable blocks
+
+// Coalesced drag resizing (application-specific)
+#define APP_RESIZE_TIMER_ID 1           // WM_TIMER id of the trailing render of a tick
+#define APP_RESIZE_BUFFER_STEP 256      // Swap chain buffers grow in steps of this many pixels while dragging
+
+// Warm-start snapshot (application-specific, next to the executable, --snapshot=off disables)
+#define APP_SNAPSHOT_FILE L"ui_snapshot.bin"
+
+#ifndef APP_TEXT_LAYOUT_EVICT_FRAMES
+#define APP_TEXT_LAYOUT_EVICT_FRAMES 120   // Release layouts unused for this many frames
+#endif
 
 // Legacy compatibility (keeping old names for now)
 #define MAX_UI_RECTANGLES UI_MAX_RECTANGLES
@@ -94,6 +195,10 @@ enum UI_Mouse_Button {
 #define UI_KEY_DELETE    0x2E
 #define UI_KEY_BACKSPACE 0x08
 
+typedef int32_t UI_Id;
+
+struct UI_RectI { int x, y, w, h; };
+
 struct UI_Rectangle {
 	int left, top, right, bottom;
 	uint32_t color;
@@ -102,67 +207,205 @@ struct UI_Rectangle {
 struct UI_Text {
 	int x, y, w, h;
 	uint32_t color;
-	char text[MAX_UI_TEXT_LENGTH];
+	const char *text;     // NUL-terminated, owned by the render list's string arena
+	int text_length;      // Bytes, excluding NUL
 	int font_size;
-	int font_style;  // 0=Segoe UI (default), 1=Consolas/Courier New (monospace)
+	int font_style;       // UI_FONT_* bits (0 = Segoe UI regular)
 	int align_h;
 	int align_v;
+	int clip;             // Index into the list's clip_rects, -1 = unclipped
+};
+
+// UI_Arena - Paged bump allocator
+// Pages are never moved, so returned pointers stay valid until the next reset.
+// Reset is O(1): pages are kept and reused in order. Zero-initialized = empty arena.
+struct UI_Arena_Page {
+	UI_Arena_Page *next;
+	int capacity;
+	int used;
+	// data follows
+};
+
+struct UI_Arena {
+	UI_Arena_Page *first;
+	UI_Arena_Page *current;
+	int used;           // Bytes allocated since last reset
+	int reserved;       // Bytes held in pages
+	int high_water;     // Largest 'used' seen
+};
+
+void *UI_Arena_Alloc(UI_Arena *arena, int size);
+void UI_Arena_Reset(UI_Arena *arena);
+void UI_Arena_Free(UI_Arena *arena);
+
+// UI_Cache_Group - Primitives of one cache_bitmap panel subtree
+// The ranges index the list's rectangles/texts. content_hash covers the primitives relative
+// to rect's origin, so a moved panel keeps its hash; a renderer may draw the group from a
+// bitmap instead of drawing the primitives while id, size and hash are unchanged.
+struct UI_Cache_Group {
+	UI_Id id;             // Panel ID
+	int x, y, w, h;       // Bounds of all primitives in the group (padded for glyph overhang)
+	uint32_t content_hash;
+	int rect_begin, rect_end;
+	int text_begin, text_end;
 };
 
+// UI_Render_List - Growable command buffer filled by UI_Emit_Panels
+// Zero-initialized = empty list. Storage is kept across frames; UI_Begin_Frame only resets it.
 struct UI_Render_List {
-	UI_Rectangle rectangles[MAX_UI_RECTANGLES];
-	UI_Text texts[MAX_UI_TEXTS];
+	UI_Rectangle *rectangles;
+	UI_Text *texts;
 	int rect_count;
 	int text_count;
+	int rect_capacity;
+	int text_capacity;
+	UI_Arena strings;
+	UI_Cache_Group *cache_groups;  // In emit order, not nested
+	int cache_group_count;
+	int cache_group_capacity;
+	UI_RectI *clip_rects;          // Referenced by UI_Text::clip (rects are clipped at emit)
+	int clip_count;
+	int clip_capacity;
 };
 
-typedef int32_t UI_Id;
-
-struct UI_RectI { int x, y, w, h; };
+void UI_Render_List_Reset(UI_Render_List *list);
+void UI_Render_List_Free(UI_Render_List *list);
+int UI_Render_List_Copy(UI_Render_List *dst, const UI_Render_List *src);
 
-typedef UI_RectI (*UI_Text_Measure_Func)(const char *text, int font_size);
+typedef UI_RectI (*UI_Text_Measure_Func)(const char *text, int font_size, int font_style);
 
 // UI_Style - Layout and visual properties for a panel
 // Flexbox-inspired layout system with explicit size constraints
 struct UI_Style {
     uint32_t color;
-	int min_w, max_w;
+	int min_w, max_w;           // Layout clamps the size to [min, max] (min wins)
     int min_h, max_h;
     int pref_w, pref_h;         // Preferred size (-1=auto, -2=flex-grow, >=0=fixed pixels)
     int pad_l, pad_t, pad_r, pad_b;  // Padding (inner spacing)
     float flex_grow;            // Flex-grow factor (0=no grow, 1.0=grow proportionally)
-    float flex_shrink;          // Flex-shrink factor (unused currently, reserved for future)
-    int flex_basis;             // Flex-basis (unused currently, reserved for future)
+    float flex_shrink;          // Flex-shrink factor when children overflow (weighted by base size)
+    int flex_basis;             // Main-axis base size before grow/shrink (-1 = pref/content)
     int direction;              // Layout direction: 0=row (horizontal), 1=column (vertical)
     int gap;                    // Space between child panels
 	int resizable;              // 0 = not resizable, 1 = resizable
 	int resize_hitbox_padding;  // Extra pixels around divider for hitbox
+	int cache_bitmap;           // 1 = subtree may be drawn from a cached bitmap (static content)
+	int clip_children;          // 1 = descendants are clipped to this panel's rect (drawing and hit tests)
+	int scroll_y;               // Column content offset in pixels (scrolled lists)
+	int content_w, content_h;   // Intrinsic content size (label text; 0 = from children)
 };
 
-// UI_Panel - A rectangular container in the panel tree
+// UI_Panel - A rectangular container in the panel tree (hot data: links + rect)
 // Tree structure: parent -> first_child -> next_sibling -> ...
 // Layout is calculated top-down based on parent's direction and child constraints
+// Style, label and AUTO content data live in parallel arrays (UI_State::styles / cold /
+// content, same index), so sibling walks in the layout passes touch 44 bytes per panel.
 struct UI_Panel {
     UI_Id id;
-    UI_Style style;
     int parent;
     int first_child;
 	int last_child;
     int next_sibling;
     UI_RectI rect;
-	
-	// Label metadata (if this panel is a label)
-	char label_text[MAX_UI_TEXT_LENGTH];
+	uint32_t subtree_hash;  // Layout inputs of this panel and its descendants (set by UI_End_Panel)
+	int subtree_size;       // Panels in this subtree including itself (pre-order contiguous)
+};
+
+// UI_Panel_Content - AUTO content size of a panel, only read for AUTO-sized children
+// Style content, else the children's sizes plus gaps and padding (resolved on first use
+// by each layout pass).
+struct UI_Panel_Content {
+	int w, h;
+	uint32_t pass;          // UI_State::layout_pass that resolved w/h (0 = never)
+};
+
+// UI_Panel_Cold - Per-panel data only read when emitting or hit-testing
+struct UI_Panel_Cold {
+	const char *label_text;  // Owned by UI_State::frame_arena (valid until next UI_Begin_Frame)
 	uint32_t label_color;
-	int label_font_style;  // 0=default, 1=monospace
+	int label_font_style;  // UI_FONT_* bits
 	int is_label;
+	
+	// UI_Graph bars (values owned by UI_State::frame_arena, not kept by retained blocks)
+	const float *graph_values;
+	int graph_count;
+	float graph_max;
+	uint32_t graph_color;
+};
+
+// Panel ID -> index slot (valid only when generation matches UI_State::id_index_generation)
+struct UI_Panel_Index_Slot {
+	UI_Id id;
+	int panel_idx;
+	uint32_t generation;
+};
+
+// UI_Layout_Cache - Previous frame's layout, keyed by panel ID
+// A subtree whose hash and incoming rect both match last frame copies last frame's
+// descendant rects instead of being laid out again.
+struct UI_Layout_Cache {
+	UI_RectI *prev_rects;
+	uint32_t *prev_hashes;
+	int prev_count;
+	int prev_capacity;
+	UI_Panel_Index_Slot *prev_index;   // Copy of last frame's UI_State::id_index
+	int prev_index_capacity;
+	uint32_t prev_index_generation;
+	int valid;
+	int disabled;                      // 1 = always lay out everything (benchmarks)
+	
+	// Statistics (last layout)
+	int subtree_hits;      // Subtrees reused
+	int panels_reused;     // Descendant rects copied from the previous frame
+	int panels_laid_out;   // Containers laid out normally
+	int parallel_tasks;    // Sibling runs forked onto UI_State::layout_pool
 };
 
+struct Task_Pool;  // task_pool.h
+
+// UI_State - Per-frame panel tree
+// Panels are stored as three parallel arrays indexed by panel index (indices stay O(1)
+// and pre-order subtrees stay contiguous); they grow together on demand and keep their
+// storage across frames. Label strings go into frame_arena. Both reset in O(1) at
+// UI_Begin_Frame. Zero-initialized = empty.
 struct UI_State {
-    UI_Panel panels[UI_MAX_PANELS];
+    UI_Panel *panels;         // Tree links + rect (layout hot path)
+	UI_Style *styles;         // Layout/visual style
+	UI_Panel_Cold *cold;      // Label data
+	UI_Panel_Content *content;  // AUTO content sizes (layout scratch)
     int panel_count;
+	int panel_capacity;
+	int panel_high_water;     // Most panels built in any frame
+	UI_Arena frame_arena;     // Label strings (frame lifetime)
+	
+	// ID -> panel index (open addressing, filled by UI_New_Panel, cleared by generation)
+	UI_Panel_Index_Slot *id_index;
+	int id_index_capacity;    // Power of two, kept >= 2x panel_count
+	uint32_t id_index_generation;
+	
+	UI_Layout_Cache layout_cache;
+	int panels_hashed;        // Panels whose subtree_hash/size UI_End_Panel set since the last reset
+	int panels_sized;         // Panels whose subtree_size is set (hashed, or sized with the cache disabled)
+	uint32_t layout_pass;     // Bumped by every UI_Layout_Panel_Tree (content size memo)
+	uint32_t rects_generation;  // Bumped whenever layout or a snapshot load changes rects (hit grid)
+	
+	// Optional parallel layout (NULL = serial): containers with at least
+	// UI_PARALLEL_LAYOUT_MIN_PANELS panels lay out runs of child subtrees as pool tasks
+	Task_Pool *layout_pool;
+	
+	int panels_culled;        // Panels skipped by UI_Emit_Panels (outside window or clip)
 };
 
+void UI_State_Free(UI_State *s);
+int UI_Find_Panel_By_Id(UI_State *s, UI_Id id);
+
+// Key state: one bit per key in a compact context, else one int per key
+#ifdef UI_COMPACT_CONTEXT
+typedef uint32_t UI_Key_State[UI_KEY_COUNT / 32];
+#else
+typedef int UI_Key_State[UI_KEY_COUNT];
+#endif
+
 // Input state structure
 struct UI_Input {
 	// Mouse state
@@ -176,10 +419,10 @@ struct UI_Input {
 	
 	float mouse_wheel_delta;
 	
-	// Keyboard state
-	int key_down[UI_KEY_COUNT];
-	int key_pressed[UI_KEY_COUNT];
-	int key_released[UI_KEY_COUNT];
+	// Keyboard state (read through UI_Is_Key_Down/Pressed/Released)
+	UI_Key_State key_down;
+	UI_Key_State key_pressed;
+	UI_Key_State key_released;
 	
 	// Character input
 	char char_buffer[UI_MAX_CHAR_BUFFER];
@@ -192,6 +435,44 @@ struct UI_Input {
 	int alt;
 };
 
+enum UI_Input_Event_Type {
+	UI_INPUT_EVENT_MOUSE_MOVE,    // a = x, b = y
+	UI_INPUT_EVENT_MOUSE_BUTTON,  // a = UI_Mouse_Button, b = down
+	UI_INPUT_EVENT_MOUSE_WHEEL,   // wheel = notches
+	UI_INPUT_EVENT_KEY,           // a = virtual key code, b = down
+	UI_INPUT_EVENT_CHAR           // a = character
+};
+
+struct UI_Input_Event {
+	int type;                     // UI_Input_Event_Type
+	int a, b;
+	float wheel;
+	int64_t time;                 // UI_Input_Queue::clock ticks when pushed (0 without a clock)
+};
+
+// Single-producer/single-consumer ring of timestamped input events
+// UI_Input_Process* push (the window procedure's thread), UI_Input_NewFrame drains (the
+// thread building the frame). Consecutive mouse moves collapse to the last position; a
+// second transition of the same button or key ends the drain, so every press and release
+// is seen by exactly one frame even when both land between two frames.
+struct UI_Input_Queue {
+	UI_Input_Event events[UI_INPUT_QUEUE_CAPACITY];
+	volatile uint32_t head;       // Next slot written (producer only)
+	volatile uint32_t tail;       // Next slot read (consumer only)
+	
+	int64_t (*clock)(void);       // Timestamp source (set by application; NULL = no ages)
+	int64_t clock_frequency;      // Clock ticks per second
+	
+	// Statistics
+	float oldest_age_ms;          // Age of the oldest undrained event at the last frame start
+	int drained;                  // Events applied by the last UI_Input_NewFrame
+	int moves_coalesced;          // Mouse moves collapsed by the last UI_Input_NewFrame
+	int deferred;                 // Events left for the next frame by the last UI_Input_NewFrame
+	volatile uint32_t dropped;    // Events lost to a full queue (since init)
+};
+
+uint32_t UI_Input_Queue_Pending(UI_Input_Queue *q);  // Events not yet drained
+
 // Widget interaction state - Tracks hot/active/focused widgets
 // Hot: Widget under mouse cursor (hover state)
 // Active: Widget being clicked/dragged (pressed state)
@@ -219,6 +500,179 @@ struct UI_Size_Override {
 	int pref_h;
 };
 
+// List scroll state, persistent across frame rebuilds like UI_Size_Override
+// The viewport is last frame's list rect (known only after layout, see UI_Update_Interaction).
+struct UI_List_State {
+	UI_Id list_id;           // 0 = empty slot
+	int scroll_y;            // Pixels scrolled from the first row
+	UI_RectI rect;           // List panel rect from the last layout (w = 0: not laid out yet)
+	int view_h;              // Content box height from the last layout
+	int last_frame;          // Frame the list was last built
+};
+
+struct UI_List_Scope {
+	UI_Id list_id;
+	int row;                 // Current row (-1 before the first UI_List_Row)
+	int row_end;             // One past the last visible row
+	int row_height;
+	int row_open;            // A row panel and its ID scope are open
+};
+
+// UI_Hit_Grid - Uniform grid over hit-testable panel rects (built after layout)
+// Each cell lists (ascending) the panels whose hitbox overlaps it; dividers use their
+// rect expanded by resize_hitbox_padding. Rebuilt only when UI_State::rects_generation
+// or the screen size changes, so query after UI_Layout_Panel_Tree.
+struct UI_Hit_Grid {
+	int *cell_start;        // cells_x*cells_y + 1 offsets into entries
+	int *cell_fill;         // Build scratch (per-cell write cursor)
+	int *entries;           // Panel indices
+	int cell_capacity;
+	int fill_capacity;
+	int entry_capacity;
+	int cells_x, cells_y;
+	int panel_end;          // Panels [0, panel_end) are the root's subtree
+	uint32_t rects_generation;  // UI_State::rects_generation the grid was built from
+	int screen_w, screen_h;
+	int valid;
+	
+	// Quick reject (mouse and layout unchanged -> reuse last result)
+	int last_mouse_x, last_mouse_y;
+	UI_Id last_hot;
+	
+	// Statistics
+	int rebuilds;
+	int queries;
+	int quick_rejects;
+};
+
+// Retained block (UI_Begin_Cached) - recorded panels of a static subtree
+// Links are rebuilt on replay from parent_rel, so only styles and labels are stored.
+struct UI_Retained_Panel {
+	UI_Id id;
+	int parent_rel;          // Parent offset within the block, -1 = child of the enclosing panel
+	int label_offset;        // Offset into the block's strings, -1 = no label text
+	UI_Style style;
+	UI_Panel_Cold cold;      // label_text unused here (see label_offset)
+};
+
+struct UI_Retained_Block {
+	UI_Id id;                // Scope ID of the block
+	uint32_t version;
+	int valid;
+	int last_used_frame;
+	UI_Retained_Panel *panels;
+	int panel_count;
+	int panel_capacity;
+	char *strings;
+	int string_size;
+	int string_capacity;
+};
+
+struct UI_Cached_Scope {
+	int block;               // Index into retained_blocks, -1 = not cached (table full)
+	int start;               // First panel index of the block this frame
+	int parent_depth;        // parent_stack_count at UI_Begin_Cached
+	int replaying;
+	int pushed_id;           // The block ID went onto the ID scope stack (it was not full)
+};
+
+// ID dedup slot (valid only when generation matches UI_Context::id_generation)
+struct UI_Id_Slot {
+	UI_Id id;
+	int count;              // Duplicates seen so far this frame
+	uint32_t generation;
+};
+
+// Cached intrinsic size of a label, valid while the panel ID, the text length and the
+// content hash (FNV-1a of text, font size and style) match; direct-mapped by ID,
+// collisions just re-measure
+struct UI_Intrinsic_Slot {
+	UI_Id id;
+	uint32_t content_hash;
+	int length;
+	int w, h;
+};
+
+// Frame statistics - fixed ring of per-frame samples filled by the application
+// (UI_Frame_Stats_Push) and read back as percentiles (UI_Frame_Stats_Summarize),
+// as raw samples for telemetry (UI_Frame_Stats_Copy) or as an overlay graph.
+enum UI_Frame_Phase {
+	UI_PHASE_BUILD = 0,      // UI_Begin_Frame + tree construction
+	UI_PHASE_LAYOUT,
+	UI_PHASE_INTERACTION,
+	UI_PHASE_EMIT,
+	UI_PHASE_DRAW,           // Application drawing and present
+	UI_PHASE_COUNT
+};
+
+struct UI_Frame_Sample {
+	float frame_ms;                  // Time since the previous frame
+	float cpu_ms;                    // Sum of phase_ms (work to produce this frame)
+	float phase_ms[UI_PHASE_COUNT];
+	int panels;
+	int rectangles;
+	int texts;
+	int measure_hits;                // Text measurement cache lookups this frame
+	int measure_misses;
+};
+
+struct UI_Frame_Stats {
+#ifdef UI_COMPACT_CONTEXT
+	UI_Frame_Sample *samples;        // UI_FRAME_STATS_HISTORY, allocated by the first push
+#else
+	UI_Frame_Sample samples[UI_FRAME_STATS_HISTORY];
+#endif
+	int next;                        // Slot of the next sample
+	int count;                       // Valid samples (<= UI_FRAME_STATS_HISTORY)
+	int overlay_visible;             // Show UI_Frame_Stats_Overlay (toggled by the application)
+};
+
+struct UI_Frame_Stats_Summary {
+	int frames;
+	float frame_p50_ms, frame_p99_ms, frame_max_ms;
+	float cpu_p50_ms, cpu_p99_ms, cpu_max_ms;
+	float phase_avg_ms[UI_PHASE_COUNT];
+	float avg_panels, avg_rectangles, avg_texts;
+	float measure_hit_rate;          // Hits / lookups over the window (1 with no lookups)
+};
+
+// Interned strings: one stable copy per distinct string, kept until UI_Context_Free
+struct UI_String_Slot {
+	uint32_t hash;
+	const char *str;           // NULL = empty slot
+};
+
+struct UI_String_Table {
+	UI_String_Slot *slots;     // Open addressing, kept at most half full
+	int count;
+	int capacity;              // Power of two
+	size_t string_bytes;       // Heap held by the copies (one allocation per string)
+};
+
+// Memory footprint per subsystem (UI_Memory_Stats_Get); bytes held, inline and on the heap
+enum UI_Memory_Subsystem {
+	UI_MEMORY_CONTEXT = 0,     // UI_Context fields not counted below (stacks, interaction, ...)
+	UI_MEMORY_PANELS,          // Panel, style and cold arrays, panel ID index
+	UI_MEMORY_FRAME_ARENA,     // Label strings and graph values (pages held)
+	UI_MEMORY_LAYOUT_CACHE,    // Previous frame's rects, hashes and ID index
+	UI_MEMORY_IDS,             // ID dedup table
+	UI_MEMORY_INPUT,           // input, input_prev and the input queue
+	UI_MEMORY_HIT_GRID,
+	UI_MEMORY_RETAINED,        // UI_Begin_Cached blocks
+	UI_MEMORY_PERSISTENT,      // Size overrides and list states
+	UI_MEMORY_INTRINSIC,       // Label size cache
+	UI_MEMORY_STRINGS,         // Interned strings
+	UI_MEMORY_FRAME_STATS,
+	UI_MEMORY_COUNT
+};
+
+struct UI_Memory_Stats {
+	size_t current[UI_MEMORY_COUNT];
+	size_t peak[UI_MEMORY_COUNT];   // Largest current seen at a frame start or report
+	size_t total;
+	size_t total_peak;
+};
+
 struct UI_Context {
 	int screen_w;
 	int screen_h;
@@ -229,28 +683,84 @@ struct UI_Context {
 	int parent_stack_count;
 	UI_Text_Measure_Func measure_text;
 	
-	// ID deduplication
-	UI_Id used_ids[UI_MAX_USED_IDS];
-	int used_id_counts[UI_MAX_USED_IDS];
+	// ID deduplication (open-addressing set, cleared each frame by bumping id_generation)
+#ifdef UI_COMPACT_CONTEXT
+	UI_Id_Slot *id_table;       // Doubles up to UI_ID_TABLE_SIZE, kept at most half full
+	int id_table_capacity;
+#else
+	UI_Id_Slot id_table[UI_ID_TABLE_SIZE];
+#endif
+	uint32_t id_generation;
 	int used_id_count;
 	
+	// ID scopes (UI_Push_Id/UI_Pop_Id); IDs are hashed with the innermost scope as seed
+	UI_Id id_scope_stack[UI_MAX_ID_SCOPE_DEPTH];
+	int id_scope_count;
+	
+	// Retained blocks (UI_Begin_Cached / UI_End_Cached)
+	UI_Retained_Block retained_blocks[UI_MAX_RETAINED_BLOCKS];
+	int retained_block_count;
+	UI_Cached_Scope cached_stack[UI_MAX_CACHED_DEPTH];
+	int cached_depth;
+	int cached_overflow;       // UI_Begin_Cached calls past UI_MAX_CACHED_DEPTH (pushed nothing)
+	int retained_hits;         // Blocks replayed this frame
+	int retained_misses;       // Blocks (re)built this frame
+	
 	// Input state
 	UI_Input input;
 	UI_Input input_prev;
+	UI_Input_Queue input_queue;    // Filled by UI_Input_Process*, drained by UI_Input_NewFrame
 	UI_Interaction interaction;
+	UI_Hit_Grid hit_grid;
 	
 	// Size overrides (persist across frame rebuilds)
-	UI_Size_Override size_overrides[UI_MAX_SIZE_OVERRIDES];
+	// Open-addressing table keyed by panel_id (0 = empty slot), grows on demand
+	UI_Size_Override *size_overrides;
 	int size_override_count;
+	int size_override_capacity;
+	
+	// Virtualized lists (scroll state persists across frame rebuilds, same table scheme)
+	UI_List_State *list_states;
+	int list_state_count;
+	int list_state_capacity;
+	UI_List_Scope list_stack[UI_MAX_LIST_DEPTH];
+	int list_depth;
+	
+	// Label text sizes (measured once per panel and content, see UI_Intrinsic_Cache_Clear)
+#ifdef UI_COMPACT_CONTEXT
+	UI_Intrinsic_Slot *intrinsic_cache;  // Doubles up to UI_INTRINSIC_CACHE_CAPACITY (2x panels)
+	int intrinsic_capacity;
+#else
+	UI_Intrinsic_Slot intrinsic_cache[UI_INTRINSIC_CACHE_CAPACITY];
+#endif
+	int intrinsic_hits;         // Label sizes reused this frame
+	int intrinsic_misses;       // Label sizes measured this frame
 	
 	// Debug/diagnostic tracking
 	int frame_number;
 	float delta_time_ms;
 	int current_fps;
+	float frame_jitter_ms;      // Frame time standard deviation (set by application)
+	float input_latency_ms;     // Average input-to-present latency (set by application)
+	UI_Frame_Stats frame_stats; // Per-frame timings and counts (pushed by application)
+#ifdef UI_COMPACT_CONTEXT
+	const char *last_button_clicked;  // Interned (NULL = none)
+#else
 	char last_button_clicked[MAX_UI_TEXT_LENGTH];
+#endif
+	
+	UI_String_Table interned;
+	size_t memory_peak[UI_MEMORY_COUNT];  // See UI_Memory_Stats::peak
+	size_t memory_total_peak;
 };
 
 // Frame management
+void UI_Context_Free(UI_Context *ui);   // Releases heap storage (panels, arenas, overrides)
+void UI_Intrinsic_Cache_Clear(UI_Context *ui);  // Re-measure labels (fonts or DPI changed)
+const char *UI_Intern_String(UI_Context *ui, const char *str);  // Stable copy, NULL if out of memory
+void UI_Memory_Stats_Get(UI_Context *ui, UI_Memory_Stats *out);
+const char *UI_Memory_Subsystem_Name(int subsystem);
+size_t UI_Render_List_Bytes(const UI_Render_List *list);  // Heap held by a render list
 void UI_Begin_Frame(UI_Context *ui, UI_Render_List *out_list, int w, int h);
 void UI_Begin_Frame_With_Time(UI_Context *ui, UI_Render_List *out_list, int w, int h, float delta_time_ms);
 
@@ -262,6 +772,195 @@ void UI_Begin_Panel_With_Id(UI_Context *ui, UI_Id id, const char *debug_name);
 void UI_Begin_Panel_Ex(UI_Context *ui, const char *id, UI_Panel_Style *style);
 void UI_End_Panel(UI_Context *ui);
 
+// ID scopes - labels inside a scope hash differently from the same labels elsewhere
+void UI_Push_Id(UI_Context *ui, const char *str);
+void UI_Push_Id_Int(UI_Context *ui, int index);
+void UI_Pop_Id(UI_Context *ui);
+
+// Retained blocks - skip building static content that has not changed
+// Returns 1 if the contents must be built now (first use, or version changed), 0 if the
+// previous build was replayed. Always pair with UI_End_Cached. Contents are ID-scoped by id.
+// Only for content that does not depend on per-frame state (hover, resizing, ...).
+//   if (UI_Begin_Cached(ui, "props", props_version)) { UI_Label(...); ... }
+//   UI_End_Cached(ui);
+int UI_Begin_Cached(UI_Context *ui, const char *id, uint32_t version);
+void UI_End_Cached(UI_Context *ui);
+
+// Static layouts - the fixed part of a panel tree described at compile time
+// A layout is a constexpr pre-order array: each entry has its depth (0 = outermost), a
+// djb2 ID hashed by the compiler and a fully resolved style. UI_Build_Static walks it
+// with no string hashing or setter calls; UI_STATIC_SLOT entries call back for the
+// dynamic content at that position (under the enclosing panel). Panel IDs equal what
+// UI_Begin_Panel would generate for the same names at the root ID scope, so size
+// overrides and dividers behave the same; they are claimed in the dedup table first, so
+// dynamic widgets with the same label get derived IDs.
+//   static constexpr UI_Static_Panel layout[] = {
+//       UI_Static_Box(0, "root", UI_DIRECTION_COLUMN, -1, -1, 8, 0, 0xFF111115),
+//       UI_Static_Resizable(1, "left", UI_DIRECTION_COLUMN, 240, -1, 12, 8, 0xFF22222A),
+//       UI_Static_Slot(2, SLOT_LEFT),
+//   };
+//   static_assert(UI_Static_Layout_Valid(layout), "bad layout");
+//   UI_Build_Static(ui, layout, Fill_Slot, user);
+enum UI_Static_Kind {
+	UI_STATIC_BOX,        // UI_BeginPanel
+	UI_STATIC_RESIZABLE,  // UI_Panel_Resizable (size overrides applied at build time)
+	UI_STATIC_DIVIDER,    // UI_Divider (no children)
+	UI_STATIC_SLOT        // Dynamic content callback (no panel)
+};
+
+struct UI_Static_Panel {
+	int kind;             // UI_Static_Kind
+	int depth;
+	UI_Id id;
+	const char *name;
+	UI_Style style;
+	int default_w, default_h;  // UI_STATIC_RESIZABLE sizes before overrides
+	int slot;                  // UI_STATIC_SLOT index passed to the fill callback
+};
+
+typedef void UI_Static_Fill_Func(UI_Context *ui, int slot, void *user);
+
+// djb2 matching UI_HashString (bytes hashed unsigned, 32-bit wraparound)
+constexpr uint32_t
+UI_Hash_Const(const char *str, uint32_t hash = 5381)
+{
+	return *str ? UI_Hash_Const(str + 1, hash * 33u + (unsigned char)*str) : hash;
+}
+
+// UI_STATIC_ID("name") - the runtime UI_Begin_Panel ID of a root-scope name, as a constant
+template <uint32_t Hash>
+struct UI_Const_Id {
+	static const UI_Id value = (UI_Id)Hash;
+};
+#define UI_STATIC_ID(str) (UI_Const_Id<UI_Hash_Const(str)>::value)
+
+// Style as UI_New_Panel initializes it (keep the two in step): fields not assigned here
+// are zero. A field added to UI_Style fails this assert until both places are checked.
+static_assert(sizeof(UI_Style) == 23 * 4, "UI_Style changed: update UI_Style_Initial and UI_New_Panel");
+
+constexpr UI_Style
+UI_Style_Initial()
+{
+	UI_Style s{};
+	s.color = 0xFF222222u;
+	s.max_w = INT32_MAX;
+	s.max_h = INT32_MAX;
+	s.pref_w = -1;
+	s.pref_h = -1;
+	s.flex_shrink = 1.0f;
+	s.flex_basis = -1;
+	s.direction = UI_DIRECTION_ROW;
+	s.resize_hitbox_padding = 4;
+	return s;
+}
+
+// UI_Style_Initial plus the helper's settings
+constexpr UI_Style
+UI_Static_Style(int direction, int pref_w, int pref_h, int padding, int gap, uint32_t color, float grow)
+{
+	UI_Style s = UI_Style_Initial();
+	if (color) s.color = color;
+	s.pref_w = pref_w;
+	s.pref_h = pref_h;
+	if (padding > 0) s.pad_l = s.pad_t = s.pad_r = s.pad_b = padding;
+	s.flex_grow = grow;
+	s.direction = direction;
+	if (gap >= 0) s.gap = gap;
+	return s;
+}
+
+// As UI_Divider_Ex with its default color and hitbox padding
+constexpr UI_Style
+UI_Static_Divider_Style(int orientation)
+{
+	UI_Style s = UI_Style_Initial();
+	s.color = 0x33FFFFFFu;
+	s.pref_w = (orientation == UI_DIVIDER_VERTICAL) ? 1 : -1;
+	s.pref_h = (orientation == UI_DIVIDER_VERTICAL) ? -1 : 1;
+	s.flex_shrink = 0.0f;
+	s.resizable = 1;
+	return s;
+}
+
+constexpr UI_Static_Panel
+UI_Static_Box(int depth, const char *name, int direction, int w, int h,
+              int padding, int gap, uint32_t color, float grow = 0.0f)
+{
+	return UI_Static_Panel{
+		UI_STATIC_BOX, depth, (UI_Id)UI_Hash_Const(name), name,
+		UI_Static_Style(direction, (w >= 0 || h >= 0) ? w : -1, (w >= 0 || h >= 0) ? h : -1,
+		                padding, gap, color, grow),
+		w, h, -1
+	};
+}
+
+constexpr UI_Static_Panel
+UI_Static_Resizable(int depth, const char *name, int direction, int default_w, int default_h,
+                    int padding, int gap, uint32_t color)
+{
+	return UI_Static_Panel{
+		UI_STATIC_RESIZABLE, depth, (UI_Id)UI_Hash_Const(name), name,
+		UI_Static_Style(direction, -1, -1, padding, gap, color, 0.0f),
+		default_w, default_h, -1
+	};
+}
+
+constexpr UI_Static_Panel
+UI_Static_Divider(int depth, const char *name, int orientation)
+{
+	return UI_Static_Panel{
+		UI_STATIC_DIVIDER, depth, (UI_Id)UI_Hash_Const(name), name,
+		UI_Static_Divider_Style(orientation),
+		-1, -1, -1
+	};
+}
+
+constexpr UI_Static_Panel
+UI_Static_Slot(int depth, int slot)
+{
+	return UI_Static_Panel{ UI_STATIC_SLOT, depth, 0, "", UI_Style{}, -1, -1, slot };
+}
+
+// Pre-order depths (each entry at most one deeper than the previous, only under a box or
+// resizable panel, single outermost panel first) and no repeated panel IDs
+template <int N>
+constexpr int
+UI_Static_Layout_Valid(const UI_Static_Panel (&layout)[N])
+{
+	if (layout[0].depth != 0 || layout[0].kind == UI_STATIC_SLOT) return 0;
+	for (int i = 1; i < N; i++) {
+		const UI_Static_Panel &prev = layout[i - 1];
+		if (layout[i].depth < 1 || layout[i].depth > prev.depth + 1) return 0;
+		if (layout[i].depth == prev.depth + 1 && (prev.kind == UI_STATIC_DIVIDER || prev.kind == UI_STATIC_SLOT)) return 0;
+		if (layout[i].kind == UI_STATIC_SLOT) continue;
+		for (int k = 0; k < i; k++) {
+			if (layout[k].kind != UI_STATIC_SLOT && layout[k].id == layout[i].id) return 0;
+		}
+	}
+	return 1;
+}
+
+void UI_Build_Static(UI_Context *ui, const UI_Static_Panel *layout, int count, UI_Static_Fill_Func *fill, void *user);
+
+template <int N>
+inline void
+UI_Build_Static(UI_Context *ui, const UI_Static_Panel (&layout)[N], UI_Static_Fill_Func *fill, void *user)
+{
+	UI_Build_Static(ui, layout, N, fill, user);
+}
+
+// Virtualized list - only rows intersecting the viewport get panels
+// Rows have a fixed height (the layout has no content-based sizing). Scrolls with the mouse
+// wheel while hovered; children are clipped to the list rect. The list panel is current
+// after UI_Begin_List (style setters apply to it, default: flex-grow column).
+//   UI_Begin_List(ui, "log", line_count, 18);
+//   int row;
+//   while (UI_List_Row(ui, &row)) UI_Label(ui, lines[row], 0xFFCCCCCC);  // Row is ID-scoped
+//   UI_End_List(ui);
+void UI_Begin_List(UI_Context *ui, const char *id, int row_count, int row_height);
+int UI_List_Row(UI_Context *ui, int *out_row);
+void UI_End_List(UI_Context *ui);
+
 // Panel style setters (operate on current panel)
 void UI_Panel_Set_Color(UI_Context *ui, uint32_t color);
 void UI_Panel_Set_Size(UI_Context *ui, int width, int height);
@@ -270,7 +969,14 @@ void UI_Panel_Set_Padding_Uniform(UI_Context *ui, int padding);
 void UI_Panel_Set_Direction(UI_Context *ui, UI_Direction dir);
 void UI_Panel_Set_Gap(UI_Context *ui, int gap);
 void UI_Panel_Set_Grow(UI_Context *ui, float grow);
+void UI_Panel_Set_Shrink(UI_Context *ui, float shrink);   // 0 = keep the base size on overflow
+void UI_Panel_Set_Basis(UI_Context *ui, int basis);       // Main-axis base size, -1 = pref/content
+void UI_Panel_Set_Min_Size(UI_Context *ui, int min_w, int min_h);
+void UI_Panel_Set_Max_Size(UI_Context *ui, int max_w, int max_h);  // INT32_MAX = unbounded
+void UI_Panel_Set_Content_Size(UI_Context *ui, int w, int h);      // Intrinsic size for AUTO
 void UI_Panel_Set_Resizable(UI_Context *ui, int resizable, int hitbox_padding);
+void UI_Panel_Set_Cache_Bitmap(UI_Context *ui, int enabled);
+void UI_Panel_Set_Clip(UI_Context *ui, int enabled);
 
 // Compact panel creation helpers
 void UI_BeginPanel(UI_Context *ui, const char *id, int direction, int w, int h, 
@@ -285,7 +991,9 @@ void UI_Divider_Ex(UI_Context *ui, const char *id, int orientation, uint32_t col
 // Widgets
 void UI_Label(UI_Context *ui, const char *text, uint32_t color);
 void UI_Label_Monospace(UI_Context *ui, const char *text, uint32_t color);
+void UI_Label_Styled(UI_Context *ui, const char *text, uint32_t color, int font_style);  // UI_FONT_* bits
 int UI_Button(UI_Context *ui, const char *text);
+void UI_Graph(UI_Context *ui, const char *id, const float *values, int count, float max_value, uint32_t color);
 
 // Input system
 void UI_Input_Init(UI_Input *input);
@@ -324,8 +1032,83 @@ void UI_Set_Size_Override(UI_Context *ui, UI_Id panel_id, int pref_w, int pref_h
 int UI_Get_Size_Override_W(UI_Context *ui, UI_Id panel_id);
 int UI_Get_Size_Override_H(UI_Context *ui, UI_Id panel_id);
 
+// Snapshots - one binary blob with the last built panels, the size overrides, list scroll
+// state and the application's text measurements
+// UI_Snapshot_Header, then sections (UI_Snapshot_Section + payload, padded to 8 bytes).
+// Panels and styles are stored as raw structs, so a snapshot only loads into a build with
+// the same version and struct sizes (checked by UI_Snapshot_Validate). The application
+// maps the snapshot saved on exit for a warm first frame; frame_benchmark replays one.
+#define UI_SNAPSHOT_MAGIC 0x50414E53u       // "SNAP"
+#define UI_SNAPSHOT_VERSION 4
+#define UI_SNAPSHOT_PANELS 0x4C4E4150u      // "PANL": count, strings size, UI_Panel[], UI_Style[], UI_Snapshot_Label[], strings
+#define UI_SNAPSHOT_OVERRIDES 0x4452564Fu   // "OVRD": count, UI_Size_Override[]
+#define UI_SNAPSHOT_LISTS 0x5453494Cu       // "LIST": count, UI_List_State[]
+#define UI_SNAPSHOT_MEASURES 0x5341454Du    // "MEAS": count, strings size, UI_Snapshot_Measure[], strings
+
+struct UI_Snapshot_Header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;             // Whole snapshot in bytes
+	uint32_t section_count;
+	uint32_t panel_size;       // sizeof(UI_Panel) of the writer
+	uint32_t style_size;       // sizeof(UI_Style) of the writer
+	uint32_t app_key;          // Application's measurement environment (fonts, DPI)
+	int32_t screen_w, screen_h;
+	uint32_t reserved;
+};
+
+struct UI_Snapshot_Section {
+	uint32_t tag;              // UI_SNAPSHOT_*
+	uint32_t size;             // Payload bytes (excluding padding)
+};
+
+struct UI_Snapshot_Label {
+	int32_t text_offset;       // Into the strings block (-1 = no text)
+	uint32_t color;
+	int32_t font_style;
+	int32_t is_label;
+};
+
+// One cached measurement (the application's cache key plus its result); the texts follow
+// the records in the same order, each length bytes plus a NUL
+struct UI_Snapshot_Measure {
+	UI_Id hash;                // UI_HashString of the text
+	int32_t length;
+	int32_t font_size;
+	int32_t font_style;
+	UI_RectI size;
+};
+
+// Write a snapshot of ui->state (last built frame) into dst; returns bytes written, or the
+// bytes needed when dst is NULL or capacity is too small (nothing written then).
+// measure_texts[i] is the text of measures[i] (measures[i].length bytes).
+int UI_Snapshot_Write(UI_Context *ui, uint32_t app_key, const UI_Snapshot_Measure *measures,
+                      const char *const *measure_texts, int measure_count, void *dst, int capacity);
+int UI_Snapshot_Validate(const void *data, int size);  // 1 = header and sections usable by this build
+const void *UI_Snapshot_Find(const void *data, int size, uint32_t tag, int *out_size);  // Section payload or NULL
+// Replace ui->state with the snapshot's panels (labels copied, graphs dropped); 0 if malformed
+int UI_Snapshot_Load_Panels(UI_Context *ui, const void *data, int size);
+// Restore size overrides, list states and panels, and seed the layout cache so the first
+// frame reuses them. Every section is checked first: 0 (nothing applied) if any is malformed
+int UI_Snapshot_Load(UI_Context *ui, const void *data, int size);
+
 // Interaction update
 void UI_Update_Interaction(UI_Context *ui);
 
+// Render list change detection (skip or partially redraw frames that did not change)
+enum UI_Render_List_Change {
+	UI_RENDER_LIST_UNCHANGED = 0,   // Identical primitives
+	UI_RENDER_LIST_PARTIAL = 1,     // Same primitive counts, out_dirty covers every change
+	UI_RENDER_LIST_CHANGED = 2      // Primitives added/removed, redraw everything
+};
+uint32_t UI_Render_List_Hash(const UI_Render_List *list);
+int UI_Render_List_Diff(const UI_Render_List *prev, const UI_Render_List *cur, UI_RectI *out_dirty);
+
 // Debug overlay
 void UI_Debug_Mouse_Overlay(UI_Context *ui);
+
+// Frame statistics (ring buffer, percentiles, export, overlay)
+void UI_Frame_Stats_Push(UI_Frame_Stats *stats, const UI_Frame_Sample *sample);
+int UI_Frame_Stats_Copy(const UI_Frame_Stats *stats, UI_Frame_Sample *out, int max_samples);  // Oldest first
+void UI_Frame_Stats_Summarize(const UI_Frame_Stats *stats, UI_Frame_Stats_Summary *out);
+void UI_Frame_Stats_Overlay(UI_Context *ui);